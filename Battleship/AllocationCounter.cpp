@@ -0,0 +1,88 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#ifdef COUNT_ALLOCATIONS
+
+static thread_local unsigned long long t_allocations = 0;
+
+bool countingAllocations()
+{
+	return true;
+}
+
+unsigned long long allocationCount()
+{
+	return t_allocations;
+}
+
+void* operator new(size_t size)
+{
+	t_allocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr)
+		throw bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+	t_allocations++;
+	return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+	return operator new(size, nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+	free(p);
+}
+
+#else
+
+bool countingAllocations()
+{
+	return false;
+}
+
+unsigned long long allocationCount()
+{
+	return 0;
+}
+
+#endif // COUNT_ALLOCATIONS
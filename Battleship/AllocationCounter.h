@@ -0,0 +1,9 @@
+#ifndef ALLOCATIONCOUNTER_INCLUDED
+#define ALLOCATIONCOUNTER_INCLUDED
+
+// Builds with COUNT_ALLOCATIONS defined replace the global operator new
+// with one that counts its calls, per thread.  Other builds count nothing.
+bool countingAllocations();
+unsigned long long allocationCount();  //calls made by this thread so far
+
+#endif // ALLOCATIONCOUNTER_INCLUDED
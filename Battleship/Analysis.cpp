@@ -0,0 +1,244 @@
+#include "Analysis.h"
+#include "Game.h"
+#include "Player.h"
+#include "PlayerState.h"
+#include <algorithm>
+#include <atomic>
+#include <istream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+//******************** reading positions ******************************
+
+// Checks what both formats share once the rules and shots are in
+bool checkPosition(const Position& pos, string& error)
+{
+	if (pos.rules.ships.size() > GoodState::MAXSHIPS)
+		error = "too many ships";
+	for (int i = 0; i < pos.rules.ships.size() && error.empty(); i++)
+	{
+		int cell = pos.seen.sinkCell[i];
+		if (cell >= 0 && (cell >= MAXROWS * MAXCOLS || !pos.seen.hit.test(cell)))
+			error = string("ship ") + pos.rules.ships[i].symbol + " was sunk by a shot that didn't hit";
+	}
+	if (error.empty() && (pos.seen.hit.intersects(pos.seen.missed) ||
+		pos.seen.hit.minus(boardCells(pos.rules.rows, pos.rules.cols)).any() ||
+		pos.seen.missed.minus(boardCells(pos.rules.rows, pos.rules.cols)).any()))
+		error = "shots off the board";
+	return error.empty();
+}
+
+bool readPosition(istream& in, Position& pos, string& error)
+{
+	error.clear();
+	string line;
+	while (getline(in, line) && line.find_first_not_of(" \t\r") == string::npos)
+		; //blank lines between positions
+	if (!in)
+		return false;
+
+	string word;
+	if (line.compare(0, 9, "position ") != 0)
+	{
+		error = "expected a position line, not \"" + line + "\"";
+		return false;
+	}
+	if (!pos.rules.parse(line.substr(9), error))
+		return false;
+	pos.seen = FleetObservations(pos.rules.ships.size());
+
+	//sunk ships, then the column labels
+	while (getline(in, line))
+	{
+		istringstream sunk(line);
+		char symbol;
+		Point p;
+		if (!(sunk >> word) || word != "sunk")
+			break;
+		if (!(sunk >> symbol >> p.r >> p.c) || p.r < 0 || p.r >= pos.rules.rows || p.c < 0 || p.c >= pos.rules.cols)
+		{
+			error = "bad sunk line \"" + line + "\"";
+			return false;
+		}
+		int i;
+		for (i = 0; i < pos.rules.ships.size() && pos.rules.ships[i].symbol != symbol; i++)
+			;
+		if (i == pos.rules.ships.size())
+		{
+			error = string("no ship ") + symbol;
+			return false;
+		}
+		pos.seen.sinkCell[i] = CellSet::index(p);
+	}
+	for (int r = 0; r < pos.rules.rows; r++)
+	{
+		if (!getline(in, line) || line.size() < 2 + pos.rules.cols)
+		{
+			error = "row " + to_string(r) + " is missing or short";
+			return false;
+		}
+		for (int c = 0; c < pos.rules.cols; c++)
+		{
+			char ch = line[2 + c];
+			if (ch == 'X')
+				pos.seen.hit.set(Point(r, c));
+			else if (ch == 'o')
+				pos.seen.missed.set(Point(r, c));
+			else if (ch != '.')
+			{
+				error = "row " + to_string(r) + " has a '" + ch + "'";
+				return false;
+			}
+		}
+	}
+	return checkPosition(pos, error);
+}
+
+bool readBinaryPosition(istream& in, Position& pos, string& error)
+{
+	error.clear();
+	unsigned char size[3];
+	if (!in.read(reinterpret_cast<char*>(size), 3))
+		return false;
+	pos.rules.rows = size[0];
+	pos.rules.cols = size[1];
+	pos.rules.ships.clear();
+	if (pos.rules.rows < 1 || pos.rules.rows > MAXROWS || pos.rules.cols < 1 || pos.rules.cols > MAXCOLS)
+	{
+		error = "bad board size";
+		return false;
+	}
+	for (int i = 0; i < size[2]; i++)
+	{
+		unsigned char ship[2];
+		if (!in.read(reinterpret_cast<char*>(ship), 2))
+		{
+			error = "truncated position";
+			return false;
+		}
+		ShipSpec spec = { ship[0], char(ship[1]), string(1, char(ship[1])) };
+		pos.rules.ships.push_back(spec);
+	}
+	pos.seen = FleetObservations(size[2]);
+	unsigned char bytes[32];
+	if (!in.read(reinterpret_cast<char*>(bytes), 32))
+	{
+		error = "truncated position";
+		return false;
+	}
+	CellSet* sets[2] = { &pos.seen.missed, &pos.seen.hit };
+	for (int i = 0; i < 4; i++)
+	{
+		unsigned long long w = 0;
+		for (int b = 7; b >= 0; b--)
+			w = w << 8 | bytes[8 * i + b];
+		sets[i / 2]->w[i % 2] = w;
+	}
+	for (int i = 0; i < size[2]; i++)
+	{
+		unsigned char cell;
+		if (!in.read(reinterpret_cast<char*>(&cell), 1))
+		{
+			error = "truncated position";
+			return false;
+		}
+		pos.seen.sinkCell[i] = (cell == 255 ? -1 : cell);
+	}
+	return checkPosition(pos, error);
+}
+
+//******************** PositionAnalyzer functions *********************
+
+PositionAnalyzer::PositionAnalyzer(const string& type, int nThreads, unsigned int seed)
+	: m_type(type), m_nThreads(nThreads), m_seed(seed), m_done(0)
+{
+	if (m_nThreads <= 0)
+		m_nThreads = max(1, (int)thread::hardware_concurrency());
+	m_games.resize(m_nThreads);
+}
+
+PositionAnalyzer::~PositionAnalyzer()
+{
+	for (int t = 0; t < m_games.size(); t++)
+		for (GameCache::iterator it = m_games[t].begin(); it != m_games[t].end(); it++)
+			delete it->second;
+}
+
+bool PositionAnalyzer::canAnalyze() const
+{
+	//bots expect a whole game, starting with placing their ships
+	if (m_type == "human" || m_type.compare(0, 4, "bot:") == 0)
+		return false;
+	Game g(10, 10);
+	Ruleset::standard().addShipsTo(g);
+	Player* p = createPlayer(m_type, "analyst", g);
+	delete p;
+	return p != nullptr;
+}
+
+void PositionAnalyzer::analyze(const vector<Position>& positions, vector<Analysis>& results)
+{
+	results.resize(positions.size());
+	atomic<int> next(0);
+	auto worker = [&](int t) {
+		for (int i = next++; i < positions.size(); i = next++)
+			analyzeOne(positions[i], m_seed + m_done + i, m_games[t], results[i]);
+	};
+	int nThreads = min(m_nThreads, max(1, (int)positions.size()));
+	if (nThreads == 1)
+		worker(0);
+	else
+	{
+		vector<thread> threads;
+		for (int t = 0; t < nThreads; t++)
+			threads.push_back(thread(worker, t));
+		for (int t = 0; t < nThreads; t++)
+			threads[t].join();
+	}
+	m_done += positions.size();
+}
+
+void PositionAnalyzer::analyzeOne(const Position& pos, unsigned int seed, GameCache& games, Analysis& result) const
+{
+	string key = to_string(pos.rules.rows) + "x" + to_string(pos.rules.cols);
+	for (int i = 0; i < pos.rules.ships.size(); i++)
+		key += " " + to_string(pos.rules.ships[i].length) + pos.rules.ships[i].symbol;
+	Game*& g = games[key];
+	if (g == nullptr)
+	{
+		g = new Game(pos.rules.rows, pos.rules.cols);
+		g->setTranscript(nullptr);
+		pos.rules.addShipsTo(*g);
+	}
+	result.valid = (g->nShips() == pos.rules.ships.size()); //false if a ship didn't fit the rules
+	if (!result.valid)
+		return;
+
+	seedRandom(seed);
+	Player* player = createPlayer(m_type, "analyst", *g);
+	GoodState good;
+	good.start(*g);
+	auto tell = [&](Point p, bool shotHit, bool shipDestroyed, int shipId) {
+		player->recordAttackResult(p, true, shotHit, shipDestroyed, shipId);
+		good.recordAttackResult(*g, p, true, shotHit, shipDestroyed, shipId);
+	};
+	CellSet sinks;
+	for (int i = 0; i < pos.seen.sinkCell.size(); i++)
+		if (pos.seen.sinkCell[i] >= 0)
+			sinks.set(pos.seen.sinkCell[i]);
+	CellSet cells = pos.seen.missed;
+	for (int c = cells.first(); c >= 0; cells.reset(c), c = cells.first())
+		tell(CellSet::point(c), false, false, -1);
+	cells = pos.seen.hit.minus(sinks);
+	for (int c = cells.first(); c >= 0; cells.reset(c), c = cells.first())
+		tell(CellSet::point(c), true, false, -1);
+	for (int i = 0; i < pos.seen.sinkCell.size(); i++)
+		if (pos.seen.sinkCell[i] >= 0)
+			tell(CellSet::point(pos.seen.sinkCell[i]), true, true, i);
+
+	result.shot = player->recommendAttack();
+	good.densityMap(*g, GoodParams(), result.density);
+	delete player;
+}
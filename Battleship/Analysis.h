@@ -0,0 +1,81 @@
+#ifndef ANALYSIS_INCLUDED
+#define ANALYSIS_INCLUDED
+
+#include "globals.h"
+#include "LayoutCounter.h"
+#include "Ruleset.h"
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+class Game;
+
+// A board as the attacker sees it: the rules, the cells missed and hit, and
+// the cell whose shot sank each sunk ship.  The order of the shots is not
+// part of a position.
+struct Position
+{
+	Position() : seen(0) {}
+	Ruleset rules;
+	FleetObservations seen;
+};
+
+// Reads the next position in text form, as Board::display(true) shows it
+// after a line naming the rules, with a line for each sunk ship:
+//
+//   position 10 10 A5 B4 D3 S3 P2       rows, cols, each ship's symbol and length
+//   sunk D 3 4                          ship D was sunk by the shot at row 3, column 4
+//     0123456789
+//   0 ..........                        . not shot, o missed, X hit
+//   ...
+//
+// "position standard" stands for the standard rules.  Returns false at the
+// end of the input, and also if the position is malformed, with a reason
+// in error.
+bool readPosition(std::istream& in, Position& pos, std::string& error);
+
+// The same in binary: rows, cols and the number of ships as bytes, each
+// ship's length and symbol as bytes, the missed and hit cells as two
+// CellSets (four little-endian 64-bit words), then each ship's sinking
+// cell as a CellSet index byte, 255 while it is afloat.
+bool readBinaryPosition(std::istream& in, Position& pos, std::string& error);
+
+struct Analysis
+{
+	bool valid;                          //false if a Game can't be set up with the rules
+	Point shot;                          //where the player would fire
+	int density[MAXROWS][MAXCOLS];       //GoodPlayer's heatmap, 0 for cells already shot
+};
+
+// Answers positions with a player from createPlayer and GoodPlayer's
+// heatmap.  The player hears of the position's shots as if it had fired
+// them, misses first, then hits, then the sinking shots, as a position
+// doesn't say in which order they came.  The n-th position analyzed is
+// played with seedRandom(seed + n), and each batch is shared out among
+// nThreads threads (0 means one per core).  Each thread keeps a Game for
+// every ruleset it has seen, so none is set up again for later positions
+// or batches.
+class PositionAnalyzer
+{
+public:
+	PositionAnalyzer(const std::string& type, int nThreads, unsigned int seed);
+	~PositionAnalyzer();
+	// false if type can't be analyzed with (humans need a terminal)
+	bool canAnalyze() const;
+	void analyze(const std::vector<Position>& positions, std::vector<Analysis>& results);
+	// We prevent a PositionAnalyzer object from being copied or assigned
+	PositionAnalyzer(const PositionAnalyzer&) = delete;
+	PositionAnalyzer& operator=(const PositionAnalyzer&) = delete;
+
+private:
+	typedef std::map<std::string, Game*> GameCache;
+	void analyzeOne(const Position& pos, unsigned int seed, GameCache& games, Analysis& result) const;
+	std::string m_type;
+	int m_nThreads;
+	unsigned int m_seed;
+	unsigned int m_done;             //positions analyzed so far
+	std::vector<GameCache> m_games;  //per thread, keyed by the rules
+};
+
+#endif // ANALYSIS_INCLUDED
@@ -1,4 +1,5 @@
 #include "Board.h"
+#include "CellSet.h"
 #include "Game.h"
 #include "globals.h"
 #include <iostream>
@@ -15,8 +16,13 @@ public:
 	void unblock();
 	bool placeShip(Point topOrLeft, int shipId, Direction dir);
 	bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
-	void display(bool shotsOnly) const;
+	void display(bool shotsOnly, ostream& out) const;
+	void render(bool shotsOnly, string& frame) const;
 	bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+	void attackMany(const vector<Point>& shots, vector<ShotResult>& results);
+	int shipsRemaining() const;
+	void shipCells(CellSet& cells) const;
+	bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
 	bool allShipsDestroyed() const;
 
 private:
@@ -24,10 +30,13 @@ private:
 	//        to be useful:
 	vector<vector<char>> m_grid;  //grid stored in a 2D character vector
 	const Game& m_game;
+	vector<Point> m_shipTop;      //where each ship was placed, (-1,-1) if it isn't on the board
+	vector<Direction> m_shipDir;
+	void shipOfSymbol(int shipOf[256]) const; //ship id for each grid character, -1 for the rest
 };
 
 BoardImpl::BoardImpl(const Game& g)
-	: m_game(g)
+	: m_game(g), m_shipTop(g.nShips(), Point(-1, -1)), m_shipDir(g.nShips(), HORIZONTAL)
 {
 	vector<char> row(g.cols(), '.');
 	vector<vector<char>> grid(g.rows(), row);
@@ -39,6 +48,8 @@ void BoardImpl::clear()
 	vector<char> row(m_game.cols(), '.');
 	vector<vector<char>> grid(m_game.rows(), row);
 	m_grid = grid;
+	for (int i = 0; i < m_shipTop.size(); i++)
+		m_shipTop[i] = Point(-1, -1);
 }//done
 
 void BoardImpl::block()
@@ -117,6 +128,8 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 			m_grid[topOrLeft.r][topOrLeft.c + i] = m_game.shipSymbol(shipId);
 		}
 	}
+	m_shipTop[shipId] = topOrLeft;
+	m_shipDir[shipId] = dir;
 
 	return true;
 }//done
@@ -148,7 +161,7 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 	{
 		for (int i = 0; i < m_game.shipLength(shipId); i++)
 		{
-			if (m_grid[topOrLeft.r][topOrLeft.c + 1] != m_game.shipSymbol(shipId))
+			if (m_grid[topOrLeft.r][topOrLeft.c + i] != m_game.shipSymbol(shipId))
 				return false;
 		}
 	}
@@ -168,33 +181,43 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 			m_grid[topOrLeft.r][topOrLeft.c + i] = '.';
 		}
 	}
+	m_shipTop[shipId] = Point(-1, -1);
 
 	return true;
 }//done
 
-void BoardImpl::display(bool shotsOnly) const
+void BoardImpl::display(bool shotsOnly, ostream& out) const
 {
-	cout << "  ";
-	for (int i = 0; i < m_grid[0].size(); i++)  //print column labels
+	string frame;
+	render(shotsOnly, frame);
+	out.write(frame.data(), frame.size()); //one write, one flush
+	out.flush();
+} //done
+
+void BoardImpl::render(bool shotsOnly, string& frame) const
+{
+	frame += "  ";
+	for (int i = 0; i < m_grid[0].size(); i++)  //column labels; boards are at most 10 wide
 	{
-		cout << i;
+		frame += char('0' + i);
 	}
-	cout << endl;
+	frame += '\n';
 
 	for (int i = 0; i < m_grid.size(); i++)
 	{
-		cout << i << ' '; //print out row labels
-		for (int j = 0; j < m_grid[i].size(); j++) //print grid
+		frame += char('0' + i); //row labels
+		frame += ' ';
+		for (int j = 0; j < m_grid[i].size(); j++) //grid
 		{
 			char c = m_grid[i][j];
 			if (shotsOnly&&c != '.'&&c != 'X'&&c != 'o')
-				cout << '.';
+				frame += '.';
 			else
-				cout << m_grid[i][j];
+				frame += c;
 		}
-		cout << endl;
+		frame += '\n';
 	}
-} //done
+}
 
 bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) //CHECK THIS THOROUGHLY
 {
@@ -246,6 +269,104 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 	return true;
 }
 
+void BoardImpl::shipOfSymbol(int shipOf[256]) const
+{
+	for (int i = 0; i < 256; i++)
+		shipOf[i] = -1;
+	for (int id = 0; id < m_game.nShips(); id++)
+		shipOf[(unsigned char)m_game.shipSymbol(id)] = id;
+}
+
+void BoardImpl::attackMany(const vector<Point>& shots, vector<ShotResult>& results)
+{
+	//one pass over the grid counts the unhit cells of every ship; after that
+	//each shot is resolved by a lookup instead of the scan attack() does
+	int shipOf[256];
+	shipOfSymbol(shipOf);
+	int left[256];
+	for (int id = 0; id < m_game.nShips(); id++)
+		left[id] = 0;
+	for (int r = 0; r < m_grid.size(); r++)
+		for (int c = 0; c < m_grid[r].size(); c++)
+			if (shipOf[(unsigned char)m_grid[r][c]] >= 0)
+				left[shipOf[(unsigned char)m_grid[r][c]]]++;
+
+	results.resize(shots.size());
+	for (int i = 0; i < shots.size(); i++)
+	{
+		Point p = shots[i];
+		ShotResult& res = results[i];
+		res.p = p;
+		res.validShot = res.shotHit = res.shipDestroyed = false;
+		res.shipId = -1;
+		if (!m_game.isValid(p))
+			continue;
+		char c = m_grid[p.r][p.c];
+		if (c == 'X' || c == 'o') //already attacked, perhaps earlier in this salvo
+			continue;
+		res.validShot = true;
+		if (c == '.')
+		{
+			m_grid[p.r][p.c] = 'o';
+			continue;
+		}
+		int id = shipOf[(unsigned char)c];
+		res.shotHit = true;
+		m_grid[p.r][p.c] = 'X';
+		if (--left[id] == 0)
+		{
+			res.shipDestroyed = true;
+			res.shipId = id;
+		}
+	}
+}
+
+int BoardImpl::shipsRemaining() const
+{
+	int shipOf[256];
+	shipOfSymbol(shipOf);
+	bool afloat[256];
+	for (int id = 0; id < m_game.nShips(); id++)
+		afloat[id] = false;
+	for (int r = 0; r < m_grid.size(); r++)
+		for (int c = 0; c < m_grid[r].size(); c++)
+			if (shipOf[(unsigned char)m_grid[r][c]] >= 0)
+				afloat[shipOf[(unsigned char)m_grid[r][c]]] = true;
+	int n = 0;
+	for (int id = 0; id < m_game.nShips(); id++)
+		if (afloat[id])
+			n++;
+	return n;
+}
+
+void BoardImpl::shipCells(CellSet& cells) const
+{
+	cells.clear();
+	for (int id = 0; id < m_game.nShips(); id++)
+	{
+		if (m_shipTop[id].r < 0)
+			continue;
+		for (int i = 0; i < m_game.shipLength(id); i++)
+		{
+			Point q = m_shipTop[id];
+			if (m_shipDir[id] == HORIZONTAL)
+				q.c += i;
+			else
+				q.r += i;
+			cells.set(q);
+		}
+	}
+}
+
+bool BoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+	if (shipId < 0 || shipId >= m_shipTop.size() || m_shipTop[shipId].r < 0)
+		return false;
+	topOrLeft = m_shipTop[shipId];
+	dir = m_shipDir[shipId];
+	return true;
+}
+
 bool BoardImpl::allShipsDestroyed() const
 {
 	for (int i = 0; i < m_grid.size(); i++)
@@ -301,7 +422,17 @@ bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 
 void Board::display(bool shotsOnly) const
 {
-	m_impl->display(shotsOnly);
+	m_impl->display(shotsOnly, cout);
+}
+
+void Board::display(bool shotsOnly, ostream& out) const
+{
+	m_impl->display(shotsOnly, out);
+}
+
+void Board::render(bool shotsOnly, string& frame) const
+{
+	m_impl->render(shotsOnly, frame);
 }
 
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
@@ -309,6 +440,26 @@ bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 	return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+void Board::attackMany(const vector<Point>& shots, vector<ShotResult>& results)
+{
+	m_impl->attackMany(shots, results);
+}
+
+int Board::shipsRemaining() const
+{
+	return m_impl->shipsRemaining();
+}
+
+void Board::shipCells(CellSet& cells) const
+{
+	m_impl->shipCells(cells);
+}
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+	return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
 bool Board::allShipsDestroyed() const
 {
 	return m_impl->allShipsDestroyed();
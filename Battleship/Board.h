@@ -2,9 +2,13 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
 
 class Game;
 class BoardImpl;
+struct CellSet;
 
 class Board
 {
@@ -17,7 +21,14 @@ public:
 	bool placeShip(Point topOrLeft, int shipId, Direction dir);
 	bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
 	void display(bool shotsOnly) const;
+	void display(bool shotsOnly, std::ostream& out) const;
+	void render(bool shotsOnly, std::string& frame) const; //appends what display would write
 	bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+	// Fires all of shots, in order, and puts what became of each in results
+	void attackMany(const std::vector<Point>& shots, std::vector<ShotResult>& results);
+	int shipsRemaining() const; //ships with at least one cell not yet hit
+	void shipCells(CellSet& cells) const; //the cells of the ships placed
+	bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const; //false if it isn't placed
 	bool allShipsDestroyed() const;
 	// We prevent a Board object from being copied or assigned
 	Board(const Board&) = delete;
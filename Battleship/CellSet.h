@@ -0,0 +1,111 @@
+#ifndef CELLSET_INCLUDED
+#define CELLSET_INCLUDED
+
+#include "globals.h"
+
+// A set of board cells stored as a bitmask, cell (r,c) being bit
+// r*MAXCOLS+c.  Two 64-bit words cover the largest board.
+struct CellSet
+{
+	unsigned long long w[2];
+
+	CellSet() { w[0] = w[1] = 0; }
+	static int index(Point p) { return p.r * MAXCOLS + p.c; }
+	static Point point(int i) { return Point(i / MAXCOLS, i % MAXCOLS); }
+
+	bool test(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+	bool test(Point p) const { return test(index(p)); }
+	void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+	void set(Point p) { set(index(p)); }
+	void reset(int i) { w[i >> 6] &= ~(1ULL << (i & 63)); }
+	void reset(Point p) { reset(index(p)); }
+	void clear() { w[0] = w[1] = 0; }
+
+	bool any() const { return (w[0] | w[1]) != 0; }
+	bool none() const { return !any(); }
+	bool intersects(const CellSet& o) const { return ((w[0] & o.w[0]) | (w[1] & o.w[1])) != 0; }
+	bool contains(const CellSet& o) const { return ((o.w[0] & ~w[0]) | (o.w[1] & ~w[1])) == 0; }
+	int count() const { return popCount(w[0]) + popCount(w[1]); }
+	int first() const; //lowest cell index in the set, -1 if empty
+	int last() const;  //highest cell index in the set, -1 if empty
+	int nth(int n) const; //index of the n-th cell (from 0) in increasing order
+
+	CellSet operator|(const CellSet& o) const { CellSet s; s.w[0] = w[0] | o.w[0]; s.w[1] = w[1] | o.w[1]; return s; }
+	CellSet operator&(const CellSet& o) const { CellSet s; s.w[0] = w[0] & o.w[0]; s.w[1] = w[1] & o.w[1]; return s; }
+	CellSet operator~() const { CellSet s; s.w[0] = ~w[0]; s.w[1] = ~w[1]; return s; }
+	CellSet& operator|=(const CellSet& o) { w[0] |= o.w[0]; w[1] |= o.w[1]; return *this; }
+	CellSet& operator&=(const CellSet& o) { w[0] &= o.w[0]; w[1] &= o.w[1]; return *this; }
+	bool operator==(const CellSet& o) const { return w[0] == o.w[0] && w[1] == o.w[1]; }
+	bool operator!=(const CellSet& o) const { return !(*this == o); }
+
+	CellSet minus(const CellSet& o) const { CellSet s; s.w[0] = w[0] & ~o.w[0]; s.w[1] = w[1] & ~o.w[1]; return s; }
+
+	static int popCount(unsigned long long x)
+	{
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return int((x * 0x0101010101010101ULL) >> 56);
+	}
+	static int lowBit(unsigned long long x) //index of the lowest set bit; x must not be 0
+	{
+		return popCount((x & (0 - x)) - 1);
+	}
+	static int highBit(unsigned long long x) //index of the highest set bit; x must not be 0
+	{
+		x |= x >> 1;
+		x |= x >> 2;
+		x |= x >> 4;
+		x |= x >> 8;
+		x |= x >> 16;
+		x |= x >> 32;
+		return popCount(x) - 1;
+	}
+};
+
+inline int CellSet::first() const
+{
+	if (w[0] != 0)
+		return lowBit(w[0]);
+	if (w[1] != 0)
+		return 64 + lowBit(w[1]);
+	return -1;
+}
+
+inline int CellSet::last() const
+{
+	if (w[1] != 0)
+		return 64 + highBit(w[1]);
+	if (w[0] != 0)
+		return highBit(w[0]);
+	return -1;
+}
+
+inline int CellSet::nth(int n) const
+{
+	for (int k = 0; k < 2; k++)
+	{
+		unsigned long long x = w[k];
+		int c = popCount(x);
+		if (n < c)
+		{
+			for (; n > 0; n--)
+				x &= x - 1;
+			return 64 * k + lowBit(x);
+		}
+		n -= c;
+	}
+	return -1;
+}
+
+// Every cell of a rows x cols board
+inline CellSet boardCells(int rows, int cols)
+{
+	CellSet s;
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+			s.set(Point(r, c));
+	return s;
+}
+
+#endif // CELLSET_INCLUDED
@@ -0,0 +1,282 @@
+#include "Coordinator.h"
+#include "Platform.h"
+#include "ShotStore.h"
+#include "LayoutStore.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const char MAGIC[8] = { 'B', 'S', 'S', 'H', 'A', 'R', 'D', '1' };
+const int MAXSHARDS = 1024;
+const int SHARDSPERPROCESS = 8;  //smaller shards even out the work between processes
+const int MAXATTEMPTS = 3;       //times a shard is tried before it is given up
+const int MAXSHIPSPECS = 16;
+const int MAXTYPE = 256;
+const int MAXNAMELEN = 64;
+const int MAXPATH = 1024;
+
+// Everything a worker needs to know, written by the coordinator before any
+// worker starts and only read afterwards
+struct ShardHeader
+{
+	char magic[8];
+	int rows;
+	int cols;
+	int nShips;
+	int shipLength[MAXSHIPSPECS];
+	char shipSymbol[MAXSHIPSPECS];
+	char shipName[MAXSHIPSPECS][MAXNAMELEN];
+	char type[2][MAXTYPE];
+	char name[2][MAXNAMELEN];
+	int firstGame;
+	int nGames;
+	int shardSize;
+	int nShards;
+	unsigned int seed;
+	int msPerMove;
+	int msPerGame;
+	int salvo;
+	char shotStore[MAXPATH];     //empty if the coordinator has no ShotStore open
+	char shotSnapshot[MAXPATH];  //the counts in it when the run started
+	char layoutStore[MAXPATH];   //likewise for the LayoutStore
+	char layoutSnapshot[MAXPATH];
+};
+
+struct ShardSlot
+{
+	atomic<int> done;  //set by the worker once result is complete
+	TournamentResult result;
+};
+
+size_t shardFileSize(int nShards)
+{
+	return sizeof(ShardHeader) + nShards * sizeof(ShardSlot);
+}
+
+ShardSlot* shardSlots(void* data)
+{
+	return reinterpret_cast<ShardSlot*>(static_cast<ShardHeader*>(data) + 1);
+}
+
+void copyString(char* dest, const string& s, int size)
+{
+	memset(dest, 0, size);
+	strncpy(dest, s.c_str(), size - 1);
+}
+
+//******************** Coordinator functions **************************
+
+Coordinator::Coordinator(const TournamentConfig& config, int nProcesses, const string& exe)
+	: m_config(config), m_nProcesses(nProcesses), m_exe(exe), m_restarts(0)
+{
+	if (m_nProcesses <= 0)
+		m_nProcesses = max(1, (int)thread::hardware_concurrency());
+}
+
+Coordinator::~Coordinator()
+{}
+
+TournamentResult Coordinator::run()
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	TournamentResult total;
+	m_restarts = 0;
+	if (m_config.nGames <= 0)
+		return total;
+	if (m_config.rules.ships.size() > MAXSHIPSPECS)
+	{
+		cout << "Too many kinds of ship for a sharded tournament." << endl;
+		return total;
+	}
+
+	int shardSize = max((m_config.nGames + MAXSHARDS - 1) / MAXSHARDS,
+		(m_config.nGames + m_nProcesses * SHARDSPERPROCESS - 1) / (m_nProcesses * SHARDSPERPROCESS));
+	int nShards = (m_config.nGames + shardSize - 1) / shardSize;
+
+	//a fresh file every run, so no worker can see a previous run's results
+	//and runs started from the same directory don't share one
+	string path = createTempFile("shards");
+	MappedFile file;
+	if (path.empty() || !file.open(path, shardFileSize(nShards)))
+	{
+		cout << "Could not create a shard file in the temporary directory" << endl;
+		if (!path.empty())
+			remove(path.c_str());
+		return total;
+	}
+	//the workers learn from the stores as they are now, as a Tournament's players would
+	string shotSnapshot;
+	string layoutSnapshot;
+	if (ShotStore::instance().isOpen())
+		shotSnapshot = createTempFile("shots");
+	if (LayoutStore::instance().isOpen())
+		layoutSnapshot = createTempFile("layouts");
+	if ((ShotStore::instance().isOpen() && (shotSnapshot.empty() || !ShotStore::instance().saveSnapshot(shotSnapshot))) ||
+		(LayoutStore::instance().isOpen() && (layoutSnapshot.empty() || !LayoutStore::instance().saveSnapshot(layoutSnapshot))))
+	{
+		cout << "Could not save the shot and layout stores for the workers" << endl;
+		if (!shotSnapshot.empty())
+			remove(shotSnapshot.c_str());
+		if (!layoutSnapshot.empty())
+			remove(layoutSnapshot.c_str());
+		file.close();
+		remove(path.c_str());
+		return total;
+	}
+	ShardHeader* header = static_cast<ShardHeader*>(file.data());
+	header->rows = m_config.rules.rows;
+	header->cols = m_config.rules.cols;
+	header->nShips = m_config.rules.ships.size();
+	for (int i = 0; i < header->nShips; i++)
+	{
+		header->shipLength[i] = m_config.rules.ships[i].length;
+		header->shipSymbol[i] = m_config.rules.ships[i].symbol;
+		copyString(header->shipName[i], m_config.rules.ships[i].name, MAXNAMELEN);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		copyString(header->type[i], m_config.type[i], MAXTYPE);
+		copyString(header->name[i], m_config.name[i], MAXNAMELEN);
+	}
+	header->firstGame = m_config.firstGame;
+	header->nGames = m_config.nGames;
+	header->shardSize = shardSize;
+	header->nShards = nShards;
+	header->seed = m_config.seed;
+	header->msPerMove = m_config.msPerMove;
+	header->msPerGame = m_config.msPerGame;
+	header->salvo = m_config.salvo;
+	copyString(header->shotStore, ShotStore::instance().isOpen() ? ShotStore::instance().path() : "", MAXPATH);
+	copyString(header->shotSnapshot, shotSnapshot, MAXPATH);
+	copyString(header->layoutStore, LayoutStore::instance().isOpen() ? LayoutStore::instance().path() : "", MAXPATH);
+	copyString(header->layoutSnapshot, layoutSnapshot, MAXPATH);
+	ShardSlot* slots = shardSlots(file.data());
+	for (int s = 0; s < nShards; s++)
+		new (&slots[s]) ShardSlot;  //atomic and TournamentResult need constructing
+	memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+	//one thread looks after each worker process, feeding it shards until none are left
+	string command = "\"" + m_exe + "\" worker \"" + path + "\"";
+	atomic<int> next(0);
+	atomic<int> restarts(0);
+	vector<char> failed(nShards, 0);
+	auto manage = [&]() {
+		ChildProcess proc;
+		for (int s = next++; s < nShards; s = next++)
+		{
+			string request = "shard " + to_string(s) + "\n";
+			string expected = "done " + to_string(s);
+			for (int attempt = 0; ; attempt++)
+			{
+				if (attempt == MAXATTEMPTS)
+				{
+					failed[s] = 1;
+					break;
+				}
+				if (attempt > 0)
+					restarts++;
+				string reply;
+				if ((proc.isRunning() || proc.start(command)) && proc.write(request) &&
+					proc.readLine(reply) && reply == expected && slots[s].done.load(memory_order_acquire))
+					break;
+				proc.close();  //the worker died or misbehaved; this shard goes to a new one
+			}
+		}
+		proc.write("quit\n");
+		proc.close();
+	};
+	int nProcesses = min(m_nProcesses, nShards);
+	vector<thread> threads;
+	for (int t = 0; t < nProcesses; t++)
+		threads.push_back(thread(manage));
+	for (int t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	for (int s = 0; s < nShards; s++)
+	{
+		if (failed[s])
+		{
+			int games = min(shardSize, m_config.nGames - s * shardSize);
+			total.games += games;
+			total.noResult += games;
+		}
+		else
+			total.merge(slots[s].result);
+	}
+	file.close();
+	remove(path.c_str());
+	if (!shotSnapshot.empty())
+		remove(shotSnapshot.c_str());
+	if (!layoutSnapshot.empty())
+		remove(layoutSnapshot.c_str());
+	m_restarts = restarts;
+	total.seconds = secondsSince(start);
+	return total;
+}
+
+//******************** worker functions *******************************
+
+int runShardWorker(const string& path, istream& in, ostream& out)
+{
+	MappedFile file;
+	if (!file.open(path, sizeof(ShardHeader)))
+		return 1;
+	ShardHeader* header = static_cast<ShardHeader*>(file.data());
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || file.size() < shardFileSize(header->nShards))
+		return 1;
+
+	TournamentConfig config;
+	config.rules.rows = header->rows;
+	config.rules.cols = header->cols;
+	config.rules.ships.clear();
+	for (int i = 0; i < header->nShips; i++)
+	{
+		ShipSpec spec = { header->shipLength[i], header->shipSymbol[i], header->shipName[i] };
+		config.rules.ships.push_back(spec);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		config.type[i] = header->type[i];
+		config.name[i] = header->name[i];
+	}
+	config.seed = header->seed;
+	config.nThreads = 1;
+	config.msPerMove = header->msPerMove;
+	config.msPerGame = header->msPerGame;
+	config.salvo = (header->salvo != 0);
+	if (header->shotStore[0] != '\0' && (!ShotStore::instance().open(header->shotStore) ||
+		!ShotStore::instance().freezeFrom(header->shotSnapshot)))
+		return 1;
+	if (header->layoutStore[0] != '\0' && (!LayoutStore::instance().open(header->layoutStore) ||
+		!LayoutStore::instance().freezeFrom(header->layoutSnapshot)))
+		return 1;
+	ShardSlot* slots = shardSlots(file.data());
+
+	string line;
+	while (getline(in, line))
+	{
+		istringstream iss(line);
+		string word;
+		int s;
+		if (!(iss >> word) || word == "quit")
+			break;
+		if (word != "shard" || !(iss >> s) || s < 0 || s >= header->nShards)
+			return 1;
+		config.firstGame = header->firstGame + s * header->shardSize;
+		config.nGames = min(header->shardSize, header->nGames - s * header->shardSize);
+		Tournament t(config);
+		slots[s].result = t.run();
+		slots[s].done.store(1, memory_order_release);
+		out << "done " << s << endl;
+	}
+	return 0;
+}
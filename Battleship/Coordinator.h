@@ -0,0 +1,43 @@
+#ifndef COORDINATOR_INCLUDED
+#define COORDINATOR_INCLUDED
+
+#include "Tournament.h"
+#include <iosfwd>
+#include <string>
+
+class MappedFile;
+
+// Runs a tournament in several worker processes, each an instance of this
+// program started as "<exe> worker <file>".  The games are cut into shards
+// of consecutive game numbers that are handed to whichever worker is free.
+// The configuration is written once to a memory-mapped file, made afresh in
+// the temporary directory for every run and removed when it ends, that every
+// worker reads, and each worker leaves the totals of a shard in that
+// shard's slot of the file.  A shard whose worker dies is started again in
+// a new worker; games are seeded by number, so the totals are the same as
+// those of a Tournament with the same configuration.  If the ShotStore is
+// open, the workers record into it too, and all learn from a snapshot of it
+// taken when the run starts.
+class Coordinator
+{
+public:
+	Coordinator(const TournamentConfig& config, int nProcesses, const std::string& exe);
+	~Coordinator();
+	TournamentResult run(); //config.nThreads is ignored; each worker plays one game at a time
+	int restarts() const { return m_restarts; } //workers that had to be replaced in the last run
+	// We prevent a Coordinator object from being copied or assigned
+	Coordinator(const Coordinator&) = delete;
+	Coordinator& operator=(const Coordinator&) = delete;
+
+private:
+	TournamentConfig m_config;
+	int m_nProcesses;
+	std::string m_exe;
+	int m_restarts;
+};
+
+// The main loop of a worker process: plays the shards named on in and
+// reports each one on out.  Returns the process exit status.
+int runShardWorker(const std::string& path, std::istream& in, std::ostream& out);
+
+#endif // COORDINATOR_INCLUDED
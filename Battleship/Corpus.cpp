@@ -0,0 +1,406 @@
+#include "Corpus.h"
+#include "Board.h"
+#include "CellSet.h"
+#include "Game.h"
+#include "Player.h"
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+using namespace std;
+
+//******************** reading and writing games **********************
+
+// The cells of ship i of game, or false if it leaves the board
+bool shipCellsOf(const RecordedGame& game, int i, CellSet& cells)
+{
+	cells.clear();
+	for (int k = 0; k < game.rules.ships[i].length; k++)
+	{
+		Point p = game.shipTop[i];
+		if (game.shipDir[i] == HORIZONTAL)
+			p.c += k;
+		else
+			p.r += k;
+		if (p.r < 0 || p.r >= game.rules.rows || p.c < 0 || p.c >= game.rules.cols)
+			return false;
+		cells.set(p);
+	}
+	return true;
+}
+
+// Reads the line that starts with word into rest
+bool readLine(istream& in, const string& word, istringstream& rest, string& error)
+{
+	string line;
+	string first;
+	rest.clear();
+	if (!getline(in, line))
+	{
+		error = "expected a " + word + " line at the end of the input";
+		return false;
+	}
+	rest.str(line);
+	if (!(rest >> first) || first != word)
+	{
+		error = "expected a " + word + " line, not \"" + line + "\"";
+		return false;
+	}
+	return true;
+}
+
+bool readRecordedGame(istream& in, RecordedGame& game, string& error)
+{
+	error.clear();
+	string line;
+	while (getline(in, line) && line.find_first_not_of(" \t\r") == string::npos)
+		; //blank lines between games
+	if (!in)
+		return false;
+	if (line.compare(0, 5, "game ") != 0)
+	{
+		error = "expected a game line, not \"" + line + "\"";
+		return false;
+	}
+	if (!game.rules.parse(line.substr(5), error))
+		return false;
+
+	istringstream rest;
+	if (!readLine(in, "layout", rest, error))
+		return false;
+	game.shipTop.clear();
+	game.shipDir.clear();
+	CellSet fleet;
+	for (int i = 0; i < game.rules.ships.size(); i++)
+	{
+		Point p;
+		char dir;
+		CellSet cells;
+		if (!(rest >> p.r >> p.c >> dir) || (dir != 'h' && dir != 'v'))
+		{
+			error = "the layout doesn't place every ship";
+			return false;
+		}
+		game.shipTop.push_back(p);
+		game.shipDir.push_back(dir == 'h' ? HORIZONTAL : VERTICAL);
+		if (!shipCellsOf(game, i, cells) || cells.intersects(fleet))
+		{
+			error = string("ship ") + game.rules.ships[i].symbol + " is off the board or on another ship";
+			return false;
+		}
+		fleet |= cells;
+	}
+
+	if (!readLine(in, "shots", rest, error))
+		return false;
+	game.shots.clear();
+	Point p;
+	while (rest >> p.r >> p.c)
+	{
+		if (p.r < 0 || p.r >= game.rules.rows || p.c < 0 || p.c >= game.rules.cols)
+		{
+			error = "shot " + to_string(game.shots.size()) + " is off the board";
+			return false;
+		}
+		game.shots.push_back(p);
+	}
+
+	if (!readLine(in, "sample", rest, error))
+		return false;
+	game.samples.clear();
+	int turn;
+	while (rest >> turn)
+	{
+		if (turn < 0 || turn >= game.shots.size())
+		{
+			error = "sample " + to_string(turn) + " is past the last shot";
+			return false;
+		}
+		game.samples.push_back(turn);
+	}
+	return true;
+}
+
+void writeRecordedGame(ostream& out, const RecordedGame& game)
+{
+	out << "game " << game.rules.rows << " " << game.rules.cols;
+	for (int i = 0; i < game.rules.ships.size(); i++)
+		out << " " << game.rules.ships[i].symbol << game.rules.ships[i].length;
+	out << "\nlayout";
+	for (int i = 0; i < game.shipTop.size(); i++)
+		out << " " << game.shipTop[i].r << " " << game.shipTop[i].c << " " << (game.shipDir[i] == HORIZONTAL ? 'h' : 'v');
+	out << "\nshots";
+	for (int i = 0; i < game.shots.size(); i++)
+		out << " " << game.shots[i].r << " " << game.shots[i].c;
+	out << "\nsample";
+	for (int i = 0; i < game.samples.size(); i++)
+		out << " " << game.samples[i];
+	out << "\n\n";
+}
+
+//******************** recording games ********************************
+
+// Passes everything on to the player it wraps, noting where that player
+// placed its ships and the shots it fired
+class RecordingPlayer : public Player
+{
+public:
+	RecordingPlayer(Player* player, const Game& g) : Player(player->name(), g), placed(false), m_player(player) {}
+	virtual bool isHuman() const { return m_player->isHuman(); }
+	virtual bool placeShips(Board& b);
+	virtual Point recommendAttack() { return m_player->recommendAttack(); }
+	virtual Point recommendAttackBefore(Deadline deadline) { return m_player->recommendAttackBefore(deadline); }
+	virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+	virtual void recordAttackByOpponent(Point p) { m_player->recordAttackByOpponent(p); }
+	virtual void recordOpponent(const Player& opponent) { m_player->recordOpponent(opponent); }
+	bool placed;                    //every ship is on the board
+	vector<Point> shipTop;
+	vector<Direction> shipDir;
+	vector<Point> shots;
+private:
+	Player* m_player;
+};
+
+bool RecordingPlayer::placeShips(Board& b)
+{
+	placed = m_player->placeShips(b);
+	shipTop.resize(game().nShips());
+	shipDir.resize(game().nShips());
+	for (int i = 0; i < game().nShips() && placed; i++)
+		placed = b.shipPlacement(i, shipTop[i], shipDir[i]);
+	return placed;
+}
+
+void RecordingPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	shots.push_back(p);
+	m_player->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+bool recordCorpus(const vector<string>& types, const Ruleset& rules, int nGames, int perGame,
+	unsigned int seed, vector<RecordedGame>& corpus, string& error)
+{
+	Game g(rules.rows, rules.cols);
+	g.setTranscript(nullptr);
+	if (!rules.addShipsTo(g))
+	{
+		error = "the ships don't fit " + rules.str();
+		return false;
+	}
+	for (int i = 0; i < types.size(); i++)
+	{
+		Player* p = createPlayer(types[i], types[i], g);
+		delete p;
+		if (p == nullptr || types[i] == "human")
+		{
+			error = types[i] + " is not a computer player";
+			return false;
+		}
+	}
+
+	for (int k = 0; k < nGames; k++)
+	{
+		seedRandom(seed + k);
+		const string& type1 = types[k % types.size()];
+		const string& type2 = types[(k + 1) % types.size()];
+		Player* p1 = createPlayer(type1, type1, g);
+		Player* p2 = createPlayer(type2, type2, g);
+		RecordingPlayer r1(p1, g);
+		RecordingPlayer r2(p2, g);
+		g.play(&r1, &r2, false);
+		RecordingPlayer* sides[2][2] = { { &r1, &r2 }, { &r2, &r1 } }; //attacker, defender
+		for (int s = 0; s < 2; s++)
+		{
+			RecordingPlayer& attacker = *sides[s][0];
+			RecordingPlayer& defender = *sides[s][1];
+			if (!defender.placed || attacker.shots.empty())
+				continue;
+			RecordedGame game;
+			game.rules = rules;
+			game.shipTop = defender.shipTop;
+			game.shipDir = defender.shipDir;
+			game.shots = attacker.shots;
+			//a partial shuffle picks the sampled turns
+			vector<int> turns(game.shots.size());
+			for (int t = 0; t < turns.size(); t++)
+				turns[t] = t;
+			int n = min(perGame, (int)turns.size());
+			for (int t = 0; t < n; t++)
+				swap(turns[t], turns[t + randInt(turns.size() - t)]);
+			game.samples.assign(turns.begin(), turns.begin() + n);
+			sort(game.samples.begin(), game.samples.end());
+			corpus.push_back(game);
+		}
+		delete p1;
+		delete p2;
+	}
+	return true;
+}
+
+//******************** latencies **************************************
+
+const char* phaseName(int phase)
+{
+	const char* names[NPHASES] = { "opening", "hunt", "target", "endgame" };
+	return phase >= 0 && phase < NPHASES ? names[phase] : "?";
+}
+
+void saveLatencies(ostream& out, const vector<StrategyLatency>& latencies)
+{
+	for (int i = 0; i < latencies.size(); i++)
+	{
+		out << "strategy " << latencies[i].type << " " << NPHASES << "\n";
+		for (int ph = 0; ph < NPHASES; ph++)
+		{
+			latencies[i].recommend[ph].save(out);
+			latencies[i].record[ph].save(out);
+		}
+	}
+}
+
+bool loadLatencies(istream& in, vector<StrategyLatency>& latencies)
+{
+	latencies.clear();
+	string word;
+	while (in >> word)
+	{
+		StrategyLatency latency;
+		int nPhases;
+		if (word != "strategy" || !(in >> latency.type >> nPhases) || nPhases != NPHASES)
+			return false;
+		for (int ph = 0; ph < NPHASES; ph++)
+			if (!latency.recommend[ph].load(in) || !latency.record[ph].load(in))
+				return false;
+		latencies.push_back(latency);
+	}
+	return true;
+}
+
+//******************** CorpusBenchmark functions **********************
+
+CorpusBenchmark::CorpusBenchmark(const vector<RecordedGame>& corpus, unsigned int seed)
+	: m_corpus(corpus), m_seed(seed)
+{
+	for (int i = 0; i < corpus.size(); i++)
+	{
+		const RecordedGame& game = corpus[i];
+		vector<CellSet> ships(game.rules.ships.size());
+		for (int s = 0; s < ships.size(); s++)
+			shipCellsOf(game, s, ships[s]);
+		for (int k = 0; k < game.samples.size(); k++)
+		{
+			Sample sample = { i, game.samples[k], PHASE_HUNT };
+			CellSet shot;
+			for (int t = 0; t < sample.turn; t++)
+				shot.set(game.shots[t]);
+			int afloat = 0;
+			bool wounded = false;
+			for (int s = 0; s < ships.size(); s++)
+			{
+				bool sunk = shot.contains(ships[s]);
+				if (!sunk)
+					afloat++;
+				if (!sunk && shot.intersects(ships[s]))
+					wounded = true;
+			}
+			if (wounded)
+				sample.phase = PHASE_TARGET;
+			else if (afloat == 1)
+				sample.phase = PHASE_ENDGAME;
+			else if (shot.count() * 10 < game.rules.rows * game.rules.cols)
+				sample.phase = PHASE_OPENING;
+			m_samples.push_back(sample);
+		}
+	}
+}
+
+CorpusBenchmark::~CorpusBenchmark()
+{
+	for (map<string, Game*>::iterator it = m_games.begin(); it != m_games.end(); it++)
+		delete it->second;
+}
+
+int CorpusBenchmark::nPositions(int phase) const
+{
+	int n = 0;
+	for (int i = 0; i < m_samples.size(); i++)
+		if (m_samples[i].phase == phase)
+			n++;
+	return n;
+}
+
+bool CorpusBenchmark::canBenchmark(const string& type) const
+{
+	//bots expect a whole game, starting with placing their ships
+	if (type == "human" || type.compare(0, 4, "bot:") == 0)
+		return false;
+	Game g(10, 10);
+	Ruleset::standard().addShipsTo(g);
+	Player* p = createPlayer(type, "bench", g);
+	delete p;
+	return p != nullptr;
+}
+
+Game& CorpusBenchmark::gameFor(const Ruleset& rules)
+{
+	string key = rules.str();
+	Game*& g = m_games[key];
+	if (g == nullptr)
+	{
+		g = new Game(rules.rows, rules.cols);
+		g->setTranscript(nullptr);
+		rules.addShipsTo(*g);
+	}
+	return *g;
+}
+
+void CorpusBenchmark::run(const string& type, int repeat, StrategyLatency& latency)
+{
+	latency.type = type;
+	for (int ph = 0; ph < NPHASES; ph++)
+	{
+		latency.recommend[ph].clear();
+		latency.record[ph].clear();
+	}
+	for (int rep = 0; rep < repeat; rep++)
+	{
+		for (int n = 0; n < m_samples.size(); n++)
+		{
+			const Sample& sample = m_samples[n];
+			const RecordedGame& game = m_corpus[sample.game];
+			Game& g = gameFor(game.rules);
+			Board b(g);
+			for (int i = 0; i < g.nShips(); i++)
+				b.placeShip(game.shipTop[i], i, game.shipDir[i]);
+			seedRandom(m_seed + n);
+			randomGenerator().discard(1); //a reseeded generator refills its state on the first draw; don't time that
+			Player* player = createPlayer(type, "bench", g);
+
+			//the shots before the position are answered as Game::play would
+			bool shotHit;
+			bool shipDestroyed;
+			int shipId;
+			for (int t = 0; t < sample.turn; t++)
+			{
+				shotHit = shipDestroyed = false;
+				shipId = -1;
+				bool validShot = b.attack(game.shots[t], shotHit, shipDestroyed, shipId);
+				player->recordAttackResult(game.shots[t], validShot, validShot && shotHit,
+					validShot && shipDestroyed, shipId);
+			}
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			Point p = player->recommendAttack();
+			latency.recommend[sample.phase].record(secondsSince(start));
+			shotHit = shipDestroyed = false;
+			shipId = -1;
+			bool validShot = b.attack(p, shotHit, shipDestroyed, shipId);
+			start = chrono::steady_clock::now();
+			player->recordAttackResult(p, validShot, validShot && shotHit, validShot && shipDestroyed, shipId);
+			latency.record[sample.phase].record(secondsSince(start));
+			delete player;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef CORPUS_INCLUDED
+#define CORPUS_INCLUDED
+
+#include "globals.h"
+#include "Ruleset.h"
+#include "Timing.h"
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+class Game;
+
+// One side of a game that was played out: the defender's ships, every shot
+// the attacker fired at them in order, and the turns at which the game is
+// sampled as a position for the latency benchmark.  In text form:
+//
+//   game 10 10 A5 B4 D3 S3 P2      rows, cols, each ship's symbol and length
+//   layout 0 0 h 2 7 v ...         each ship's top or left cell and direction
+//   shots 4 4 5 3 ...              each shot's row and column
+//   sample 0 17 38                 shots fired before each sampled position
+struct RecordedGame
+{
+	Ruleset rules;
+	std::vector<Point> shipTop;
+	std::vector<Direction> shipDir;
+	std::vector<Point> shots;
+	std::vector<int> samples;
+};
+
+// Returns false at the end of the input, and also if the game is
+// malformed, with a reason in error
+bool readRecordedGame(std::istream& in, RecordedGame& game, std::string& error);
+void writeRecordedGame(std::ostream& out, const RecordedGame& game);
+
+// Plays nGames seeded games between the players of types, each against the
+// next in turn, and records both sides of each, sampling up to perGame
+// positions from every side.  Game k is played with seedRandom(seed + k).
+// Returns false if a type is not a computer player or a symbol is used by
+// two ships.
+bool recordCorpus(const std::vector<std::string>& types, const Ruleset& rules, int nGames, int perGame,
+	unsigned int seed, std::vector<RecordedGame>& corpus, std::string& error);
+
+// What kind of position a sample is, from the shots before it
+enum Phase {
+	PHASE_OPENING,   //under a tenth of the board shot and no ship hit
+	PHASE_HUNT,      //no ship hit but not sunk
+	PHASE_TARGET,    //some ship hit but not sunk
+	PHASE_ENDGAME,   //one ship afloat and not yet hit
+	NPHASES
+};
+
+const char* phaseName(int phase);
+
+// The time a strategy took over the corpus, for each phase
+struct StrategyLatency
+{
+	std::string type;
+	LatencyHistogram recommend[NPHASES];  //recommendAttack
+	LatencyHistogram record[NPHASES];     //recordAttackResult for that shot
+};
+
+// Reads back what saveLatencies wrote; false if the file is malformed
+bool loadLatencies(std::istream& in, std::vector<StrategyLatency>& latencies);
+void saveLatencies(std::ostream& out, const std::vector<StrategyLatency>& latencies);
+
+// Times strategies on every sampled position of a corpus.  For each sample
+// a new player is told of the shots before it, in order, as if it had
+// fired them, and then the next recommendAttack and the recordAttackResult
+// for the shot it chose are timed, so each strategy is measured on the same
+// positions, whoever played the game.  The n-th sample is set up with
+// seedRandom(seed + n).  Everything runs on the calling thread, so the
+// times aren't disturbed by other work of the benchmark.
+class CorpusBenchmark
+{
+public:
+	CorpusBenchmark(const std::vector<RecordedGame>& corpus, unsigned int seed);
+	~CorpusBenchmark();
+	int nPositions() const { return m_samples.size(); }
+	int nPositions(int phase) const;
+	// false if type can't be benchmarked (humans need a terminal)
+	bool canBenchmark(const std::string& type) const;
+	// Times every position repeat times
+	void run(const std::string& type, int repeat, StrategyLatency& latency);
+	// We prevent a CorpusBenchmark object from being copied or assigned
+	CorpusBenchmark(const CorpusBenchmark&) = delete;
+	CorpusBenchmark& operator=(const CorpusBenchmark&) = delete;
+
+private:
+	struct Sample
+	{
+		int game;
+		int turn;
+		Phase phase;
+	};
+	Game& gameFor(const Ruleset& rules);
+	const std::vector<RecordedGame>& m_corpus;
+	unsigned int m_seed;
+	std::vector<Sample> m_samples;
+	std::map<std::string, Game*> m_games;  //keyed by the rules
+};
+
+#endif // CORPUS_INCLUDED
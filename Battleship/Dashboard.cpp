@@ -0,0 +1,238 @@
+#include "Dashboard.h"
+#include "Platform.h"
+#include "Renderer.h"
+#include "Timing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+const int NSHOTS = MAXROWS * MAXCOLS + 1;
+const int MAXNAME = 32;
+const char MAGIC[8] = { 'B', 'S', 'D', 'A', 'S', 'H', '0', '1' };
+
+// The layout of the shared file.  Times are milliseconds of the system
+// clock, which unlike steady_clock means the same thing in every process.
+struct DashboardData
+{
+	char magic[8];
+	char name[2][MAXNAME];
+	int nGames;
+	atomic<int> finished;
+	atomic<long long> startMs;
+	atomic<long long> updateMs;
+	atomic<unsigned long long> gamesDone;
+	atomic<unsigned long long> noResult;
+	atomic<unsigned long long> wins[2];
+	atomic<unsigned int> shotsToWin[2][NSHOTS];
+};
+
+long long nowMs()
+{
+	return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Dashboard::Dashboard()
+	: m_file(nullptr), m_data(nullptr)
+{}
+
+Dashboard::~Dashboard()
+{
+	delete m_file;
+}
+
+bool Dashboard::create(const string& path, const string names[2], int nGames)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->open(path, sizeof(DashboardData)))
+	{
+		delete file;
+		return false;
+	}
+	DashboardData* d = static_cast<DashboardData*>(file->data());
+	memset(d->magic, 0, sizeof(d->magic)); //a viewer ignores the file until it is ready
+	for (int i = 0; i < 2; i++)
+	{
+		memset(d->name[i], 0, MAXNAME);
+		strncpy(d->name[i], names[i].c_str(), MAXNAME - 1);
+		d->wins[i].store(0, memory_order_relaxed);
+		for (int n = 0; n < NSHOTS; n++)
+			d->shotsToWin[i][n].store(0, memory_order_relaxed);
+	}
+	d->nGames = nGames;
+	d->finished.store(0, memory_order_relaxed);
+	d->gamesDone.store(0, memory_order_relaxed);
+	d->noResult.store(0, memory_order_relaxed);
+	d->startMs.store(nowMs(), memory_order_relaxed);
+	d->updateMs.store(nowMs(), memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	memcpy(d->magic, MAGIC, sizeof(MAGIC));
+	delete m_file;
+	m_file = file;
+	m_data = d;
+	return true;
+}
+
+bool Dashboard::attach(const string& path)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->openReadOnly(path) || file->size() < sizeof(DashboardData) ||
+		memcmp(static_cast<DashboardData*>(file->data())->magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		delete file;
+		return false;
+	}
+	delete m_file;
+	m_file = file;
+	m_data = static_cast<DashboardData*>(file->data());
+	return true;
+}
+
+void Dashboard::recordGame(int winner, int winnerShots)
+{
+	if (m_data == nullptr)
+		return;
+	if (winner < 0)
+		m_data->noResult.fetch_add(1, memory_order_relaxed);
+	else
+	{
+		m_data->wins[winner].fetch_add(1, memory_order_relaxed);
+		if (winnerShots >= 0 && winnerShots < NSHOTS)
+			m_data->shotsToWin[winner][winnerShots].fetch_add(1, memory_order_relaxed);
+	}
+	m_data->updateMs.store(nowMs(), memory_order_relaxed);
+	m_data->gamesDone.fetch_add(1, memory_order_relaxed);
+}
+
+void Dashboard::finish()
+{
+	if (m_data == nullptr)
+		return;
+	m_data->updateMs.store(nowMs(), memory_order_relaxed);
+	m_data->finished.store(1, memory_order_release);
+}
+
+bool Dashboard::snapshot(DashboardSnapshot& s) const
+{
+	if (m_data == nullptr || memcmp(m_data->magic, MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+	//the counters are read one at a time, so they may be a game or two apart
+	s.finished = m_data->finished.load(memory_order_acquire) != 0;
+	s.nGames = m_data->nGames;
+	s.gamesDone = m_data->gamesDone.load(memory_order_relaxed);
+	s.noResult = m_data->noResult.load(memory_order_relaxed);
+	for (int i = 0; i < 2; i++)
+	{
+		s.name[i].assign(m_data->name[i], strnlen(m_data->name[i], MAXNAME));
+		s.wins[i] = m_data->wins[i].load(memory_order_relaxed);
+		for (int n = 0; n < NSHOTS; n++)
+			s.shotsToWin[i][n] = m_data->shotsToWin[i][n].load(memory_order_relaxed);
+	}
+	long long end = s.finished ? m_data->updateMs.load(memory_order_relaxed) : nowMs();
+	s.seconds = (end - m_data->startMs.load(memory_order_relaxed)) / 1000.0;
+	return true;
+}
+
+//******************** viewer functions *******************************
+
+const int VIEWROWS = 30;
+const int VIEWCOLS = 80;
+const int MAXBUCKETS = 20;
+const int BARWIDTH = 24;
+
+void drawDashboard(const DashboardSnapshot& s, Screen& screen)
+{
+	char line[128];
+	screen.clear();
+	screen.put(0, 0, s.name[0] + " vs " + s.name[1] + (s.finished ? "  (finished)" : "  (running)"));
+	snprintf(line, sizeof(line), "Games %llu of %d (%.1f%%)   %.1f games/sec   %s elapsed",
+		s.gamesDone, s.nGames, s.nGames > 0 ? 100.0 * s.gamesDone / s.nGames : 0.0,
+		s.gamesPerSecond(), formatSeconds(s.seconds).c_str());
+	screen.put(1, 0, line);
+	unsigned long long decided = s.wins[0] + s.wins[1];
+	for (int i = 0; i < 2; i++)
+	{
+		snprintf(line, sizeof(line), "%-20.20s won %8llu  (%5.1f%%)", s.name[i].c_str(), s.wins[i],
+			decided > 0 ? 100.0 * s.wins[i] / decided : 0.0);
+		screen.put(3 + i, 0, line);
+	}
+	if (s.noResult > 0)
+	{
+		snprintf(line, sizeof(line), "not played %llu", s.noResult);
+		screen.put(5, 0, line);
+	}
+
+	//winning shot counts, grouped so that the histogram fits on the screen
+	int lo = NSHOTS;
+	int hi = -1;
+	for (int i = 0; i < 2; i++)
+	{
+		for (int n = 0; n < NSHOTS; n++)
+		{
+			if (s.shotsToWin[i][n] > 0)
+			{
+				lo = min(lo, n);
+				hi = max(hi, n);
+			}
+		}
+	}
+	if (hi < 0)
+		return;
+	int width = (hi - lo) / MAXBUCKETS + 1;
+	int nBuckets = (hi - lo) / width + 1;
+	unsigned int count[2][MAXBUCKETS];
+	unsigned int most = 1;
+	for (int i = 0; i < 2; i++)
+	{
+		for (int b = 0; b < nBuckets; b++)
+		{
+			count[i][b] = 0;
+			for (int n = lo + b * width; n < lo + (b + 1) * width && n <= hi; n++)
+				count[i][b] += s.shotsToWin[i][n];
+			most = max(most, count[i][b]);
+		}
+	}
+	snprintf(line, sizeof(line), "Shots to win  %-*.*s  %-*.*s", BARWIDTH + 8, BARWIDTH, s.name[0].c_str(),
+		BARWIDTH + 8, BARWIDTH, s.name[1].c_str());
+	screen.put(7, 0, line);
+	for (int b = 0; b < nBuckets; b++)
+	{
+		int first = lo + b * width;
+		if (width == 1)
+			snprintf(line, sizeof(line), "%3d", first);
+		else
+			snprintf(line, sizeof(line), "%3d-%-3d", first, first + width - 1);
+		screen.put(8 + b, 0, line);
+		for (int i = 0; i < 2; i++)
+		{
+			int col = 14 + i * (BARWIDTH + 10);
+			int bar = int((unsigned long long)count[i][b] * BARWIDTH / most);
+			snprintf(line, sizeof(line), " %u", count[i][b]);
+			screen.put(8 + b, col, string(bar, '#') + line);
+		}
+	}
+}
+
+bool viewDashboard(const string& path, int refreshMs, ostream& out)
+{
+	Dashboard dashboard;
+	if (!dashboard.attach(path))
+		return false;
+	Screen screen(VIEWROWS, VIEWCOLS);
+	DashboardSnapshot s;
+	for (;;)
+	{
+		if (!dashboard.snapshot(s))
+			return false;
+		drawDashboard(s, screen);
+		screen.present(out);
+		if (s.finished)
+			return true;
+		this_thread::sleep_for(chrono::milliseconds(refreshMs));
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef DASHBOARD_INCLUDED
+#define DASHBOARD_INCLUDED
+
+#include "globals.h"
+#include <iosfwd>
+#include <string>
+
+class MappedFile;
+struct DashboardData;
+
+// What a viewer sees of a running tournament
+struct DashboardSnapshot
+{
+	std::string name[2];
+	int nGames;                 //games the tournament will play
+	unsigned long long gamesDone;
+	unsigned long long noResult;
+	unsigned long long wins[2];
+	double seconds;             //since the tournament started, or until it finished
+	bool finished;
+	unsigned int shotsToWin[2][MAXROWS * MAXCOLS + 1]; //how many games each entrant won in n shots
+	double gamesPerSecond() const { return seconds > 0 ? gamesDone / seconds : 0; }
+};
+
+// Live statistics of a tournament kept in a memory-mapped file, so that
+// another process can watch them while the games are played.  Workers only
+// do relaxed atomic adds, once per game; a viewer maps the file read-only
+// and takes snapshots whenever it likes.
+class Dashboard
+{
+public:
+	Dashboard();
+	~Dashboard();
+	bool create(const std::string& path, const std::string names[2], int nGames); //for the tournament
+	bool attach(const std::string& path);                                         //for a viewer
+	// winner is the entrant that won, or -1 if there was no result
+	void recordGame(int winner, int winnerShots);
+	void finish();
+	bool snapshot(DashboardSnapshot& s) const;
+	// We prevent a Dashboard object from being copied or assigned
+	Dashboard(const Dashboard&) = delete;
+	Dashboard& operator=(const Dashboard&) = delete;
+
+private:
+	MappedFile* m_file;
+	DashboardData* m_data;
+};
+
+// Shows the dashboard in path on the terminal every refreshMs milliseconds
+// until the tournament finishes.  Returns false if path can't be watched.
+bool viewDashboard(const std::string& path, int refreshMs, std::ostream& out);
+
+#endif // DASHBOARD_INCLUDED
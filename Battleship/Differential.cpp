@@ -0,0 +1,939 @@
+#include "Differential.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "Ruleset.h"
+#include "globals.h"
+#include <cctype>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Game::addShip explains its refusals on cout; the checks only want the answers
+class QuietCout
+{
+public:
+	QuietCout() : m_saved(cout.rdbuf(m_sink.rdbuf())) {}
+	~QuietCout() { cout.rdbuf(m_saved); }
+private:
+	ostringstream m_sink;
+	streambuf* m_saved;
+};
+
+//*********************************************************************
+//  Reference implementations
+//*********************************************************************
+
+// The original Game::addShip checks, without the messages
+bool referenceAddShip(int rows, int cols, const vector<ShipSpec>& ships, int length, char symbol)
+{
+	if (length < 1)
+		return false;
+	if (length > rows && length > cols)
+		return false;
+	if (!isascii(symbol) || !isprint(symbol))
+		return false;
+	if (symbol == 'X' || symbol == '.' || symbol == 'o')
+		return false;
+	int totalOfLengths = 0;
+	for (int s = 0; s < ships.size(); s++)
+	{
+		totalOfLengths += ships[s].length;
+		if (ships[s].symbol == symbol)
+			return false;
+	}
+	if (totalOfLengths + length > rows * cols)
+		return false;
+	return true;
+}
+
+// The original BoardImpl, except that unplaceShip checks every cell of a
+// horizontal ship.  The original checked column c+1 for each of them, so a
+// horizontal ship of length 1 was only removed if the cell to its right held
+// the same ship; Board has been fixed the same way.
+class ReferenceBoard
+{
+public:
+	ReferenceBoard(const Game& g);
+	void clear();
+	void block();
+	void unblock();
+	bool placeShip(Point topOrLeft, int shipId, Direction dir);
+	bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+	void render(bool shotsOnly, string& frame) const;
+	bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+	int shipsRemaining() const;
+	bool allShipsDestroyed() const;
+
+private:
+	vector<vector<char>> m_grid;
+	const Game& m_game;
+};
+
+ReferenceBoard::ReferenceBoard(const Game& g)
+	: m_game(g)
+{
+	vector<char> row(g.cols(), '.');
+	vector<vector<char>> grid(g.rows(), row);
+	m_grid = grid;
+}
+
+void ReferenceBoard::clear()
+{
+	vector<char> row(m_game.cols(), '.');
+	vector<vector<char>> grid(m_game.rows(), row);
+	m_grid = grid;
+}
+
+void ReferenceBoard::block()
+{
+	for (int r = 0; r < m_game.rows(); r++)
+		for (int c = 0; c < m_game.cols(); c++)
+			if (randInt(2) == 0)
+				m_grid[r][c] = 'X';
+}
+
+void ReferenceBoard::unblock()
+{
+	for (int r = 0; r < m_game.rows(); r++)
+		for (int c = 0; c < m_game.cols(); c++)
+			if (m_grid[r][c] == 'X')
+				m_grid[r][c] = '.';
+}
+
+bool ReferenceBoard::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+	if (shipId >= m_game.nShips() || shipId < 0)
+		return false;
+	if (!m_game.isValid(topOrLeft))
+		return false;
+	if (dir == VERTICAL && topOrLeft.r + m_game.shipLength(shipId) > m_game.rows())
+		return false;
+	if (dir == HORIZONTAL && topOrLeft.c + m_game.shipLength(shipId) > m_game.cols())
+		return false;
+	for (int i = 0; i < m_game.shipLength(shipId); i++)
+	{
+		char cell = (dir == VERTICAL ? m_grid[topOrLeft.r + i][topOrLeft.c] : m_grid[topOrLeft.r][topOrLeft.c + i]);
+		if (cell != '.')
+			return false;
+	}
+	for (int r = 0; r < m_grid.size(); r++)
+		for (int c = 0; c < m_grid[r].size(); c++)
+			if (m_grid[r][c] == m_game.shipSymbol(shipId))
+				return false;
+	for (int i = 0; i < m_game.shipLength(shipId); i++)
+	{
+		if (dir == VERTICAL)
+			m_grid[topOrLeft.r + i][topOrLeft.c] = m_game.shipSymbol(shipId);
+		else
+			m_grid[topOrLeft.r][topOrLeft.c + i] = m_game.shipSymbol(shipId);
+	}
+	return true;
+}
+
+bool ReferenceBoard::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+	if (shipId >= m_game.nShips() || shipId < 0)
+		return false;
+	if (!m_game.isValid(topOrLeft))
+		return false;
+	if (dir == VERTICAL && topOrLeft.r + m_game.shipLength(shipId) > m_game.rows())
+		return false;
+	if (dir == HORIZONTAL && topOrLeft.c + m_game.shipLength(shipId) > m_game.cols())
+		return false;
+	for (int i = 0; i < m_game.shipLength(shipId); i++)
+	{
+		if (dir == VERTICAL && m_grid[topOrLeft.r + i][topOrLeft.c] != m_game.shipSymbol(shipId))
+			return false;
+		if (dir == HORIZONTAL && m_grid[topOrLeft.r][topOrLeft.c + i] != m_game.shipSymbol(shipId))
+			return false;
+	}
+	for (int i = 0; i < m_game.shipLength(shipId); i++)
+	{
+		if (dir == VERTICAL)
+			m_grid[topOrLeft.r + i][topOrLeft.c] = '.';
+		else
+			m_grid[topOrLeft.r][topOrLeft.c + i] = '.';
+	}
+	return true;
+}
+
+void ReferenceBoard::render(bool shotsOnly, string& frame) const
+{
+	ostringstream out;
+	out << "  ";
+	for (int i = 0; i < m_grid[0].size(); i++)
+		out << i;
+	out << endl;
+	for (int i = 0; i < m_grid.size(); i++)
+	{
+		out << i << ' ';
+		for (int j = 0; j < m_grid[i].size(); j++)
+		{
+			char c = m_grid[i][j];
+			if (shotsOnly && c != '.' && c != 'X' && c != 'o')
+				out << '.';
+			else
+				out << c;
+		}
+		out << endl;
+	}
+	frame += out.str();
+}
+
+bool ReferenceBoard::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+	if (!m_game.isValid(p))
+		return false;
+	char c = m_grid[p.r][p.c];
+	if (c == 'X' || c == 'o')
+		return false;
+	if (c == '.')
+	{
+		m_grid[p.r][p.c] = 'o';
+		shotHit = false;
+		return true;
+	}
+	shotHit = true;
+	m_grid[p.r][p.c] = 'X';
+	int id;
+	for (id = 0; id < m_game.nShips(); id++)
+		if (c == m_game.shipSymbol(id))
+			break;
+	if (id >= m_game.nShips())
+		return false;
+	for (int i = 0; i < m_grid.size(); i++)
+	{
+		for (int j = 0; j < m_grid[i].size(); j++)
+		{
+			if (c == m_grid[i][j])
+			{
+				shipDestroyed = false;
+				return true;
+			}
+		}
+	}
+	shipDestroyed = true;
+	shipId = id;
+	return true;
+}
+
+int ReferenceBoard::shipsRemaining() const
+{
+	int n = 0;
+	for (int id = 0; id < m_game.nShips(); id++)
+	{
+		bool afloat = false;
+		for (int r = 0; r < m_grid.size(); r++)
+			for (int c = 0; c < m_grid[r].size(); c++)
+				if (m_grid[r][c] == m_game.shipSymbol(id))
+					afloat = true;
+		if (afloat)
+			n++;
+	}
+	return n;
+}
+
+bool ReferenceBoard::allShipsDestroyed() const
+{
+	for (int i = 0; i < m_grid.size(); i++)
+		for (int j = 0; j < m_grid[i].size(); j++)
+			if (m_grid[i][j] != 'X' && m_grid[i][j] != 'o' && m_grid[i][j] != '.')
+				return false;
+	return true;
+}
+
+// The original GoodPlayer: hunt by the product of each ship's placements
+// through a cell, counted by placing and removing ships on a board of its
+// own, and target by walking out from the hits
+class ReferenceGoodPlayer
+{
+public:
+	ReferenceGoodPlayer(const Game& g);
+	bool placeShips(ReferenceBoard& b);
+	Point recommendAttack();
+	void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+
+private:
+	const Game& game() const { return m_game; }
+	bool isAttacked(Point p);
+	bool shipRec(ReferenceBoard& b, int shipId);
+	const Game& m_game;
+	vector<Point> attacks;
+	ReferenceBoard m_b;
+	vector<bool> m_ships;
+	int state;
+	queue<Point> transition;
+	int dir;  //0=N, 1=E, 2=S, 3=W, -1=none
+};
+
+ReferenceGoodPlayer::ReferenceGoodPlayer(const Game& g)
+	: m_game(g), m_b(g), m_ships(g.nShips(), true), state(1), dir(-1)
+{}
+
+bool ReferenceGoodPlayer::isAttacked(Point p)
+{
+	for (int i = 0; i < attacks.size(); i++)
+		if (p.r == attacks[i].r && p.c == attacks[i].c)
+			return true;
+	return false;
+}
+
+bool ReferenceGoodPlayer::placeShips(ReferenceBoard& b)
+{
+	for (int i = 0; i < 50; i++)
+	{
+		b.block();
+		if (shipRec(b, 0))
+		{
+			b.unblock();
+			return true;
+		}
+		b.unblock();
+	}
+	return false;
+}
+
+bool ReferenceGoodPlayer::shipRec(ReferenceBoard& b, int shipId)
+{
+	if (shipId >= game().nShips())
+		return true;
+	for (int r = 0; r < game().rows(); r++)
+	{
+		for (int c = 0; c < game().cols(); c++)
+		{
+			for (int d = 0; d < 2; d++)
+			{
+				Direction dn = (d == 0 ? VERTICAL : HORIZONTAL);
+				if (b.placeShip(Point(r, c), shipId, dn))
+				{
+					if (shipRec(b, shipId + 1))
+						return true;
+					b.unplaceShip(Point(r, c), shipId, dn);
+				}
+			}
+		}
+	}
+	return false;
+}
+
+Point ReferenceGoodPlayer::recommendAttack()
+{
+	const int dr[4] = { -1, 0, 1, 0 };
+	const int dc[4] = { 0, 1, 0, -1 };
+	if (state == 2)
+	{
+		while (!transition.empty())
+		{
+			Point t = transition.front();
+			if (dir >= 0)
+			{
+				int limit = (dir % 2 == 0 ? game().rows() : game().cols());
+				for (int i = 2; i < limit; i++)
+				{
+					Point p(t.r + i * dr[dir], t.c + i * dc[dir]);
+					if (game().isValid(p) && !isAttacked(p))
+						return p;
+				}
+				dir = -1;
+			}
+			for (int d = 0; d < 4; d++)
+			{
+				Point p(t.r + dr[d], t.c + dc[d]);
+				if (game().isValid(p) && !isAttacked(p))
+					return p;
+			}
+			transition.pop();
+		}
+	}
+	vector<int> row(game().cols(), 1);
+	vector<vector<int>> probabilities(game().rows(), row);
+	for (int i = 0; i < game().nShips(); i++)
+	{
+		if (!m_ships[i])
+			continue;
+		vector<int> temp(game().cols(), 0);
+		vector<vector<int>> prob(game().rows(), temp);
+		for (int r = 0; r < game().rows(); r++)
+		{
+			for (int c = 0; c < game().cols(); c++)
+			{
+				if (m_b.placeShip(Point(r, c), i, VERTICAL))
+				{
+					for (int j = 0; j < game().shipLength(i); j++)
+						prob[r + j][c]++;
+					m_b.unplaceShip(Point(r, c), i, VERTICAL);
+				}
+				if (m_b.placeShip(Point(r, c), i, HORIZONTAL))
+				{
+					for (int j = 0; j < game().shipLength(i); j++)
+						prob[r][c + j]++;
+					m_b.unplaceShip(Point(r, c), i, HORIZONTAL);
+				}
+			}
+		}
+		for (int r = 0; r < probabilities.size(); r++)
+			for (int c = 0; c < probabilities[r].size(); c++)
+				probabilities[r][c] *= prob[r][c];
+	}
+	int maxProb = 0;
+	for (int r = 0; r < probabilities.size(); r++)
+		for (int c = 0; c < probabilities[r].size(); c++)
+			if (probabilities[r][c] > maxProb)
+				maxProb = probabilities[r][c];
+	vector<Point> targets;
+	for (int r = 0; r < probabilities.size(); r++)
+		for (int c = 0; c < probabilities[r].size(); c++)
+			if (probabilities[r][c] == maxProb)
+				targets.push_back(Point(r, c));
+	return targets[randInt(targets.size())];
+}
+
+void ReferenceGoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	bool a;
+	bool b;
+	int c;
+	m_b.attack(p, a, b, c);
+	attacks.push_back(p);
+	if (!validShot)
+		return;
+	if (!shotHit)
+	{
+		if (state == 2)
+			dir = -1;  //the direction was wrong; find it again
+		return;
+	}
+	if (shipDestroyed)
+	{
+		m_ships[shipId] = false;
+		dir = -1;
+		if (transition.empty())
+			state = 1;
+		else
+			transition.pop();
+		return;
+	}
+	transition.push(p);
+	if (state == 2 && dir == -1)
+	{
+		if (p.r == transition.front().r - 1)
+			dir = 0;
+		else if (p.c == transition.front().c + 1)
+			dir = 1;
+		else if (p.r == transition.front().r + 1)
+			dir = 2;
+		else if (p.c == transition.front().c - 1)
+			dir = 3;
+	}
+	if (state == 1)
+		state = 2;
+}
+
+//*********************************************************************
+//  Cases
+//*********************************************************************
+
+string pointStr(Point p)
+{
+	return to_string(p.r) + " " + to_string(p.c);
+}
+
+string flags(bool valid, bool hit, bool destroyed, int shipId)
+{
+	return string(valid ? "valid" : "invalid") + (hit ? " hit" : " miss") + (destroyed ? " destroyed " : " afloat ") +
+		to_string(shipId);
+}
+
+// Keeps dropping ships and rows and columns from rules for as long as the
+// case still fails with the smaller rules
+void shrinkRules(Ruleset& rules, const function<bool(const Ruleset&)>& fails)
+{
+	for (bool changed = true; changed; )
+	{
+		changed = false;
+		for (int i = 0; i < rules.ships.size() && rules.ships.size() > 1; i++)
+		{
+			Ruleset smaller = rules;
+			smaller.ships.erase(smaller.ships.begin() + i);
+			if (fails(smaller))
+			{
+				rules = smaller;
+				changed = true;
+				i--;
+			}
+		}
+		for (int d = 0; d < 2; d++)
+		{
+			Ruleset smaller = rules;
+			int& size = (d == 0 ? smaller.rows : smaller.cols);
+			for (size--; size >= 1 && fails(smaller); size--)
+			{
+				rules = smaller;
+				changed = true;
+			}
+		}
+	}
+}
+
+// Drops runs of operations, halving the run from half the case down to one
+// operation, for as long as the case still fails without them
+template <typename Op>
+void shrinkOps(vector<Op>& ops, const function<bool(const vector<Op>&)>& fails)
+{
+	for (int run = max(1, (int)ops.size() / 2); run >= 1; run /= 2)
+	{
+		for (int start = 0; start + run <= ops.size(); )
+		{
+			vector<Op> fewer(ops.begin(), ops.begin() + start);
+			fewer.insert(fewer.end(), ops.begin() + start + run, ops.end());
+			if (fails(fewer))
+				ops = fewer;
+			else
+				start++;
+		}
+	}
+}
+
+Ruleset randomRules(mt19937& rng, int minLength)
+{
+	Ruleset rules;
+	rules.rows = 1 + rng() % MAXROWS;
+	rules.cols = 1 + rng() % MAXCOLS;
+	int longest = max(rules.rows, rules.cols);
+	int nShips = 1 + rng() % 5;
+	int total = 0;
+	for (int i = 0; i < nShips; i++)
+	{
+		ShipSpec ship = { minLength + int(rng() % max(1, longest - minLength + 1)), char('A' + i), string(1, char('A' + i)) };
+		if (ship.length <= longest && total + ship.length <= rules.rows * rules.cols)
+		{
+			rules.ships.push_back(ship);
+			total += ship.length;
+		}
+	}
+	if (rules.ships.empty())
+		return Ruleset::standard();
+	return rules;
+}
+
+// false if the rules can't be set up, as can happen while shrinking
+bool setUp(const Ruleset& rules, Game& g)
+{
+	QuietCout quiet;
+	return rules.addShipsTo(g);
+}
+
+//******************** addShip cases **********************************
+
+struct AddShipCase
+{
+	int rows;
+	int cols;
+	vector<ShipSpec> tries;
+};
+
+bool runAddShipCase(const AddShipCase& ac, string& mismatch)
+{
+	mismatch.clear();
+	Game g(ac.rows, ac.cols);
+	vector<ShipSpec> added;
+	for (int i = 0; i < ac.tries.size(); i++)
+	{
+		const ShipSpec& s = ac.tries[i];
+		bool expected = referenceAddShip(ac.rows, ac.cols, added, s.length, s.symbol);
+		bool actual;
+		{
+			QuietCout quiet;
+			actual = g.addShip(s.length, s.symbol, s.name);
+		}
+		if (expected)
+			added.push_back(s);
+		if (actual != expected || g.nShips() != added.size())
+		{
+			mismatch = "addShip " + to_string(i + 1) + " returned " + (actual ? "true" : "false") + ", expected " +
+				(expected ? "true" : "false");
+			return false;
+		}
+		for (int j = 0; j < added.size(); j++)
+		{
+			if (g.shipLength(j) != added[j].length || g.shipSymbol(j) != added[j].symbol || g.shipName(j) != added[j].name)
+			{
+				mismatch = "after addShip " + to_string(i + 1) + " ship " + to_string(j) + " differs";
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//******************** Board cases ************************************
+
+enum BoardOpKind { PLACE, UNPLACE, ATTACK, SALVO, BLOCK, UNBLOCK, CLEAR };
+
+struct BoardOp
+{
+	BoardOpKind kind;
+	Point p;
+	int shipId;
+	Direction dir;
+	vector<Point> shots;     //fired by SALVO
+	unsigned int seed;       //BLOCK draws its cells after seedRandom(seed)
+	bool hitBefore;          //what attack's output parameters hold before the call
+	bool destroyedBefore;
+	int idBefore;
+};
+
+struct BoardCase
+{
+	Ruleset rules;
+	vector<BoardOp> ops;
+};
+
+string describe(const BoardOp& op)
+{
+	const char* dir = (op.dir == VERTICAL ? " vertical" : " horizontal");
+	switch (op.kind)
+	{
+	case PLACE:   return "place ship " + to_string(op.shipId) + " at " + pointStr(op.p) + dir;
+	case UNPLACE: return "unplace ship " + to_string(op.shipId) + " at " + pointStr(op.p) + dir;
+	case ATTACK:  return "attack " + pointStr(op.p);
+	case SALVO:
+	{
+		string s = "salvo";
+		for (int i = 0; i < op.shots.size(); i++)
+			s += (i == 0 ? " " : ", ") + pointStr(op.shots[i]);
+		return s;
+	}
+	case BLOCK:   return "block after seedRandom(" + to_string(op.seed) + ")";
+	case UNBLOCK: return "unblock";
+	default:      return "clear";
+	}
+}
+
+bool runBoardCase(const BoardCase& bc, string& mismatch)
+{
+	mismatch.clear();
+	Game g(bc.rules.rows, bc.rules.cols);
+	if (!setUp(bc.rules, g))
+		return true;
+	Board b(g);
+	ReferenceBoard rb(g);
+	for (int i = 0; i < bc.ops.size(); i++)
+	{
+		const BoardOp& op = bc.ops[i];
+		string what;
+		switch (op.kind)
+		{
+		case PLACE:
+		case UNPLACE:
+		{
+			bool actual = (op.kind == PLACE ? b.placeShip(op.p, op.shipId, op.dir) : b.unplaceShip(op.p, op.shipId, op.dir));
+			bool expected = (op.kind == PLACE ? rb.placeShip(op.p, op.shipId, op.dir) : rb.unplaceShip(op.p, op.shipId, op.dir));
+			if (actual != expected)
+				what = string("returned ") + (actual ? "true" : "false") + ", expected " + (expected ? "true" : "false");
+			break;
+		}
+		case ATTACK:
+		{
+			bool hit[2] = { op.hitBefore, op.hitBefore };
+			bool destroyed[2] = { op.destroyedBefore, op.destroyedBefore };
+			int id[2] = { op.idBefore, op.idBefore };
+			bool valid[2];
+			valid[0] = b.attack(op.p, hit[0], destroyed[0], id[0]);
+			valid[1] = rb.attack(op.p, hit[1], destroyed[1], id[1]);
+			if (valid[0] != valid[1] || hit[0] != hit[1] || destroyed[0] != destroyed[1] || id[0] != id[1])
+				what = "gave " + flags(valid[0], hit[0], destroyed[0], id[0]) + ", expected " +
+					flags(valid[1], hit[1], destroyed[1], id[1]);
+			break;
+		}
+		case SALVO:
+		{
+			//the reference fires the shots one at a time
+			vector<ShotResult> results;
+			b.attackMany(op.shots, results);
+			for (int j = 0; j < op.shots.size() && what.empty(); j++)
+			{
+				ShotResult expected;
+				expected.p = op.shots[j];
+				expected.shotHit = expected.shipDestroyed = false;
+				expected.shipId = -1;
+				expected.validShot = rb.attack(expected.p, expected.shotHit, expected.shipDestroyed, expected.shipId);
+				const ShotResult& actual = results[j];
+				if (results.size() != op.shots.size() || actual.p.r != expected.p.r || actual.p.c != expected.p.c ||
+					actual.validShot != expected.validShot || actual.shotHit != expected.shotHit ||
+					actual.shipDestroyed != expected.shipDestroyed || actual.shipId != expected.shipId)
+					what = "shot " + to_string(j + 1) + " gave " + flags(actual.validShot, actual.shotHit,
+						actual.shipDestroyed, actual.shipId) + ", expected " + flags(expected.validShot,
+						expected.shotHit, expected.shipDestroyed, expected.shipId);
+			}
+			break;
+		}
+		case BLOCK:
+			seedRandom(op.seed);
+			b.block();
+			seedRandom(op.seed);
+			rb.block();
+			break;
+		case UNBLOCK:
+			b.unblock();
+			rb.unblock();
+			break;
+		case CLEAR:
+			b.clear();
+			rb.clear();
+			break;
+		}
+		for (int shotsOnly = 0; shotsOnly < 2 && what.empty(); shotsOnly++)
+		{
+			string actual;
+			string expected;
+			b.render(shotsOnly != 0, actual);
+			rb.render(shotsOnly != 0, expected);
+			if (actual != expected)
+				what = "left the board as\n" + actual + "instead of\n" + expected;
+		}
+		if (what.empty() && b.shipsRemaining() != rb.shipsRemaining())
+			what = "left " + to_string(b.shipsRemaining()) + " ships afloat, expected " + to_string(rb.shipsRemaining());
+		if (what.empty() && b.allShipsDestroyed() != rb.allShipsDestroyed())
+			what = string("left allShipsDestroyed ") + (b.allShipsDestroyed() ? "true" : "false");
+		if (!what.empty())
+		{
+			mismatch = "operation " + to_string(i + 1) + " (" + describe(op) + ") " + what;
+			return false;
+		}
+	}
+	return true;
+}
+
+BoardOp randomBoardOp(mt19937& rng, const Ruleset& rules)
+{
+	//cells from just off the board on every side, and ship ids just out of range
+	auto point = [&]() { return Point(int(rng() % (rules.rows + 2)) - 1, int(rng() % (rules.cols + 2)) - 1); };
+	BoardOp op;
+	int k = rng() % 100;
+	op.kind = (k < 30 ? PLACE : k < 45 ? UNPLACE : k < 80 ? ATTACK : k < 88 ? SALVO : k < 93 ? BLOCK : k < 98 ? UNBLOCK : CLEAR);
+	op.p = point();
+	op.shipId = int(rng() % (rules.ships.size() + 2)) - 1;
+	op.dir = (rng() % 2 == 0 ? VERTICAL : HORIZONTAL);
+	for (int n = 1 + rng() % 6; op.kind == SALVO && n > 0; n--)
+		op.shots.push_back(point());
+	op.seed = rng();
+	op.hitBefore = (rng() % 2 == 0);
+	op.destroyedBefore = (rng() % 2 == 0);
+	op.idBefore = int(rng() % 8) - 2;
+	return op;
+}
+
+//******************** GoodPlayer games *******************************
+
+// A game is seeded, and may start with shots whose recommendations aren't
+// compared: both sides fire them instead of their own choices and are told
+// the results before play goes on.  A mismatch is shrunk to the shots before it and the one turn
+// after them that goes wrong, and then as many shots as can be are dropped.
+struct GoodGameCase
+{
+	GoodGameCase() : seed(0), checkOneTurn(false) {}
+	Ruleset rules;
+	unsigned int seed;
+	vector<Point> shots;
+	bool checkOneTurn;  //end the game after the first turn compared
+};
+
+// Plays one game of each GoodPlayer's shots at a board it placed itself,
+// the two sides drawing from the same random sequence.  played, if not
+// null, gets every shot fired before a mismatch.
+bool runGoodGame(const GoodGameCase& gc, string& mismatch, vector<Point>* played = nullptr)
+{
+	mismatch.clear();
+	if (played != nullptr)
+		played->clear();
+	const Ruleset& rules = gc.rules;
+	unsigned int seed = gc.seed;
+	Game g(rules.rows, rules.cols);
+	if (!setUp(rules, g))
+		return true;
+	Player* player = createPlayer("good", "good", g);
+	ReferenceGoodPlayer reference(g);
+	Board b(g);
+	ReferenceBoard rb(g);
+
+	seedRandom(seed);
+	bool placed = player->placeShips(b);
+	mt19937 after = randomGenerator();
+	seedRandom(seed);
+	bool expectedPlaced = reference.placeShips(rb);
+	string actual;
+	string expected;
+	b.render(false, actual);
+	rb.render(false, expected);
+	if (placed != expectedPlaced || actual != expected || !(randomGenerator() == after))
+		mismatch = "placing the ships gave\n" + actual + "instead of\n" + expected;
+
+	int lastTurn = (gc.checkOneTurn ? gc.shots.size() + 1 : 2 * rules.rows * rules.cols);
+	for (int turn = 1; mismatch.empty() && placed && !rb.allShipsDestroyed() && turn <= lastTurn; turn++)
+	{
+		mt19937 before = randomGenerator();
+		Point p = player->recommendAttack();
+		after = randomGenerator();
+		randomGenerator() = before;
+		Point q = reference.recommendAttack();
+		if (turn <= gc.shots.size())
+		{
+			//both still choose, so the random numbers go as in the game the
+			//shots came from, but they fire the shot given
+			p = q = gc.shots[turn - 1];
+			randomGenerator() = after;
+		}
+		else if (p.r != q.r || p.c != q.c || !(randomGenerator() == after))
+		{
+			mismatch = "turn " + to_string(turn) + " fired at " + pointStr(p) + ", expected " + pointStr(q) +
+				(randomGenerator() == after ? "" : ", and drew different random numbers");
+			break;
+		}
+		bool hit[2] = { false, false };
+		bool destroyed[2] = { false, false };
+		int id[2] = { -1, -1 };
+		bool valid[2];
+		valid[0] = b.attack(p, hit[0], destroyed[0], id[0]);
+		valid[1] = rb.attack(q, hit[1], destroyed[1], id[1]);
+		if (valid[0] != valid[1] || hit[0] != hit[1] || destroyed[0] != destroyed[1] || id[0] != id[1])
+		{
+			mismatch = "turn " + to_string(turn) + " shot gave " + flags(valid[0], hit[0], destroyed[0], id[0]) +
+				", expected " + flags(valid[1], hit[1], destroyed[1], id[1]);
+			break;
+		}
+		player->recordAttackResult(p, valid[0], hit[0], destroyed[0], id[0]);
+		reference.recordAttackResult(q, valid[1], hit[1], destroyed[1], id[1]);
+		if (played != nullptr)
+			played->push_back(p);
+	}
+	delete player;
+	return mismatch.empty();
+}
+
+//******************** DifferentialTester functions *******************
+
+DifferentialTester::DifferentialTester(unsigned int seed)
+	: m_rng(seed)
+{}
+
+int DifferentialTester::checkAddShip(int nCases, ostream& report)
+{
+	const char symbols[] = "ABCXo.\t ~";
+	int failed = 0;
+	for (int n = 0; n < nCases; n++)
+	{
+		AddShipCase ac;
+		ac.rows = 1 + m_rng() % MAXROWS;
+		ac.cols = 1 + m_rng() % MAXCOLS;
+		for (int k = 1 + m_rng() % 8; k > 0; k--)
+		{
+			ShipSpec s = { int(m_rng() % (MAXROWS + 3)) - 1, symbols[m_rng() % (sizeof(symbols) - 1)], "ship" };
+			ac.tries.push_back(s);
+		}
+		string mismatch;
+		if (runAddShipCase(ac, mismatch))
+			continue;
+		failed++;
+		shrinkOps<ShipSpec>(ac.tries, [&](const vector<ShipSpec>& tries) {
+			AddShipCase smaller = ac;
+			smaller.tries = tries;
+			string m;
+			return !runAddShipCase(smaller, m);
+		});
+		runAddShipCase(ac, mismatch);
+		report << "addShip mismatch on a " << ac.rows << "x" << ac.cols << " board:" << endl;
+		for (int i = 0; i < ac.tries.size(); i++)
+			report << "  addShip(" << ac.tries[i].length << ", " << int(ac.tries[i].symbol) << ")" << endl;
+		report << mismatch << endl;
+	}
+	return failed;
+}
+
+int DifferentialTester::checkBoards(int nCases, ostream& report)
+{
+	int failed = 0;
+	for (int n = 0; n < nCases; n++)
+	{
+		BoardCase bc;
+		bc.rules = randomRules(m_rng, 1);
+		for (int k = m_rng() % 60; k > 0; k--)
+			bc.ops.push_back(randomBoardOp(m_rng, bc.rules));
+		string mismatch;
+		if (runBoardCase(bc, mismatch))
+			continue;
+		failed++;
+		auto fails = [&](const BoardCase& c) {
+			string m;
+			return !runBoardCase(c, m);
+		};
+		shrinkOps<BoardOp>(bc.ops, [&](const vector<BoardOp>& ops) {
+			BoardCase smaller = bc;
+			smaller.ops = ops;
+			return fails(smaller);
+		});
+		shrinkRules(bc.rules, [&](const Ruleset& rules) {
+			BoardCase smaller = bc;
+			smaller.rules = rules;
+			return fails(smaller);
+		});
+		runBoardCase(bc, mismatch);
+		report << "Board mismatch with rules " << bc.rules.str() << ":" << endl;
+		for (int i = 0; i < bc.ops.size(); i++)
+			report << "  " << describe(bc.ops[i]) << endl;
+		report << mismatch << endl;
+	}
+	return failed;
+}
+
+int DifferentialTester::checkGoodPlayer(int nGames, int minLength, ostream& report)
+{
+	int failed = 0;
+	for (int n = 0; n < nGames; n++)
+	{
+		GoodGameCase gc;
+		gc.rules = (n % 4 == 0 ? Ruleset::standard() : randomRules(m_rng, minLength));
+		gc.seed = m_rng();
+		string mismatch;
+		vector<Point> played;
+		if (runGoodGame(gc, mismatch, &played))
+			continue;
+		gc.shots = played;
+		gc.checkOneTurn = true;
+		auto fails = [&](const GoodGameCase& c) {
+			string m;
+			return !runGoodGame(c, m);
+		};
+		for (int pass = 0; pass < 2; pass++)
+		{
+			shrinkOps<Point>(gc.shots, [&](const vector<Point>& shots) {
+				GoodGameCase smaller = gc;
+				smaller.shots = shots;
+				return fails(smaller);
+			});
+			if (pass == 0)
+				shrinkRules(gc.rules, [&](const Ruleset& rules) {
+					GoodGameCase smaller = gc;
+					smaller.rules = rules;
+					return fails(smaller);
+				});
+		}
+		runGoodGame(gc, mismatch);
+		failed++;
+		report << "GoodPlayer mismatch with rules " << gc.rules.str() << ", seed " << gc.seed;
+		if (!gc.shots.empty())
+		{
+			report << ", after shots at";
+			for (int i = 0; i < gc.shots.size(); i++)
+				report << (i == 0 ? " " : ", ") << pointStr(gc.shots[i]);
+		}
+		report << ":" << endl << mismatch << endl;
+	}
+	return failed;
+}
@@ -0,0 +1,37 @@
+#ifndef DIFFERENTIAL_INCLUDED
+#define DIFFERENTIAL_INCLUDED
+
+#include <iosfwd>
+#include <random>
+
+// Checks Game::addShip, Board and GoodPlayer against reference copies of
+// the original implementations kept in Differential.cpp.  Each case runs
+// both sides in lockstep on the same input: random sequences of addShip
+// calls, random sequences of Board operations (placing and removing ships,
+// attacks and salvos on any cell, blocking, clearing) on random rulesets,
+// and whole seeded games of GoodPlayer's shots.  Every return value and
+// output parameter is compared, and for the players the random numbers
+// they draw too.  A case that mismatches is shrunk, by dropping operations
+// (for games, shots replayed before the mismatch) and ships and shrinking
+// the board for as long as it still mismatches, and written to report as a
+// reproducer.  GoodPlayer plays with whatever EndgameTable is open, so when
+// the tables are loaded its lookups are checked against the original's
+// counting as well.
+class DifferentialTester
+{
+public:
+	DifferentialTester(unsigned int seed);
+	// Each returns the number of cases that mismatched
+	int checkAddShip(int nCases, std::ostream& report);
+	int checkBoards(int nCases, std::ostream& report);
+	// The games' random rulesets have ships of at least minLength cells
+	int checkGoodPlayer(int nGames, int minLength, std::ostream& report);
+	// We prevent a DifferentialTester object from being copied or assigned
+	DifferentialTester(const DifferentialTester&) = delete;
+	DifferentialTester& operator=(const DifferentialTester&) = delete;
+
+private:
+	std::mt19937 m_rng;  //draws the cases; the code under test uses randInt as usual
+};
+
+#endif // DIFFERENTIAL_INCLUDED
@@ -0,0 +1,156 @@
+#include "EndgameTable.h"
+#include "Platform.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int NFLEETS = EndgameTable::MAXLEN + EndgameTable::MAXLEN * (EndgameTable::MAXLEN + 1) / 2;
+const char MAGIC[8] = { 'B', 'S', 'E', 'N', 'D', 'G', 'M', '1' };
+
+struct EndgameHeader
+{
+	char magic[8];
+	int maxLen;
+	int nFleets;
+	int nKeys;
+};
+
+EndgameTable& EndgameTable::instance()
+{
+	static EndgameTable table;
+	return table;
+}
+
+EndgameTable::EndgameTable()
+	: m_file(nullptr), m_density(nullptr)
+{}
+
+EndgameTable::~EndgameTable()
+{
+	delete m_file;
+}
+
+bool EndgameTable::open(const string& path)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->openReadOnly(path))
+	{
+		delete file;
+		return false;
+	}
+	const EndgameHeader* header = static_cast<const EndgameHeader*>(file->data());
+	if (file->size() != sizeof(EndgameHeader) + NFLEETS * NKEYS || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header->maxLen != MAXLEN || header->nFleets != NFLEETS || header->nKeys != NKEYS)
+	{
+		delete file;
+		return false;
+	}
+	delete m_file;
+	m_file = file;
+	m_density = reinterpret_cast<const unsigned char*>(header + 1);
+	return true;
+}
+
+int EndgameTable::fleetIndex(int nShips, const int lengths[])
+{
+	//one ship of length a, then the pairs a <= b in order
+	if (nShips == 1)
+		return (lengths[0] >= 1 && lengths[0] <= MAXLEN) ? lengths[0] - 1 : -1;
+	if (nShips != 2)
+		return -1;
+	int a = min(lengths[0], lengths[1]);
+	int b = max(lengths[0], lengths[1]);
+	if (a < 1 || b > MAXLEN)
+		return -1;
+	int index = MAXLEN;
+	for (int i = 1; i < a; i++)
+		index += MAXLEN - i + 1;
+	return index + b - a;
+}
+
+//******************** generating the tables **************************
+
+// Placements of a ship of length len through a cell with these runs of
+// open cells before and after it along a line
+int placementsAlong(int len, int before, int after)
+{
+	int lo = max(0, len - 1 - after); //cells of the ship before the cell
+	int hi = min(before, len - 1);
+	return max(0, hi - lo + 1);
+}
+
+// The smallest key among the rotations and reflections of the runs
+int canonicalKey(int n, int e, int s, int w)
+{
+	int runs[4] = { n, e, s, w };
+	int best = EndgameTable::NKEYS;
+	for (int rotation = 0; rotation < 4; rotation++)
+	{
+		int r[4];
+		for (int d = 0; d < 4; d++)
+			r[d] = runs[(d + rotation) % 4];
+		best = min(best, EndgameTable::key(r[0], r[1], r[2], r[3]));
+		best = min(best, EndgameTable::key(r[0], r[3], r[2], r[1])); //mirrored east to west
+	}
+	return best;
+}
+
+void fillFleet(int nShips, const int lengths[], unsigned char* density)
+{
+	const int RUNS = EndgameTable::MAXRUN + 1;
+	vector<int> byCanonical(EndgameTable::NKEYS, -1);
+	for (int k = 0; k < EndgameTable::NKEYS; k++)
+	{
+		int n = k / (RUNS * RUNS * RUNS);
+		int e = k / (RUNS * RUNS) % RUNS;
+		int s = k / RUNS % RUNS;
+		int w = k % RUNS;
+		int& value = byCanonical[canonicalKey(n, e, s, w)];
+		if (value < 0)
+		{
+			value = 1;
+			for (int i = 0; i < nShips; i++)
+				value *= placementsAlong(lengths[i], w, e) + placementsAlong(lengths[i], n, s);
+		}
+		density[k] = value;
+	}
+}
+
+bool EndgameTable::generate(const string& path, int nThreads)
+{
+	string contents(sizeof(EndgameHeader) + NFLEETS * NKEYS, '\0');
+	EndgameHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.maxLen = MAXLEN;
+	header.nFleets = NFLEETS;
+	header.nKeys = NKEYS;
+	memcpy(&contents[0], &header, sizeof(header));
+	unsigned char* density = reinterpret_cast<unsigned char*>(&contents[sizeof(header)]);
+
+	if (nThreads <= 0)
+		nThreads = max(1, (int)thread::hardware_concurrency());
+	//every fleet's lengths, in the order of fleetIndex
+	vector<vector<int> > fleets;
+	for (int a = 1; a <= MAXLEN; a++)
+		fleets.push_back(vector<int>(1, a));
+	for (int a = 1; a <= MAXLEN; a++)
+		for (int b = a; b <= MAXLEN; b++)
+			fleets.push_back(vector<int>{ a, b });
+	atomic<int> next(0);
+	auto worker = [&]() {
+		for (int i = next++; i < NFLEETS; i = next++)
+			fillFleet(fleets[i].size(), &fleets[i][0], density + fleetIndex(fleets[i].size(), &fleets[i][0]) * NKEYS);
+	};
+	vector<thread> threads;
+	for (int t = 0; t < min(nThreads, NFLEETS); t++)
+		threads.push_back(thread(worker));
+	for (int t = 0; t < threads.size(); t++)
+		threads[t].join();
+	return writeFileAtomically(path, contents);
+}
@@ -0,0 +1,46 @@
+#ifndef ENDGAMETABLE_INCLUDED
+#define ENDGAMETABLE_INCLUDED
+
+#include <string>
+
+class MappedFile;
+
+// GoodPlayer's hunt-mode density at a cell once one or two ships are left,
+// looked up instead of counted.  A ship of length at most MAXLEN covering
+// a cell lies within MAXLEN-1 cells of it in its row or column, so the
+// count depends only on the open cells running out from the cell in each
+// direction, up to MAXLEN-1 of them.  Those four runs are the key, with
+// the lengths of the ships afloat in increasing order; cells that are
+// mirror images or rotations of each other share their entry.
+//
+// The tables are built offline by generate(), on several threads, into one
+// file that open() maps read-only, so every process using it shares the
+// same pages.  Without a file nothing is looked up.
+class EndgameTable
+{
+public:
+	static const int MAXLEN = 5;            //longest ship in the tables
+	static const int MAXRUN = MAXLEN - 1;   //longest run of open cells that matters
+	static const int NKEYS = (MAXRUN + 1) * (MAXRUN + 1) * (MAXRUN + 1) * (MAXRUN + 1);
+
+	static EndgameTable& instance();
+	~EndgameTable();
+	bool open(const std::string& path);
+	bool isOpen() const { return m_density != nullptr; }
+	static bool generate(const std::string& path, int nThreads);
+	// The table for one or two ships of these lengths, -1 if there is none
+	static int fleetIndex(int nShips, const int lengths[]);
+	// Runs of open cells north, east, south and west of a cell, each capped at MAXRUN
+	static int key(int n, int e, int s, int w) { return ((n * (MAXRUN + 1) + e) * (MAXRUN + 1) + s) * (MAXRUN + 1) + w; }
+	int density(int fleet, int key) const { return m_density[fleet * NKEYS + key]; }
+	// We prevent an EndgameTable object from being copied or assigned
+	EndgameTable(const EndgameTable&) = delete;
+	EndgameTable& operator=(const EndgameTable&) = delete;
+
+private:
+	EndgameTable();
+	MappedFile* m_file;
+	const unsigned char* m_density;  //[fleet][key]
+};
+
+#endif // ENDGAMETABLE_INCLUDED
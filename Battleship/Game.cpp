@@ -2,11 +2,18 @@
 #include "Board.h"
 #include "Player.h"
 #include "globals.h"
+#include "Renderer.h"
+#include "CellSet.h"
+#include "LayoutStore.h"
+#include "ShotStore.h"
+#include "TranscriptLog.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <cstdio>
 #include <vector>
+#include <chrono>
 
 using namespace std;
 
@@ -22,11 +29,32 @@ public:
 	int nShips() const;
 	int shipLength(int shipId) const;
 	char shipSymbol(int shipId) const;
-	string shipName(int shipId) const;
-	Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+	const string& shipName(int shipId) const;
+	Player* play(const Game& g, Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause, GameRecord* record);
+	void setTimeLimits(int msPerMove, int msPerGame);
+	void setTranscript(ostream* out);
+	void setTranscriptLog(TranscriptLog* log);
+	void setRenderMode(RenderMode mode);
+	void setObserver(GameObserver* observer);
+	void setSalvo(bool salvo);
 private:
+	void drawScreen(Player* players[2], Board* boards[2], bool showAll, const string& message);
+	void flushFrame(ostream* out);
 	int m_r;
 	int m_c;
+	int m_msPerMove;
+	int m_msPerGame;
+	ostream* m_out;
+	TranscriptLog* m_log;
+	RenderMode m_mode;
+	GameObserver* m_observer;
+	bool m_salvo;
+	vector<Point> m_shots;          //this turn's shots
+	vector<ShotResult> m_results;   //and what became of them
+	string m_frame;    //transcript text not yet written
+	string m_message;  //the last event, in RENDER_ANSI mode
+	string m_text;     //scratch for drawScreen
+	Screen m_screen;   //what the terminal shows in RENDER_ANSI mode
 	struct Ship  //struct to store all values of each ship
 	{
 		int m_len;
@@ -36,15 +64,77 @@ private:
 	vector<Ship> m_ships;  //vector to keep track of all ships
 };
 
+const int ANSIWIDTH = 80; //columns used by RENDER_ANSI
+
 void waitForEnter()
 {
 	cout << "Press enter to continue: ";
 	cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int nRows, int nCols) : m_r(nRows), m_c(nCols)
+GameImpl::GameImpl(int nRows, int nCols) : m_r(nRows), m_c(nCols), m_msPerMove(0), m_msPerGame(0), m_out(&cout),
+	m_log(nullptr), m_mode(RENDER_TEXT), m_observer(nullptr), m_salvo(false), m_screen(0, 0)
 {} //done
 
+void GameImpl::setTimeLimits(int msPerMove, int msPerGame)
+{
+	m_msPerMove = msPerMove;
+	m_msPerGame = msPerGame;
+}
+
+void GameImpl::setTranscript(ostream* out)
+{
+	m_out = out;
+}
+
+void GameImpl::setTranscriptLog(TranscriptLog* log)
+{
+	m_log = log;
+}
+
+void GameImpl::setRenderMode(RenderMode mode)
+{
+	m_mode = mode;
+}
+
+void GameImpl::setSalvo(bool salvo)
+{
+	m_salvo = salvo;
+}
+
+void GameImpl::setObserver(GameObserver* observer)
+{
+	m_observer = observer;
+}
+
+void GameImpl::flushFrame(ostream* out) //the transcript goes out in as few writes as possible
+{
+	if (out != nullptr && !m_frame.empty())
+	{
+		out->write(m_frame.data(), m_frame.size());
+		out->flush();
+	}
+	m_frame.clear();
+}
+
+void GameImpl::drawScreen(Player* players[2], Board* boards[2], bool showAll, const string& message)
+{
+	//both boards side by side with their owners' names above and the last event below;
+	//a computer's ships stay hidden from a human opponent unless showAll
+	m_screen.clear();
+	for (int i = 0; i < 2; i++)
+	{
+		const string& name = players[i]->name();
+		m_text.assign(name, 0, ANSIWIDTH / 2 - 2);
+		m_screen.put(0, i * (ANSIWIDTH / 2), m_text);
+		m_text.clear();
+		boards[i]->render(!showAll && players[1 - i]->isHuman(), m_text);
+		m_screen.put(1, i * (ANSIWIDTH / 2), m_text);
+	}
+	m_screen.put(m_r + 2, 0, message);
+	m_screen.present(*m_out);
+}
+
 int GameImpl::rows() const
 {
 	return m_r;
@@ -90,110 +180,227 @@ char GameImpl::shipSymbol(int shipId) const
 	return m_ships[shipId].m_sym;
 } //done
 
-string GameImpl::shipName(int shipId) const
+const string& GameImpl::shipName(int shipId) const
 {
 	return m_ships[shipId].m_name;
 } //done
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+Player* GameImpl::play(const Game& g, Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause, GameRecord* record)
 {
+	GameRecord scratch;
+	GameRecord& rec = (record != nullptr ? *record : scratch);
+	rec.winner = -1;
+	rec.turns = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		rec.shots[i] = rec.hits[i] = rec.lateMoves[i] = 0;
+		rec.timedOut[i] = false;
+		rec.moveLatency[i].clear();
+		for (int j = 0; j < GameRecord::MAXTIMEDSHIPS; j++)
+			rec.sunkAfter[i][j] = 0;
+	}
+
+	p1->recordOpponent(*p2);
+	p2->recordOpponent(*p1);
+
 	if (!p1->placeShips(b1))  //if either player is unable to place ships, return nullptr
 		return nullptr;
 	if (!p2->placeShips(b2))
 		return nullptr;
 
-	while ((!b1.allShipsDestroyed()) && (!b2.allShipsDestroyed())) //runs until either player wins, however, there are more checks for winner in this loop, so this should never be true
+	Player* players[2] = { p1, p2 };
+	Board* boards[2] = { &b1, &b2 };
+	double timeUsed[2] = { 0, 0 };
+	ostream* out = m_out;
+	//a human has to see the game as it is played, so only games between programs go to the log
+	TranscriptLog* log = (p1->isHuman() || p2->isHuman() ? nullptr : m_log);
+	if (log != nullptr)
 	{
-		//p1 turn
-		cout << p1->name() << "'s turn.  Board for " << p2->name() << ":" << endl;
-		b2.display(p1->isHuman());
+		out = nullptr;
+		const Player* seated[2] = { p1, p2 };
+		const Board* placed[2] = { &b1, &b2 };
+		log->startGame(g, seated, placed);
+	}
+	bool text = (out != nullptr && m_mode == RENDER_TEXT);
+	bool ansi = (out != nullptr && m_mode == RENDER_ANSI);
+	const size_t MAXFRAME = 64 * 1024; //write the transcript at least this often
+	m_frame.clear();
+	if (text)
+		m_frame.reserve(2 * MAXFRAME); //so that the turns never have to grow it
+	if (ansi)
+	{
+		m_screen.resize(m_r + 3, ANSIWIDTH);
+		drawScreen(players, boards, false, "");
+	}
 
-		bool shotHit = false;
-		bool shipDestroyed = false;
-		int shipId = -1;
+	for (int seat = 0; ; seat = 1 - seat) //players take turns until one wins
+	{
+		Player* attacker = players[seat];
+		Player* defender = players[1 - seat];
+		Board& target = *boards[1 - seat];
 
-		Point p = p1->recommendAttack();
-		bool validShot = b2.attack(p, shotHit, shipDestroyed, shipId);
-		p1->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
-		p2->recordAttackByOpponent(p);
+		if (log != nullptr)
+			log->turn(seat);
+		if (text)
+		{
+			describeTurn(m_frame, attacker->name(), defender->name());
+			target.render(attacker->isHuman(), m_frame);
+			if (attacker->isHuman()) //a human has to see the board before choosing
+				flushFrame(out);
+		}
 
-		if (validShot) //all outputs copy the given sample program
+		//the deadline is the move limit or whatever is left of the game limit, whichever comes first
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		Deadline deadline = noDeadline();
+		if (m_msPerMove > 0)
+			deadline = start + chrono::milliseconds(m_msPerMove);
+		if (m_msPerGame > 0)
 		{
-			if (shotHit)
-			{
-				if (shipDestroyed)
-					cout << p1->name() << " attacked (" << p.r << "," << p.c << ") and destroyed the " << shipName(shipId) << ", resulting in:" << endl;
-				else
-					cout << p1->name() << " attacked (" << p.r << "," << p.c << ") and hit something, resulting in:" << endl;
-			}
-			else
-				cout << p1->name() << " attacked (" << p.r << "," << p.c << ") and missed, resulting in:" << endl;
-			b2.display(p1->isHuman());
+			Deadline gameDeadline = start + chrono::microseconds((long long)((m_msPerGame / 1000.0 - timeUsed[seat]) * 1e6));
+			if (gameDeadline < deadline)
+				deadline = gameDeadline;
 		}
+		//a salvo has one shot for each of the attacker's ships still afloat
+		if (m_salvo)
+			attacker->recommendAttacks(boards[seat]->shipsRemaining(), m_shots, deadline);
 		else
+			m_shots.assign(1, attacker->recommendAttackBefore(deadline));
+		double took = secondsSince(start);
+		timeUsed[seat] += took;
+		rec.moveLatency[seat].record(took);
+		rec.shots[seat] += m_shots.size();
+		rec.turns++;
+
+		if (m_msPerGame > 0 && timeUsed[seat] * 1000 > m_msPerGame)
 		{
-			cout << p1->name() << " wasted a shot at (" << p.r << "," << p.c << ")." << endl;
+			string message = timeoutMessage(attacker->name(), defender->name());
+			if (log != nullptr)
+				log->timedOut(seat);
+			if (text)
+			{
+				m_frame += message;
+				flushFrame(out);
+			}
+			else if (ansi)
+				drawScreen(players, boards, defender->isHuman() || attacker->isHuman(), message);
+			rec.timedOut[seat] = true;
+			rec.winner = 1 - seat;
+			if (m_observer)
+				m_observer->turnPlayed(*p1, b1, *p2, b2, rec.turns, true);
+			return defender;
 		}
+		bool late = (m_msPerMove > 0 && took * 1000 > m_msPerMove);
 
-		if (b2.allShipsDestroyed()) //checks if p1 just won after this turn
+		if (late) //every shot of the turn is wasted
 		{
-			cout << p1->name() << " wins!" << endl;
-			if (p2->isHuman())  //if loser is human, display opponent's board
+			m_results.resize(m_shots.size());
+			for (int i = 0; i < m_shots.size(); i++)
 			{
-				cout << "Here's where " << p1->name() << "'s ships were:" << endl;
-				b1.display(false);
+				ShotResult wasted = { m_shots[i], false, false, false, -1 };
+				m_results[i] = wasted;
 			}
-			return p1;
+			rec.lateMoves[seat]++;
 		}
+		else if (m_salvo)
+			target.attackMany(m_shots, m_results);
+		else
+		{
+			m_results.resize(1);
+			ShotResult& res = m_results[0];
+			res.p = m_shots[0];
+			res.shotHit = res.shipDestroyed = false;
+			res.shipId = -1;
+			res.validShot = target.attack(res.p, res.shotHit, res.shipDestroyed, res.shipId);
+		}
+		int lastValid = -1;
+		for (int i = 0; i < m_results.size(); i++)
+		{
+			ShotResult& res = m_results[i];
+			res.shotHit = res.validShot && res.shotHit;
+			res.shipDestroyed = res.validShot && res.shipDestroyed;
+			if (res.shotHit)
+				rec.hits[seat]++;
+			if (res.shipDestroyed && res.shipId < GameRecord::MAXTIMEDSHIPS)
+				rec.sunkAfter[seat][res.shipId] = rec.shots[seat] - m_results.size() + i + 1;
+			if (res.validShot)
+				lastValid = i;
+		}
+		if (m_salvo)
+			attacker->recordSalvoResult(m_results);
+		else
+			attacker->recordAttackResult(m_results[0].p, m_results[0].validShot, m_results[0].shotHit,
+				m_results[0].shipDestroyed, m_results[0].shipId);
+		for (int i = 0; i < m_shots.size(); i++)
+			defender->recordAttackByOpponent(m_shots[i]);
+		bool won = target.allShipsDestroyed();
 
-		if (shouldPause)
-			waitForEnter();
-
-		//p2 turn (same as p1 turn, but for p2)
-		cout << p2->name() << "'s turn.  Board for " << p1->name() << ":" << endl;
-		b1.display(p2->isHuman());
-
-		p = p2->recommendAttack();
-
-		validShot = b1.attack(p, shotHit, shipDestroyed, shipId);
-		p2->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
-		p1->recordAttackByOpponent(p);
-
-		if (validShot)
+		if (log != nullptr)
+		{
+			for (int i = 0; i < m_results.size(); i++)
+				log->shot(seat, m_results[i], late, i == lastValid);
+			if (lastValid >= 0)
+				log->board(seat);
+			if (won)
+				log->won(seat);
+		}
+		if (text)
 		{
-			if (shotHit)
+			//the board is shown once, after the last shot that changed it
+			for (int i = 0; i < m_results.size(); i++)
+				describeShot(m_frame, g, attacker->name(), m_results[i], late, i == lastValid);
+			if (lastValid >= 0)
+				target.render(attacker->isHuman(), m_frame);
+			if (won)
 			{
-				if (shipDestroyed)
-					cout << p2->name() << " attacked (" << p.r << "," << p.c << ") and destroyed the " << shipName(shipId) << ", resulting in:" << endl;
-				else
-					cout << p2->name() << " attacked (" << p.r << "," << p.c << ") and hit something, resulting in:" << endl;
+				m_frame += attacker->name();
+				m_frame += " wins!\n";
+				if (defender->isHuman())  //if loser is human, display opponent's board
+				{
+					m_frame += "Here's where " + attacker->name() + "'s ships were:\n";
+					boards[seat]->render(false, m_frame);
+				}
 			}
-			else
-				cout << p2->name() << " attacked (" << p.r << "," << p.c << ") and missed, resulting in:" << endl;
-			b1.display(p2->isHuman());
+			if (won || shouldPause || m_frame.size() > MAXFRAME)
+				flushFrame(out);
 		}
-		else
+		else if (ansi)
 		{
-			cout << p2->name() << " wasted a shot at (" << p.r << "," << p.c << ")." << endl;
+			m_message.clear();
+			for (int i = 0; i < m_results.size(); i++)
+			{
+				if (!m_message.empty())
+					m_message += "  ";
+				describeShot(m_message, g, attacker->name(), m_results[i], late, false);
+				m_message.erase(m_message.size() - 1);
+			}
+			if (won)
+			{
+				m_message += "  ";
+				m_message += attacker->name();
+				m_message += " wins!";
+			}
+			drawScreen(players, boards, won && defender->isHuman(), m_message);
 		}
+		if (m_observer)
+			m_observer->turnPlayed(*p1, b1, *p2, b2, rec.turns, won);
 
-		if (b1.allShipsDestroyed())
+		if (won)
 		{
-			cout << p2->name() << " wins!" << endl;
-			if (p1->isHuman())
+			rec.winner = seat;
+			//the game is over, so both layouts are shown
+			for (int i = 0; i < 2 && LayoutStore::instance().isOpen(); i++)
 			{
-				cout << "Here's where " << p2->name() << "'s ships were:" << endl;
-				b2.display(false);
+				CellSet cells;
+				boards[i]->shipCells(cells);
+				LayoutStore::instance().recordLayout(opponentKey(*players[i]), cells);
 			}
-			return p2;
+			return attacker;
 		}
 
 		if (shouldPause)
 			waitForEnter();
 	}
-
-	return nullptr; //should never run
-} //TODO: CHECK THIS A LOT, IDK WHAT THE FUNCTIONS ACTUALLY DO AT THIS POINT
+}
 
   //******************** Game functions *******************************
 
@@ -301,18 +508,50 @@ char Game::shipSymbol(int shipId) const
 	return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string& Game::shipName(int shipId) const
 {
 	assert(shipId >= 0 && shipId < nShips());
 	return m_impl->shipName(shipId);
 }
 
-Player* Game::play(Player* p1, Player* p2, bool shouldPause)
+Player* Game::play(Player* p1, Player* p2, bool shouldPause, GameRecord* record)
 {
+	if (record != nullptr)
+		record->winner = -1;
 	if (p1 == nullptr || p2 == nullptr || nShips() == 0)
 		return nullptr;
 	Board b1(*this);
 	Board b2(*this);
-	return m_impl->play(p1, p2, b1, b2, shouldPause);
+	return m_impl->play(*this, p1, p2, b1, b2, shouldPause, record);
+}
+
+void Game::setTimeLimits(int msPerMove, int msPerGame)
+{
+	m_impl->setTimeLimits(msPerMove, msPerGame);
+}
+
+void Game::setTranscript(ostream* out)
+{
+	m_impl->setTranscript(out);
+}
+
+void Game::setTranscriptLog(TranscriptLog* log)
+{
+	m_impl->setTranscriptLog(log);
+}
+
+void Game::setRenderMode(RenderMode mode)
+{
+	m_impl->setRenderMode(mode);
+}
+
+void Game::setObserver(GameObserver* observer)
+{
+	m_impl->setObserver(observer);
+}
+
+void Game::setSalvo(bool salvo)
+{
+	m_impl->setSalvo(salvo);
 }
 
@@ -1,12 +1,45 @@
 #ifndef GAME_INCLUDED
 #define GAME_INCLUDED
 
+#include "Timing.h"
 #include <string>
+#include <iosfwd>
 #include <cassert>
 
 class Point;
 class Player;
+class Board;
 class GameImpl;
+class TranscriptLog;
+
+// How play shows a game: the classic scrolling transcript, or one screen
+// that is updated in place with ANSI escape sequences
+enum RenderMode {
+	RENDER_TEXT, RENDER_ANSI
+};
+
+// Told about every turn of a game, on the thread playing it
+class GameObserver
+{
+public:
+	virtual ~GameObserver() {}
+	virtual void turnPlayed(const Player& p1, const Board& b1, const Player& p2, const Board& b2,
+		int turn, bool gameOver) = 0;
+};
+
+// What happened in one game.  Index 0 is the player passed to play first.
+struct GameRecord
+{
+	int winner;           //0 or 1, -1 if the game could not be played
+	int turns;            //turns taken by both players together
+	int shots[2];
+	int hits[2];
+	bool timedOut[2];     //lost by using up the time for the game
+	int lateMoves[2];     //shots wasted by taking longer than the move limit
+	LatencyHistogram moveLatency[2]; //time spent deciding each shot
+	static const int MAXTIMEDSHIPS = 16;
+	int sunkAfter[2][MAXTIMEDSHIPS]; //shots player i had fired when it sank ship j, 0 if it didn't
+};
 
 class Game
 {
@@ -21,8 +54,24 @@ public:
 	int nShips() const;
 	int shipLength(int shipId) const;
 	char shipSymbol(int shipId) const;
-	std::string shipName(int shipId) const;
-	Player* play(Player* p1, Player* p2, bool shouldPause = true);
+	const std::string& shipName(int shipId) const;
+	Player* play(Player* p1, Player* p2, bool shouldPause = true, GameRecord* record = nullptr);
+	// A shot that takes longer than msPerMove is wasted, and a player whose
+	// shots take more than msPerGame altogether loses.  0 means no limit.
+	// Players can't be interrupted, so limits are checked when they return;
+	// the deadline passed to recommendAttackBefore tells them when to stop.
+	void setTimeLimits(int msPerMove, int msPerGame);
+	// Where play describes the game; nullptr plays silently.  Default cout.
+	void setTranscript(std::ostream* out);
+	// Games without a human player are described to log instead, which
+	// formats and writes them on its own thread.  nullptr, the default,
+	// goes back to the transcript.
+	void setTranscriptLog(TranscriptLog* log);
+	void setRenderMode(RenderMode mode);
+	void setObserver(GameObserver* observer);
+	// In the salvo variant each player fires, every turn, one shot for each
+	// of its ships still afloat, and learns the results all together
+	void setSalvo(bool salvo);
 	// We prevent a Game object from being copied or assigned
 	Game(const Game&) = delete;
 	Game& operator=(const Game&) = delete;
@@ -0,0 +1,435 @@
+#include "LayoutCounter.h"
+#include "Game.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int NCELLS = MAXROWS * MAXCOLS;
+const int SPLITDEPTH = 2;         //levels of the search cut into tasks for the threads
+const int MEMOMINSHIPS = 3;       //smaller subtrees are cheaper to redo than to look up
+const int MEMOCOUNTS = 1 << 18;   //remembered subtrees per thread when only counting
+const int MEMOCOVERS = 1 << 12;   //and when counting per cell, whose entries are far bigger
+
+void FleetObservations::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+	int cell = CellSet::index(p);
+	if (!shotHit)
+	{
+		missed.set(cell);
+		return;
+	}
+	hit.set(cell);
+	if (shipDestroyed && shipId >= 0 && shipId < sinkCell.size())
+		sinkCell[shipId] = cell;
+}
+
+// s moved k cells towards index 0
+CellSet shiftedDown(const CellSet& s, int k)
+{
+	CellSet t;
+	if (k == 0)
+		return s;
+	if (k >= 64)
+	{
+		t.w[0] = s.w[1] >> (k - 64);
+		return t;
+	}
+	t.w[0] = (s.w[0] >> k) | (s.w[1] << (64 - k));
+	t.w[1] = s.w[1] >> k;
+	return t;
+}
+
+// The observations worked into the fleet: for each level of the search, the
+// ship placed there and the placements still open to it
+struct Problem
+{
+	int nShips;
+	CellSet hit;
+	CellSet blocked;                  //missed cells and cells off the board
+	vector<vector<Placement>> choices;
+	vector<int> length;
+	vector<int> lengthLeft;           //total length of the ships from this level on
+	vector<bool> anywhere;            //afloat, so it may lie anywhere open but wholly on hits
+	vector<CellSet> acrossStart;      //cells where a placement of the ship can start, by direction
+	vector<CellSet> downStart;
+};
+
+void buildProblem(const PlacementTable& table, const FleetObservations& obs, Problem& pr)
+{
+	int n = table.nShips();
+	pr.nShips = n;
+	pr.hit = obs.hit;
+	pr.blocked = ~table.allCells() | obs.missed;
+	vector<vector<Placement>> choices(n);
+	for (int i = 0; i < n; i++)
+	{
+		const vector<Placement>& all = table.forShip(i);
+		int sink = (i < obs.sinkCell.size() ? obs.sinkCell[i] : -1);
+		for (int j = 0; j < all.size(); j++)
+		{
+			const CellSet& cells = all[j].cells;
+			if (cells.intersects(obs.missed))
+				continue;
+			if (sink >= 0 ? (!obs.hit.contains(cells) || !cells.test(sink)) : obs.hit.contains(cells))
+				continue;
+			choices[i].push_back(all[j]);
+		}
+	}
+
+	//sunk ships first, as they have the fewest choices, then the rest by number of choices
+	vector<int> order(n);
+	for (int i = 0; i < n; i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		bool aSunk = (a < obs.sinkCell.size() && obs.sinkCell[a] >= 0);
+		bool bSunk = (b < obs.sinkCell.size() && obs.sinkCell[b] >= 0);
+		return aSunk != bSunk ? aSunk : choices[a].size() < choices[b].size();
+	});
+	pr.choices.clear();
+	pr.length.clear();
+	pr.anywhere.clear();
+	pr.acrossStart.clear();
+	pr.downStart.clear();
+	for (int k = 0; k < n; k++)
+	{
+		int i = order[k];
+		int len = table.shipLength(i);
+		pr.choices.push_back(choices[i]);
+		pr.length.push_back(len);
+		pr.anywhere.push_back(i >= obs.sinkCell.size() || obs.sinkCell[i] < 0);
+		CellSet across;
+		CellSet down;
+		for (int r = 0; r < table.rows(); r++)
+		{
+			for (int c = 0; c < table.cols(); c++)
+			{
+				if (len > 1 && c + len <= table.cols()) //a one-cell ship is only ever listed as vertical
+					across.set(Point(r, c));
+				if (r + len <= table.rows())
+					down.set(Point(r, c));
+			}
+		}
+		pr.acrossStart.push_back(across);
+		pr.downStart.push_back(down);
+	}
+	pr.lengthLeft.assign(n + 1, 0);
+	for (int k = n - 1; k >= 0; k--)
+		pr.lengthLeft[k] = pr.lengthLeft[k + 1] + pr.length[k];
+}
+
+// A fixed-size table of subtree results keyed by level and occupied
+// mask.  A new result simply replaces whatever shared its slot.
+template<class Entry>
+class Memo
+{
+public:
+	Memo(int size) : m_slots(size) //size must be a power of 2
+	{
+		for (int i = 0; i < size; i++)
+			m_slots[i].depth = -1;
+	}
+	Entry& slot(const CellSet& occ, int depth)
+	{
+		unsigned long long h = occ.w[0] * 0x9E3779B97F4A7C15ULL ^ (occ.w[1] + depth) * 0xC2B2AE3D27D4EB4FULL;
+		return m_slots[(h ^ (h >> 29)) & (m_slots.size() - 1)];
+	}
+private:
+	vector<Entry> m_slots;
+};
+
+struct CountEntry
+{
+	CellSet occ;
+	int depth;
+	unsigned long long count;
+};
+
+struct CoverEntry
+{
+	CellSet occ;
+	int depth;
+	unsigned long long count;
+	unsigned long long cover[NCELLS];
+};
+
+// One thread's search, with its own memo so that threads never wait for each other
+class LayoutSearch
+{
+public:
+	LayoutSearch(const Problem& pr) : m_pr(pr) {}
+	unsigned long long count(int k, const CellSet& occ);
+	unsigned long long cover(int k, const CellSet& occ, unsigned long long out[NCELLS]);
+private:
+	int fits(int k, const CellSet& open) const;
+	const Problem& m_pr;
+	Memo<CountEntry>* countMemo();
+	Memo<CoverEntry>* coverMemo();
+	unique_ptr<Memo<CountEntry>> m_counts; //made on first use, as most searches need only one kind
+	unique_ptr<Memo<CoverEntry>> m_covers;
+};
+
+Memo<CountEntry>* LayoutSearch::countMemo()
+{
+	if (!m_counts)
+		m_counts.reset(new Memo<CountEntry>(MEMOCOUNTS));
+	return m_counts.get();
+}
+
+Memo<CoverEntry>* LayoutSearch::coverMemo()
+{
+	if (!m_covers)
+		m_covers.reset(new Memo<CoverEntry>(MEMOCOVERS));
+	return m_covers.get();
+}
+
+int LayoutSearch::fits(int k, const CellSet& open) const //placements of the ship at level k lying wholly on open cells
+{
+	CellSet across = open & m_pr.acrossStart[k];
+	CellSet down = open & m_pr.downStart[k];
+	for (int j = 1; j < m_pr.length[k]; j++)
+	{
+		across &= shiftedDown(open, j);
+		down &= shiftedDown(open, j * MAXCOLS);
+	}
+	return across.count() + down.count();
+}
+
+unsigned long long LayoutSearch::count(int k, const CellSet& occ)
+{
+	CellSet uncovered = m_pr.hit.minus(occ);
+	if (uncovered.count() > m_pr.lengthLeft[k])
+		return 0;
+	if (k == m_pr.nShips)
+		return 1;
+	if (k == m_pr.nShips - 1)
+	{
+		if (m_pr.anywhere[k] && uncovered.none())
+		{
+			CellSet open = ~occ;
+			return fits(k, open) - fits(k, open & m_pr.hit);
+		}
+		unsigned long long n = 0;
+		const vector<Placement>& choices = m_pr.choices[k];
+		for (int i = 0; i < choices.size(); i++)
+			if (!choices[i].cells.intersects(occ) && choices[i].cells.contains(uncovered))
+				n++;
+		return n;
+	}
+	bool remember = (m_pr.nShips - k >= MEMOMINSHIPS);
+	if (remember)
+	{
+		CountEntry& e = countMemo()->slot(occ, k);
+		if (e.depth == k && e.occ == occ)
+			return e.count;
+	}
+	unsigned long long total = 0;
+	const vector<Placement>& choices = m_pr.choices[k];
+	for (int i = 0; i < choices.size(); i++)
+		if (!choices[i].cells.intersects(occ))
+			total += count(k + 1, occ | choices[i].cells);
+	if (remember)
+	{
+		CountEntry& e = countMemo()->slot(occ, k); //the search below may have reused the slot
+		e.occ = occ;
+		e.depth = k;
+		e.count = total;
+	}
+	return total;
+}
+
+unsigned long long LayoutSearch::cover(int k, const CellSet& occ, unsigned long long out[NCELLS])
+{
+	CellSet uncovered = m_pr.hit.minus(occ);
+	if (uncovered.count() > m_pr.lengthLeft[k])
+		return 0;
+	if (k == m_pr.nShips)
+		return 1;
+	const vector<Placement>& choices = m_pr.choices[k];
+	if (k == m_pr.nShips - 1)
+	{
+		unsigned long long n = 0;
+		for (int i = 0; i < choices.size(); i++)
+		{
+			if (choices[i].cells.intersects(occ) || !choices[i].cells.contains(uncovered))
+				continue;
+			n++;
+			for (int j = 0; j < choices[i].len; j++)
+				out[choices[i].cell[j]]++;
+		}
+		return n;
+	}
+	if (m_pr.nShips - k < MEMOMINSHIPS)
+	{
+		unsigned long long total = 0;
+		for (int i = 0; i < choices.size(); i++)
+		{
+			if (choices[i].cells.intersects(occ))
+				continue;
+			unsigned long long n = cover(k + 1, occ | choices[i].cells, out);
+			total += n;
+			for (int j = 0; j < choices[i].len && n > 0; j++)
+				out[choices[i].cell[j]] += n;
+		}
+		return total;
+	}
+
+	CoverEntry* e = &coverMemo()->slot(occ, k);
+	if (e->depth != k || e->occ != occ)
+	{
+		unsigned long long sub[NCELLS] = {};
+		unsigned long long total = 0;
+		for (int i = 0; i < choices.size(); i++)
+		{
+			if (choices[i].cells.intersects(occ))
+				continue;
+			unsigned long long n = cover(k + 1, occ | choices[i].cells, sub);
+			total += n;
+			for (int j = 0; j < choices[i].len && n > 0; j++)
+				sub[choices[i].cell[j]] += n;
+		}
+		e = &coverMemo()->slot(occ, k);
+		e->occ = occ;
+		e->depth = k;
+		e->count = total;
+		for (int i = 0; i < NCELLS; i++)
+			e->cover[i] = sub[i];
+	}
+	for (int i = 0; i < NCELLS; i++)
+		out[i] += e->cover[i];
+	return e->count;
+}
+
+// The placements of the ships at the first levels of the search, which
+// together make one task for a thread
+struct LayoutTask
+{
+	CellSet occ;
+	short choice[SPLITDEPTH];
+};
+
+int splitIntoTasks(const Problem& pr, vector<LayoutTask>& tasks) //returns the level the tasks start at
+{
+	int split = min(SPLITDEPTH, pr.nShips - 1);
+	tasks.assign(1, LayoutTask());
+	tasks[0].occ = pr.blocked;
+	for (int k = 0; k < split; k++)
+	{
+		vector<LayoutTask> next;
+		for (int t = 0; t < tasks.size(); t++)
+		{
+			for (int i = 0; i < pr.choices[k].size(); i++)
+			{
+				if (pr.choices[k][i].cells.intersects(tasks[t].occ))
+					continue;
+				LayoutTask task = tasks[t];
+				task.occ |= pr.choices[k][i].cells;
+				task.choice[k] = i;
+				next.push_back(task);
+			}
+		}
+		tasks.swap(next);
+	}
+	return split;
+}
+
+// Calls work(thread, task) for every task, the tasks shared out among nThreads threads
+void runTasks(int nThreads, int nTasks, const function<void(int, int)>& work)
+{
+	atomic<int> next(0);
+	auto loop = [&](int t) {
+		for (int i = next++; i < nTasks; i = next++)
+			work(t, i);
+	};
+	nThreads = min(nThreads, nTasks);
+	if (nThreads <= 1)
+	{
+		loop(0);
+		return;
+	}
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++)
+		threads.push_back(thread(loop, t));
+	for (int t = 0; t < nThreads; t++)
+		threads[t].join();
+}
+
+//******************** LayoutCounter functions ************************
+
+LayoutCounter::LayoutCounter(const Game& g, int nThreads)
+	: m_table(PlacementTable::shared(g)), m_nThreads(nThreads)
+{
+	if (m_nThreads <= 0)
+		m_nThreads = max(1, (int)thread::hardware_concurrency());
+}
+
+LayoutCounter::LayoutCounter(int rows, int cols, const vector<int>& lengths, int nThreads)
+	: m_table(PlacementTable::shared(rows, cols, lengths)), m_nThreads(nThreads)
+{
+	if (m_nThreads <= 0)
+		m_nThreads = max(1, (int)thread::hardware_concurrency());
+}
+
+unsigned long long LayoutCounter::count(const FleetObservations& obs) const
+{
+	Problem pr;
+	buildProblem(m_table, obs, pr);
+	if (pr.nShips == 0)
+		return pr.hit.none() ? 1 : 0;
+	vector<LayoutTask> tasks;
+	int split = splitIntoTasks(pr, tasks);
+	vector<unique_ptr<LayoutSearch>> searches(m_nThreads);
+	vector<unsigned long long> totals(m_nThreads, 0);
+	runTasks(m_nThreads, tasks.size(), [&](int t, int i) {
+		if (!searches[t])
+			searches[t].reset(new LayoutSearch(pr));
+		totals[t] += searches[t]->count(split, tasks[i].occ);
+	});
+	unsigned long long total = 0;
+	for (int t = 0; t < m_nThreads; t++)
+		total += totals[t];
+	return total;
+}
+
+void LayoutCounter::count(const FleetObservations& obs, LayoutCount& result) const
+{
+	result.layouts = 0;
+	for (int r = 0; r < MAXROWS; r++)
+		for (int c = 0; c < MAXCOLS; c++)
+			result.covering[r][c] = 0;
+	Problem pr;
+	buildProblem(m_table, obs, pr);
+	if (pr.nShips == 0)
+	{
+		result.layouts = pr.hit.none() ? 1 : 0;
+		return;
+	}
+	vector<LayoutTask> tasks;
+	int split = splitIntoTasks(pr, tasks);
+	vector<unique_ptr<LayoutSearch>> searches(m_nThreads);
+	vector<unsigned long long> totals(m_nThreads, 0);
+	vector<vector<unsigned long long>> covers(m_nThreads, vector<unsigned long long>(NCELLS, 0));
+	runTasks(m_nThreads, tasks.size(), [&](int t, int i) {
+		if (!searches[t])
+			searches[t].reset(new LayoutSearch(pr));
+		unsigned long long* out = covers[t].data();
+		unsigned long long n = searches[t]->cover(split, tasks[i].occ, out);
+		totals[t] += n;
+		for (int k = 0; k < split && n > 0; k++) //the task's own ships
+		{
+			const Placement& pl = pr.choices[k][tasks[i].choice[k]];
+			for (int j = 0; j < pl.len; j++)
+				out[pl.cell[j]] += n;
+		}
+	});
+	for (int t = 0; t < m_nThreads; t++)
+	{
+		result.layouts += totals[t];
+		for (int i = 0; i < NCELLS; i++)
+			result.covering[i / MAXCOLS][i % MAXCOLS] += covers[t][i];
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef LAYOUTCOUNTER_INCLUDED
+#define LAYOUTCOUNTER_INCLUDED
+
+#include "globals.h"
+#include "CellSet.h"
+#include "Placements.h"
+#include <vector>
+
+class Game;
+
+// What has been seen of the opponent's board: the cells missed and hit, and
+// for each ship sunk the cell whose shot sank it
+struct FleetObservations
+{
+	FleetObservations(int nShips) : sinkCell(nShips, -1) {}
+	void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+
+	CellSet missed;
+	CellSet hit;                //includes the cells of sunk ships
+	std::vector<int> sinkCell;  //CellSet index per ship, -1 while it is afloat
+};
+
+struct LayoutCount
+{
+	unsigned long long layouts;
+	unsigned long long covering[MAXROWS][MAXCOLS]; //layouts with a ship on each cell
+	double probability(Point p) const { return layouts == 0 ? 0 : double(covering[p.r][p.c]) / layouts; }
+};
+
+// Counts exactly the layouts of a fleet that agree with a set of
+// observations: no ship on a missed cell, every hit covered, each sunk ship
+// wholly on hits and over its sinking cell, no ship afloat wholly on hits.
+// Ships are told apart, so two ships of a length swapped are two layouts;
+// the order in which the cells were shot is not used.
+//
+// The search places one ship at a time from bitmask placement lists, ships
+// with the fewest choices first.  Subtrees with three or more ships still
+// to place are remembered by their occupied mask, and the last ship is
+// counted in closed form where it can be.  The first two levels are split
+// into tasks shared out among nThreads threads (0 means one per core).
+// Counts are exact up to 2^64 layouts, which the standard fleet is far from.
+class LayoutCounter
+{
+public:
+	LayoutCounter(const Game& g, int nThreads);
+	LayoutCounter(int rows, int cols, const std::vector<int>& lengths, int nThreads);
+	unsigned long long count(const FleetObservations& obs) const;
+	void count(const FleetObservations& obs, LayoutCount& result) const; //also counts per cell
+
+private:
+	const PlacementTable& m_table;  //shared by every counter of the same board and fleet
+	int m_nThreads;
+};
+
+#endif // LAYOUTCOUNTER_INCLUDED
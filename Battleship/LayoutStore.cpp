@@ -0,0 +1,171 @@
+#include "LayoutStore.h"
+#include "CellSet.h"
+#include "Platform.h"
+#include "ShotStore.h"
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const int NSLOTS = 64;  //player/board-size combinations the store can tell apart
+const int NCELLS = MAXROWS * MAXCOLS;
+const char MAGIC[8] = { 'B', 'S', 'L', 'A', 'Y', 'O', 'U', '1' };
+
+struct LayoutSlot
+{
+	atomic<unsigned long long> key;  //0 while the slot is unclaimed
+	atomic<unsigned int> games;
+	atomic<unsigned int> occupied[NCELLS];  //games in which a ship was on the cell
+};
+
+struct LayoutStoreHeader
+{
+	char magic[8];
+	unsigned int nSlots;
+	unsigned int nCells;
+};
+
+const size_t STORE_BYTES = sizeof(LayoutStoreHeader) + NSLOTS * sizeof(LayoutSlot);
+
+static bool validStore(const MappedFile& file)
+{
+	const LayoutStoreHeader* header = static_cast<const LayoutStoreHeader*>(file.data());
+	return memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->nSlots == NSLOTS &&
+		header->nCells == NCELLS && file.size() >= STORE_BYTES;
+}
+
+LayoutStore& LayoutStore::instance()
+{
+	static LayoutStore store;
+	return store;
+}
+
+LayoutStore::LayoutStore()
+	: m_file(nullptr), m_slots(nullptr), m_frozenDepth(0)
+{}
+
+LayoutStore::~LayoutStore()
+{
+	delete m_file;
+}
+
+bool LayoutStore::open(const string& path)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->open(path, STORE_BYTES))
+	{
+		delete file;
+		return false;
+	}
+	LayoutStoreHeader* header = static_cast<LayoutStoreHeader*>(file->data());
+	if (header->nSlots == 0) //a new file
+	{
+		memcpy(header->magic, MAGIC, sizeof(MAGIC));
+		header->nSlots = NSLOTS;
+		header->nCells = NCELLS;
+	}
+	if (!validStore(*file))
+	{
+		delete file;
+		return false;
+	}
+	delete m_file;
+	m_file = file;
+	m_path = path;
+	m_slots = reinterpret_cast<LayoutSlot*>(header + 1);
+	return true;
+}
+
+LayoutSlot* LayoutStore::findSlot(LayoutSlot* slots, unsigned long long key, bool create)
+{
+	for (int i = 0; i < NSLOTS; i++) //linear probing; a slot once claimed is never released
+	{
+		LayoutSlot* slot = &slots[(key + i) % NSLOTS];
+		unsigned long long current = slot->key.load(memory_order_acquire);
+		if (current == key)
+			return slot;
+		if (current == 0)
+		{
+			if (!create)
+				return nullptr;
+			if (slot->key.compare_exchange_strong(current, key, memory_order_acq_rel) || current == key)
+				return slot;
+		}
+	}
+	return nullptr;  //store is full
+}
+
+void LayoutStore::recordLayout(unsigned long long player, const CellSet& shipCells)
+{
+	if (m_slots == nullptr || shipCells.none())
+		return;
+	LayoutSlot* slot = findSlot(m_slots, player, true);
+	if (slot == nullptr)
+		return;
+	CellSet cells = shipCells;
+	for (int i = cells.first(); i >= 0; cells.reset(i), i = cells.first())
+		slot->occupied[i].fetch_add(1, memory_order_relaxed);
+	slot->games.fetch_add(1, memory_order_relaxed);
+}
+
+bool LayoutStore::prior(unsigned long long player, int rows, int cols, int minGames, LayoutPrior& prior) const
+{
+	if (m_slots == nullptr)
+		return false;
+	LayoutSlot* slots = m_slots;
+	if (m_frozenDepth > 0 && !m_frozen.empty())
+		slots = reinterpret_cast<LayoutSlot*>(m_frozen.data());
+	LayoutSlot* slot = findSlot(slots, player, false);
+	if (slot == nullptr)
+		return false;
+	unsigned int games = slot->games.load(memory_order_relaxed);
+	if (games == 0 || games < minGames)
+		return false;
+	for (int r = 0; r < rows; r++)
+	{
+		for (int c = 0; c < cols; c++)
+		{
+			unsigned int occupied = slot->occupied[r * MAXCOLS + c].load(memory_order_relaxed);
+			if (occupied > games) //counters are read without a lock, so clamp
+				occupied = games;
+			prior.weight[r][c] = 1 + ((LayoutPrior::MAXWEIGHT - 1) * (unsigned long long)occupied + games / 2) / games;
+		}
+	}
+	return true;
+}
+
+void LayoutStore::freeze()
+{
+	if (m_frozenDepth++ > 0 || m_slots == nullptr)
+		return;
+	m_frozen.resize((NSLOTS * sizeof(LayoutSlot) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long));
+	memcpy(&m_frozen[0], m_slots, NSLOTS * sizeof(LayoutSlot));  //no game is playing, so nothing changes under us
+}
+
+void LayoutStore::thaw()
+{
+	if (m_frozenDepth > 0)
+		m_frozenDepth--;
+}
+
+bool LayoutStore::saveSnapshot(const string& path) const
+{
+	if (m_slots == nullptr)
+		return false;
+	const char* data = static_cast<const char*>(m_file->data());
+	return writeFileAtomically(path, string(data, data + STORE_BYTES));
+}
+
+bool LayoutStore::freezeFrom(const string& path)
+{
+	MappedFile snapshot;
+	if (m_slots == nullptr || !snapshot.openReadOnly(path) || snapshot.size() < sizeof(LayoutStoreHeader) ||
+		!validStore(snapshot))
+		return false;
+	m_frozenDepth++;
+	m_frozen.resize((NSLOTS * sizeof(LayoutSlot) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long));
+	memcpy(&m_frozen[0], static_cast<const LayoutStoreHeader*>(snapshot.data()) + 1, NSLOTS * sizeof(LayoutSlot));
+	return true;
+}
@@ -0,0 +1,59 @@
+#ifndef LAYOUTSTORE_INCLUDED
+#define LAYOUTSTORE_INCLUDED
+
+#include "globals.h"
+#include <string>
+#include <vector>
+
+class MappedFile;
+struct CellSet;
+struct LayoutSlot;
+
+// Weights for a density-based hunt, from 1 for cells a player has never
+// had a ship on to MAXWEIGHT for cells it always has
+struct LayoutPrior
+{
+	static const int MAXWEIGHT = 16;
+	unsigned char weight[MAXROWS][MAXCOLS];
+};
+
+// LayoutStore collects, across games, where each kind of player's ships
+// were: when a game ends both layouts are revealed, as a human loser is
+// shown the winner's.  Like ShotStore it is shared by every thread without
+// locks, keeps a count per cell for each opponentKey, lives in a
+// memory-mapped file so the counts carry over to later runs, is not in use
+// until open() succeeds, and can be frozen while a Tournament runs.
+class LayoutStore
+{
+public:
+	static LayoutStore& instance();
+	~LayoutStore();
+	bool open(const std::string& path);  //call before any games start
+	bool isOpen() const { return m_slots != nullptr; }
+	const std::string& path() const { return m_path; }
+	// player is the opponentKey of the player whose ships were on shipCells
+	void recordLayout(unsigned long long player, const CellSet& shipCells);
+	// Fills prior from the layouts player has used under these rules;
+	// returns false if fewer than minGames of them have been recorded
+	bool prior(unsigned long long player, int rows, int cols, int minGames, LayoutPrior& prior) const;
+	// As ShotStore's: until thaw, prior reads the counts as freeze found them
+	void freeze();
+	void thaw();
+	// As ShotStore's, for runs split between processes
+	bool saveSnapshot(const std::string& path) const;
+	bool freezeFrom(const std::string& path);
+	// We prevent a LayoutStore object from being copied or assigned
+	LayoutStore(const LayoutStore&) = delete;
+	LayoutStore& operator=(const LayoutStore&) = delete;
+
+private:
+	LayoutStore();
+	static LayoutSlot* findSlot(LayoutSlot* slots, unsigned long long key, bool create);
+	MappedFile* m_file;
+	std::string m_path;
+	LayoutSlot* m_slots;                      //nullptr until open() succeeds
+	mutable std::vector<unsigned long long> m_frozen; //the slots as freeze found them
+	int m_frozenDepth;
+};
+
+#endif // LAYOUTSTORE_INCLUDED
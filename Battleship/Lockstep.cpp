@@ -0,0 +1,300 @@
+#include "Lockstep.h"
+#include "Game.h"
+#include "globals.h"
+#include "CellSet.h"
+#include "ResultsFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int LANES = 64;
+const int NCELLS = MAXROWS * MAXCOLS;
+const int MAXSHIPS = GameRecord::MAXTIMEDSHIPS;
+
+enum LaneStrategy {
+	LANE_AWFUL, LANE_RANDOM, LANE_PARITY
+};
+
+int laneStrategy(const string& type) //-1 for types the engine can't play
+{
+	if (type == "awful")
+		return LANE_AWFUL;
+	if (type == "random")
+		return LANE_RANDOM;
+	if (type == "parity")
+		return LANE_PARITY;
+	return -1;
+}
+
+// Each lane draws from its own SplitMix64 sequence, seeded from the game number
+inline int laneRandInt(unsigned long long& state, int limit)
+{
+	return int(((splitMix64(state) >> 32) * (unsigned long long)limit) >> 32);
+}
+
+struct LockstepEngine::Batch
+{
+	unsigned long long ship[2][MAXSHIPS][NCELLS]; //bit l is set if lane l has ship j of seat s on the cell
+	unsigned char shotAt[2][NCELLS][LANES];       //which shot of the player in seat s hits the cell, from 1
+	unsigned char sunkAt[2][MAXSHIPS][LANES];     //the shot with which the player in seat s sinks ship j
+	unsigned char fired[2][LANES];                //shots the player in seat s gets to fire
+	unsigned char hits[2][LANES];
+	bool played[LANES];
+};
+
+LockstepEngine::LockstepEngine(const TournamentConfig& config)
+	: m_config(config), m_results(nullptr)
+{
+	for (int i = 0; i < 2; i++)
+		m_strategy[i] = laneStrategy(config.type[i]);
+}
+
+bool LockstepEngine::supports(const TournamentConfig& config)
+{
+	return laneStrategy(config.type[0]) >= 0 && laneStrategy(config.type[1]) >= 0 && !config.salvo &&
+		config.msPerMove == 0 && config.msPerGame == 0 && config.rules.ships.size() <= MAXSHIPS &&
+		config.rules.rows <= MAXROWS && config.rules.cols <= MAXCOLS;
+}
+
+TournamentResult LockstepEngine::run()
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	int nThreads = m_config.nThreads;
+	if (nThreads <= 0)
+		nThreads = max(1, (int)thread::hardware_concurrency());
+	int nBatches = (m_config.nGames + LANES - 1) / LANES;
+	nThreads = max(1, min(nThreads, nBatches));
+
+	ResultsWriter writer;
+	if (!m_config.results.empty())
+	{
+		if (writer.create(m_config.results, m_config.name, m_config.rules))
+			m_results = &writer;
+		else
+			cout << "Could not create results file " << m_config.results << endl;
+	}
+
+	vector<TournamentResult> results(nThreads);
+	atomic<int> next(0);
+	auto worker = [&](int t) {
+		Batch* batch = new Batch;
+		ResultsBlock* rows = (m_results != nullptr ? new ResultsBlock : nullptr);
+		for (int b = next++; b < nBatches; b = next++)
+		{
+			int first = m_config.firstGame + b * LANES;
+			playBatch(first, min(LANES, m_config.firstGame + m_config.nGames - first), *batch, results[t], rows);
+		}
+		if (rows != nullptr)
+			m_results->write(*rows);
+		delete rows;
+		delete batch;
+	};
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++)
+		threads.push_back(thread(worker, t));
+	TournamentResult total;
+	for (int t = 0; t < nThreads; t++)
+	{
+		threads[t].join();
+		total.merge(results[t]);
+	}
+	writer.close();
+	m_results = nullptr;
+	total.seconds = secondsSince(start);
+	return total;
+}
+
+void LockstepEngine::playBatch(int firstGame, int nGames, Batch& batch, TournamentResult& result,
+	ResultsBlock* resultRows) const
+{
+	const int rows = m_config.rules.rows;
+	const int cols = m_config.rules.cols;
+	const int nShips = m_config.rules.ships.size();
+	unsigned char cells[NCELLS];
+	int nCells = 0;
+	for (int r = rows - 1; r >= 0; r--) //the order AwfulPlayer fires in
+		for (int c = cols - 1; c >= 0; c--)
+			cells[nCells++] = CellSet::index(Point(r, c));
+	memset(batch.ship, 0, sizeof(batch.ship));
+
+	//set up each lane's layouts and shots, one lane at a time
+	for (int l = 0; l < nGames; l++)
+	{
+		int k = firstGame + l;
+		unsigned long long rng = ((unsigned long long)m_config.seed << 32) ^ (unsigned int)k;
+		int first = k % 2; //entrant sitting in seat 0
+		batch.played[l] = true;
+		for (int seat = 0; seat < 2; seat++)
+		{
+			int strategy = m_strategy[seat ^ first];
+			CellSet used;
+			bool placed = false;
+			CellSet layout[MAXSHIPS];
+			if (strategy == LANE_AWFUL) //each ship at the left of its own row, as AwfulPlayer does
+			{
+				placed = (nShips <= rows);
+				for (int i = 0; i < nShips && placed; i++)
+				{
+					placed = (m_config.rules.ships[i].length <= cols);
+					for (int j = 0; j < m_config.rules.ships[i].length && placed; j++)
+						layout[i].set(Point(i, j));
+				}
+			}
+			else //random top or left cells and directions, as HunterPlayer does
+			{
+				for (int attempt = 0; attempt < 50 && !placed; attempt++)
+				{
+					used.clear();
+					int i;
+					for (i = 0; i < nShips; i++)
+					{
+						int len = m_config.rules.ships[i].length;
+						int tries;
+						for (tries = 0; tries < 100; tries++)
+						{
+							Point p(laneRandInt(rng, rows), laneRandInt(rng, cols));
+							bool across = (laneRandInt(rng, 2) == 0);
+							if ((across ? p.c : p.r) + len > (across ? cols : rows))
+								continue;
+							CellSet s;
+							for (int j = 0; j < len; j++)
+								s.set(across ? Point(p.r, p.c + j) : Point(p.r + j, p.c));
+							if (s.intersects(used))
+								continue;
+							layout[i] = s;
+							used |= s;
+							break;
+						}
+						if (tries == 100)
+							break;
+					}
+					placed = (i == nShips);
+				}
+			}
+			if (!placed)
+			{
+				batch.played[l] = false;
+				continue;
+			}
+			for (int i = 0; i < nShips; i++)
+				for (int c = layout[i].first(); c >= 0; layout[i].reset(c), c = layout[i].first())
+					batch.ship[seat][i][c] |= 1ULL << l;
+
+			//the order of the shots: awful scans, the hunters shuffle
+			unsigned char order[NCELLS];
+			memcpy(order, cells, nCells);
+			if (strategy != LANE_AWFUL)
+			{
+				int nFirst = 0;
+				if (strategy == LANE_PARITY) //even cells first
+				{
+					for (int i = 0; i < nCells; i++)
+					{
+						Point p = CellSet::point(order[i]);
+						if ((p.r + p.c) % 2 == 0)
+							swap(order[i], order[nFirst++]);
+					}
+				}
+				for (int i = nFirst - 1; i > 0; i--)
+					swap(order[i], order[laneRandInt(rng, i + 1)]);
+				for (int i = nCells - 1; i > nFirst; i--)
+					swap(order[nFirst + laneRandInt(rng, i - nFirst + 1)], order[i]);
+			}
+			for (int i = 0; i < nCells; i++)
+				batch.shotAt[seat][order[i]][l] = i + 1;
+		}
+	}
+	for (int l = nGames; l < LANES; l++)
+		batch.played[l] = false;
+
+	//the shot that sinks each ship is the attacker's latest at its cells
+	for (int seat = 0; seat < 2; seat++)
+	{
+		int defender = 1 - seat;
+		for (int i = 0; i < nShips; i++)
+		{
+			unsigned char* sunk = batch.sunkAt[seat][i];
+			memset(sunk, 0, LANES);
+			for (int c = 0; c < NCELLS; c++)
+			{
+				const unsigned char* shot = batch.shotAt[seat][c];
+				for (unsigned long long w = batch.ship[defender][i][c]; w != 0; w &= w - 1)
+				{
+					int l = CellSet::lowBit(w);
+					sunk[l] = max(sunk[l], shot[l]);
+				}
+			}
+		}
+	}
+
+	//seat 0 fires first, so it wins ties
+	for (int l = 0; l < LANES; l++)
+	{
+		int needed[2] = { 0, 0 }; //shots each seat needs to sink every ship
+		for (int seat = 0; seat < 2; seat++)
+			for (int i = 0; i < nShips; i++)
+				needed[seat] = max(needed[seat], (int)batch.sunkAt[seat][i][l]);
+		batch.fired[0][l] = (needed[0] <= needed[1] ? needed[0] : needed[1]);
+		batch.fired[1][l] = (needed[0] <= needed[1] ? needed[0] - 1 : needed[1]);
+	}
+	memset(batch.hits, 0, sizeof(batch.hits));
+	for (int seat = 0; seat < 2; seat++)
+	{
+		int defender = 1 - seat;
+		for (int i = 0; i < nShips; i++)
+		{
+			for (int c = 0; c < NCELLS; c++)
+			{
+				const unsigned char* shot = batch.shotAt[seat][c];
+				for (unsigned long long w = batch.ship[defender][i][c]; w != 0; w &= w - 1)
+				{
+					int l = CellSet::lowBit(w);
+					if (shot[l] <= batch.fired[seat][l])
+						batch.hits[seat][l]++;
+				}
+			}
+		}
+	}
+
+	GameRecord rec;
+	for (int l = 0; l < nGames; l++)
+	{
+		int k = firstGame + l;
+		int first = k % 2;
+		result.games++;
+		if (!batch.played[l])
+		{
+			result.noResult++;
+			continue;
+		}
+		rec.shots[0] = batch.fired[0][l];
+		rec.shots[1] = batch.fired[1][l];
+		rec.winner = (rec.shots[0] > rec.shots[1] ? 0 : 1); //the winner fired last
+		rec.turns = rec.shots[0] + rec.shots[1];
+		for (int seat = 0; seat < 2; seat++)
+		{
+			rec.hits[seat] = batch.hits[seat][l];
+			rec.timedOut[seat] = false;
+			rec.lateMoves[seat] = 0;
+			for (int i = 0; i < MAXSHIPS; i++)
+				rec.sunkAfter[seat][i] = 0;
+			for (int i = 0; i < nShips; i++)
+				if (batch.sunkAt[seat][i][l] <= rec.shots[seat])
+					rec.sunkAfter[seat][i] = batch.sunkAt[seat][i][l];
+		}
+		result.wins[rec.winner ^ first]++;
+		result.stats.record(rec, first);
+		if (resultRows != nullptr)
+		{
+			resultRows->record(k, m_config.seed, first, rec);
+			if (resultRows->full())
+				m_results->write(*resultRows);
+		}
+	}
+}
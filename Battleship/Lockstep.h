@@ -0,0 +1,41 @@
+#ifndef LOCKSTEP_INCLUDED
+#define LOCKSTEP_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+
+class ResultsWriter;
+struct ResultsBlock;
+
+// Plays a tournament 64 games at a time between players whose shots never
+// depend on what they hit: awful, random and parity.  Such a player's
+// whole sequence of shots is known when the game starts, so a game needs
+// no turns: a player sinks a ship with the last of its shots at the ship's
+// cells, and wins if it sinks the last ship before its opponent does.
+//
+// The 64 games of a batch are its lanes.  Layouts are stored bit-sliced,
+// one word per ship and cell with a bit per lane, and each player's shots
+// as the shot number per cell with the lanes side by side, so a batch is
+// resolved by walking the set bits of the layout words.  Results have the
+// same form as a Tournament's, and each game is seeded from its number,
+// but from a generator of the engine's own, so the games themselves are
+// not the ones Game::play would have.
+class LockstepEngine
+{
+public:
+	LockstepEngine(const TournamentConfig& config);
+	static bool supports(const TournamentConfig& config); //the types, rules and options it can play
+	TournamentResult run();
+	// We prevent a LockstepEngine object from being copied or assigned
+	LockstepEngine(const LockstepEngine&) = delete;
+	LockstepEngine& operator=(const LockstepEngine&) = delete;
+
+private:
+	struct Batch;
+	void playBatch(int firstGame, int nGames, Batch& batch, TournamentResult& result, ResultsBlock* resultRows) const;
+	TournamentConfig m_config;
+	int m_strategy[2];  //per entrant
+	ResultsWriter* m_results;
+};
+
+#endif // LOCKSTEP_INCLUDED
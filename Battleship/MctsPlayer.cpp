@@ -0,0 +1,762 @@
+#include "MctsPlayer.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include "CellSet.h"
+#include "Placements.h"
+#include "TranspositionTable.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// MctsPlayer plans its shots with information-set Monte Carlo tree search.
+// The opponent's layout is hidden, so every iteration first samples a
+// layout consistent with everything seen so far, then walks down a tree
+// that is shared by all samples.  Edges of the tree are shots; below an
+// edge there is one node per possible result of that shot (miss, hit,
+// which ship sank).  After the walk the game is played out quickly on the
+// sampled layout, and the fraction of the board left unshot is the reward.
+//
+// Several threads grow the same tree.  A thread counts its visit to an
+// edge as soon as it chooses the edge and adds the reward only at the end,
+// which makes the edge look worse in the meantime ("virtual loss") and
+// steers the other threads elsewhere.  The helper threads come from a
+// SearchPool shared by every MctsPlayer, so none are started per move and
+// the players of a multithreaded tournament don't each bring their own.  After a real shot the subtree for
+// its actual result becomes the new root, so earlier work is kept.
+//
+// Every search leaves its best shot in the shared transposition table,
+// keyed by the canonical hash of what we know, so the same position in a
+// later game (or an equivalent one under a symmetry) doesn't start from
+// scratch: a fresh root tries the remembered shot first.
+
+const int NCELLS = MAXROWS * MAXCOLS;
+const int MAXSHIPS = MAXROWS * MAXCOLS;
+const int MAXPLACEMENTS = 2 * NCELLS;
+const double EXPLORATION = 0.4;   //UCB constant; rewards are between 0 and 1
+const double PRIORWEIGHT = 0.5;   //how strongly the density prior steers a young edge
+const int MAXSAMPLESTEPS = 4000;  //backtracking budget for sampling one hidden layout
+
+// Results of a shot: a miss, a hit, or OUTCOME_SUNK + the id of the ship sunk
+const int OUTCOME_MISS = 0;
+const int OUTCOME_HIT = 1;
+const int OUTCOME_SUNK = 2;
+
+// What the searching player knows about the opponent's board
+struct Knowledge
+{
+	CellSet shot;
+	CellSet missed;
+	CellSet hit;        //includes the cells of sunk ships
+	CellSet sinkCells;  //cells whose shot sank a ship
+	signed char sinkCell[MAXSHIPS];  //per ship, -1 while it is afloat
+	void apply(int cell, int outcome);
+};
+
+void Knowledge::apply(int cell, int outcome)
+{
+	shot.set(cell);
+	if (outcome == OUTCOME_MISS)
+	{
+		missed.set(cell);
+		return;
+	}
+	hit.set(cell);
+	if (outcome >= OUTCOME_SUNK)
+	{
+		sinkCell[outcome - OUTCOME_SUNK] = cell;
+		sinkCells.set(cell);
+	}
+}
+
+// One sampled opponent layout, as it changes during a playout
+struct Layout
+{
+	signed char shipAt[NCELLS];  //-1 for water
+	unsigned char left[MAXSHIPS]; //cells of the ship not yet hit
+	CellSet ship[MAXSHIPS];
+	CellSet unsunkHits;
+	int shipsLeft;
+};
+
+struct MctsNode;
+
+struct MctsEdge
+{
+	MctsEdge(int c, double p) : cell(c), prior(p), visits(0), reward(0) {}
+	~MctsEdge();
+	int cell;
+	double prior;
+	atomic<int> visits;
+	atomic<long long> reward;  //sum of rewards, in millionths
+	mutex lock;                //guards children
+	vector<pair<int, MctsNode*>> children; //one per result seen so far
+};
+
+struct MctsNode
+{
+	MctsNode() : visits(0), expanded(false) {}
+	~MctsNode();
+	atomic<int> visits;
+	atomic<bool> expanded;
+	mutex lock;                //guards expansion
+	vector<MctsEdge*> edges;   //best prior first; fixed once expanded is set
+};
+
+MctsEdge::~MctsEdge()
+{
+	for (int i = 0; i < children.size(); i++)
+		delete children[i].second;
+}
+
+MctsNode::~MctsNode()
+{
+	for (int i = 0; i < edges.size(); i++)
+		delete edges[i];
+}
+
+//*********************************************************************
+//  SearchPool
+//*********************************************************************
+
+// One thread per core but one, started when the first search wants help and
+// kept until the program ends.  A search runs its step function on its own
+// thread and posts a job that up to nHelpers idle pool threads join; with
+// more searches than cores, each gets whatever helpers are free.
+class SearchPool
+{
+public:
+	static SearchPool& instance();
+	~SearchPool();
+	// Calls step on this thread and on up to nHelpers pool threads until
+	// deadline, and returns once every one of them has stopped
+	void run(const function<void()>& step, chrono::steady_clock::time_point deadline, int nHelpers);
+	// We prevent a SearchPool object from being copied or assigned
+	SearchPool(const SearchPool&) = delete;
+	SearchPool& operator=(const SearchPool&) = delete;
+
+private:
+	struct Job
+	{
+		const function<void()>* step;
+		chrono::steady_clock::time_point deadline;
+		int wanted;   //helpers it can still take
+		int working;  //helpers on it now
+	};
+	SearchPool();
+	void help();
+	mutex m_mutex;
+	condition_variable m_posted;  //a job was posted, or the pool is stopping
+	condition_variable m_left;    //a helper finished its part of a job
+	vector<Job*> m_jobs;
+	vector<thread> m_threads;
+	bool m_stopping;
+};
+
+SearchPool& SearchPool::instance()
+{
+	static SearchPool pool;
+	return pool;
+}
+
+SearchPool::SearchPool()
+	: m_stopping(false)
+{
+	for (int t = 1; t < (int)thread::hardware_concurrency(); t++)
+		m_threads.push_back(thread(&SearchPool::help, this));
+}
+
+SearchPool::~SearchPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_posted.notify_all();
+	for (int t = 0; t < m_threads.size(); t++)
+		m_threads[t].join();
+}
+
+void SearchPool::run(const function<void()>& step, chrono::steady_clock::time_point deadline, int nHelpers)
+{
+	Job job = { &step, deadline, min(nHelpers, (int)m_threads.size()), 0 };
+	bool posted = (job.wanted > 0);
+	if (posted)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_jobs.push_back(&job);
+		}
+		m_posted.notify_all();
+	}
+	while (chrono::steady_clock::now() < deadline)
+		step();
+	if (!posted)
+		return;
+	unique_lock<mutex> lock(m_mutex);
+	m_jobs.erase(remove(m_jobs.begin(), m_jobs.end(), &job), m_jobs.end());
+	m_left.wait(lock, [&job]() { return job.working == 0; });
+}
+
+void SearchPool::help()
+{
+	unique_lock<mutex> lock(m_mutex);
+	for (;;)
+	{
+		Job* job = nullptr;
+		m_posted.wait(lock, [&]() {
+			for (int i = 0; i < m_jobs.size() && job == nullptr; i++)
+				if (m_jobs[i]->wanted > 0)
+					job = m_jobs[i];
+			return m_stopping || job != nullptr;
+		});
+		if (m_stopping)
+			return;
+		job->wanted--;
+		job->working++;
+		lock.unlock();
+		while (chrono::steady_clock::now() < job->deadline)
+			(*job->step)();
+		lock.lock();
+		job->working--;
+		m_left.notify_all();
+	}
+}
+
+//*********************************************************************
+//  MctsPlayer
+//*********************************************************************
+
+class MctsPlayer : public Player
+{
+public:
+	MctsPlayer(string nm, const Game& g, int msPerMove, int nThreads);
+	virtual ~MctsPlayer();
+	virtual bool placeShips(Board& b);
+	virtual Point recommendAttack();
+	virtual Point recommendAttackBefore(Deadline deadline);
+	virtual void recommendAttacks(int n, vector<Point>& shots, Deadline deadline);
+	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+		bool shipDestroyed, int shipId);
+	virtual void recordAttackByOpponent(Point /* p */) {}
+private:
+	Point bestShot() const;
+	void searchBefore(Deadline deadline);
+	void search(chrono::steady_clock::time_point deadline);
+	void iterate();
+	bool sampleLayout(const Knowledge& k, Layout& d) const;
+	bool placeFrom(const Knowledge& k, const int order[], const int remainingLen[], int depth,
+		CellSet occupied, int chosen[], int& steps) const;
+	int simulate(Layout& d, Knowledge& k, int cell) const;
+	int rolloutShot(const Knowledge& k, const Layout& d) const;
+	void computePriors(const Knowledge& k, double prior[]) const;
+	void expand(MctsNode* node, const Knowledge& k) const;
+	MctsEdge* select(MctsNode* node) const;
+	MctsNode* child(MctsEdge* e, int outcome, bool& created) const;
+	void recallRoot();
+	void rememberRoot() const;
+
+	const PlacementTable& m_table;
+	TranspositionTable& m_tt;
+	int m_msPerMove;
+	int m_nThreads;
+	int m_nCells;
+	CellSet m_board;
+	CellSet m_parity;             //checkerboard used to hunt in playouts
+	CellSet m_neighbors[NCELLS];
+	Knowledge m_knowledge;
+	ShotHash m_hash;              //of m_knowledge, sinking cells marked SUNK
+	unsigned long long m_rulesKey; //mixed into the hash, as the table is shared by every ruleset
+	MctsNode* m_root;
+};
+
+MctsPlayer::MctsPlayer(string nm, const Game& g, int msPerMove, int nThreads)
+	: Player(nm, g), m_table(PlacementTable::shared(g)), m_tt(TranspositionTable::shared()),
+	m_msPerMove(msPerMove), m_nThreads(nThreads), m_nCells(g.rows() * g.cols()),
+	m_hash(g.rows(), g.cols()), m_rulesKey(g.rows() * MAXCOLS + g.cols()), m_root(new MctsNode)
+{
+	if (m_nThreads <= 0)
+		m_nThreads = max(1, (int)thread::hardware_concurrency());
+	m_board = boardCells(g.rows(), g.cols());
+	for (int r = 0; r < g.rows(); r++)
+	{
+		for (int c = 0; c < g.cols(); c++)
+		{
+			if ((r + c) % 2 == 0)
+				m_parity.set(Point(r, c));
+			CellSet& n = m_neighbors[CellSet::index(Point(r, c))];
+			if (r > 0) n.set(Point(r - 1, c));
+			if (r + 1 < g.rows()) n.set(Point(r + 1, c));
+			if (c > 0) n.set(Point(r, c - 1));
+			if (c + 1 < g.cols()) n.set(Point(r, c + 1));
+		}
+	}
+	memset(m_knowledge.sinkCell, -1, sizeof(m_knowledge.sinkCell));
+	for (int s = 0; s < g.nShips(); s++)
+		m_rulesKey = splitMix64(m_rulesKey) ^ g.shipLength(s);
+	m_rulesKey = splitMix64(m_rulesKey);
+}
+
+MctsPlayer::~MctsPlayer()
+{
+	delete m_root;
+}
+
+bool MctsPlayer::placeShips(Board& b) //random layout, so there is nothing for the opponent to learn
+{
+	for (int tries = 0; tries < 100; tries++)
+	{
+		CellSet occupied;
+		vector<int> chosen;
+		for (int s = 0; s < game().nShips(); s++)
+		{
+			const vector<Placement>& list = m_table.forShip(s);
+			vector<int> cand;
+			for (int i = 0; i < list.size(); i++)
+				if (!list[i].cells.intersects(occupied))
+					cand.push_back(i);
+			if (cand.empty())
+				break;
+			chosen.push_back(cand[randInt(cand.size())]);
+			occupied |= list[chosen.back()].cells;
+		}
+		if (chosen.size() < game().nShips())
+			continue;
+		int s;
+		for (s = 0; s < game().nShips(); s++)
+		{
+			const Placement& pl = m_table.forShip(s)[chosen[s]];
+			if (!b.placeShip(pl.topOrLeft, s, pl.dir))
+				break;
+		}
+		if (s == game().nShips())
+			return true;
+		b.clear(); //the board refused a placement; start again from an empty one
+	}
+	return false;
+}
+
+Point MctsPlayer::recommendAttack()
+{
+	search(chrono::steady_clock::now() + chrono::milliseconds(m_msPerMove));
+	return bestShot();
+}
+
+Point MctsPlayer::recommendAttackBefore(Deadline deadline)
+{
+	searchBefore(deadline); //the tree always has an answer, however short the search
+	return bestShot();
+}
+
+void MctsPlayer::recommendAttacks(int n, vector<Point>& shots, Deadline deadline)
+{
+	//one search, then the n most visited first shots; the tree can't tell
+	//us what to fire after a shot whose result we won't see until later
+	searchBefore(deadline);
+	shots.clear();
+	vector<MctsEdge*> edges;
+	if (m_root->expanded.load(memory_order_acquire))
+		for (int i = 0; i < m_root->edges.size(); i++)
+			if (m_root->edges[i]->visits > 0)
+				edges.push_back(m_root->edges[i]);
+	int wanted = min(n, (int)edges.size());
+	partial_sort(edges.begin(), edges.begin() + wanted, edges.end(),
+		[](const MctsEdge* x, const MctsEdge* y) { return x->visits > y->visits; });
+	for (int i = 0; i < wanted; i++)
+		shots.push_back(CellSet::point(edges[i]->cell));
+	if (shots.empty() && n > 0)
+		shots.push_back(bestShot());
+}
+
+void MctsPlayer::searchBefore(Deadline deadline)
+{
+	//stop early enough that a last long iteration and joining the threads
+	//don't make us late: 2ms plus a tenth of the time available
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	Deadline own = now + chrono::milliseconds(m_msPerMove);
+	if (deadline != noDeadline() && deadline < own + chrono::milliseconds(2) + (own - now) / 10)
+		own = deadline - chrono::milliseconds(2) - (deadline - now) / 10;
+	search(own);
+}
+
+Point MctsPlayer::bestShot() const
+{
+	MctsEdge* best = nullptr;
+	if (m_root->expanded.load(memory_order_acquire))
+	{
+		for (int i = 0; i < m_root->edges.size(); i++) //the most visited shot is the most trusted one
+			if (best == nullptr || m_root->edges[i]->visits > best->visits)
+				best = m_root->edges[i];
+	}
+	if (best != nullptr && best->visits > 0)
+		return CellSet::point(best->cell);
+
+	//no layout could be sampled in time; fall back on the density prior
+	double prior[NCELLS];
+	computePriors(m_knowledge, prior);
+	int bestCell = -1;
+	for (int i = 0; i < NCELLS; i++)
+		if (m_board.test(i) && !m_knowledge.shot.test(i) && (bestCell < 0 || prior[i] > prior[bestCell]))
+			bestCell = i;
+	return bestCell < 0 ? game().randomPoint() : CellSet::point(bestCell);
+}
+
+void MctsPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	if (!validShot)
+		return;
+	int cell = CellSet::index(p);
+	int outcome = (!shotHit ? OUTCOME_MISS : shipDestroyed ? OUTCOME_SUNK + shipId : OUTCOME_HIT);
+	m_knowledge.apply(cell, outcome);
+	m_hash.setCell(p, UNSHOT, !shotHit ? MISSED : shipDestroyed ? SUNK : HIT);
+	if (shipDestroyed)
+		m_hash.setShipSunk(shipId);
+
+	//keep the subtree for what actually happened and drop the rest
+	MctsNode* next = nullptr;
+	for (int i = 0; i < m_root->edges.size() && next == nullptr; i++)
+	{
+		MctsEdge* e = m_root->edges[i];
+		if (e->cell != cell)
+			continue;
+		for (int j = 0; j < e->children.size(); j++)
+		{
+			if (e->children[j].first == outcome)
+			{
+				next = e->children[j].second;
+				e->children.erase(e->children.begin() + j);
+				break;
+			}
+		}
+	}
+	delete m_root;
+	m_root = (next != nullptr ? next : new MctsNode);
+}
+
+void MctsPlayer::search(chrono::steady_clock::time_point deadline)
+{
+	if (!m_root->expanded.load(memory_order_acquire))
+	{
+		expand(m_root, m_knowledge);
+		recallRoot();
+	}
+	if (m_nThreads > 1)
+	{
+		function<void()> step = [this]() { iterate(); };
+		SearchPool::instance().run(step, deadline, m_nThreads - 1);
+	}
+	else
+	{
+		while (chrono::steady_clock::now() < deadline)
+			iterate();
+	}
+	rememberRoot();
+}
+
+void MctsPlayer::recallRoot()
+{
+	//no other thread is searching yet, so the edges can still be reordered
+	TTEntry entry;
+	if (!m_tt.probe(m_hash.canonicalHash() ^ m_rulesKey, entry) || entry.bestMove.r < 0)
+		return;
+	int cell = CellSet::index(undoSymmetry(m_hash.canonicalSymmetry(), entry.bestMove, game().rows(), game().cols()));
+	vector<MctsEdge*>& edges = m_root->edges;
+	for (int i = 0; i < edges.size(); i++)
+	{
+		if (edges[i]->cell == cell)
+		{
+			edges[i]->prior += 1;  //above every density prior, which are at most 1
+			rotate(edges.begin(), edges.begin() + i, edges.begin() + i + 1);
+			return;
+		}
+	}
+}
+
+void MctsPlayer::rememberRoot() const
+{
+	MctsEdge* best = nullptr;
+	for (int i = 0; i < m_root->edges.size(); i++)
+		if (best == nullptr || m_root->edges[i]->visits > best->visits)
+			best = m_root->edges[i];
+	if (best == nullptr || best->visits == 0)
+		return;
+	TTEntry entry;
+	entry.bestMove = applySymmetry(m_hash.canonicalSymmetry(), CellSet::point(best->cell), game().rows(), game().cols());
+	entry.value = (int)(best->reward.load(memory_order_relaxed) / best->visits);
+	entry.depth = min((int)m_root->visits, 0x7FFF);  //the root's visits measure the work behind the shot
+	m_tt.store(m_hash.canonicalHash() ^ m_rulesKey, entry);
+}
+
+void MctsPlayer::iterate()
+{
+	Knowledge k = m_knowledge;
+	Layout d;
+	if (!sampleLayout(k, d))
+		return;
+
+	MctsEdge* path[NCELLS];
+	int depth = 0;
+	int shots = 0;
+	MctsNode* node = m_root;
+	while (d.shipsLeft > 0) //walk down the tree, adding at most one node
+	{
+		if (!node->expanded.load(memory_order_acquire))
+			expand(node, k);
+		MctsEdge* e = select(node);
+		if (e == nullptr)
+			break;
+		path[depth++] = e;
+		int outcome = simulate(d, k, e->cell);
+		shots++;
+		bool created = false;
+		node = child(e, outcome, created);
+		if (created)
+			break;
+	}
+	while (d.shipsLeft > 0) //then play the rest of the game out quickly
+	{
+		simulate(d, k, rolloutShot(k, d));
+		shots++;
+	}
+
+	long long reward = (long long)(1000000.0 * (1.0 - double(shots) / m_nCells));
+	for (int i = 0; i < depth; i++)
+		path[i]->reward.fetch_add(reward, memory_order_relaxed);
+}
+
+bool MctsPlayer::sampleLayout(const Knowledge& k, Layout& d) const
+{
+	int n = game().nShips();
+	int order[MAXSHIPS];  //sunk ships first since they have few choices, then longest first
+	int nOrdered = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		int start = nOrdered;
+		for (int s = 0; s < n; s++)
+		{
+			if ((k.sinkCell[s] >= 0) != (pass == 0))
+				continue;
+			int j = nOrdered++;
+			for (; j > start && m_table.shipLength(order[j - 1]) < m_table.shipLength(s); j--)
+				order[j] = order[j - 1];
+			order[j] = s;
+		}
+	}
+	int remainingLen[MAXSHIPS + 1];
+	remainingLen[n] = 0;
+	for (int i = n - 1; i >= 0; i--)
+		remainingLen[i] = remainingLen[i + 1] + m_table.shipLength(order[i]);
+
+	int chosen[MAXSHIPS];
+	int steps = 0;
+	if (!placeFrom(k, order, remainingLen, 0, CellSet(), chosen, steps))
+		return false;
+
+	memset(d.shipAt, -1, sizeof(d.shipAt));
+	d.unsunkHits.clear();
+	d.shipsLeft = 0;
+	for (int s = 0; s < n; s++)
+	{
+		const Placement& pl = m_table.forShip(s)[chosen[s]];
+		d.ship[s] = pl.cells;
+		for (int j = 0; j < pl.len; j++)
+			d.shipAt[pl.cell[j]] = s;
+		d.left[s] = pl.len - (pl.cells & k.hit).count();
+		if (d.left[s] > 0)
+		{
+			d.shipsLeft++;
+			d.unsunkHits |= pl.cells & k.hit;
+		}
+	}
+	return true;
+}
+
+bool MctsPlayer::placeFrom(const Knowledge& k, const int order[], const int remainingLen[], int depth,
+	CellSet occupied, int chosen[], int& steps) const
+{
+	if (depth == game().nShips())
+		return occupied.contains(k.hit); //every hit must belong to some ship
+
+	int s = order[depth];
+	const vector<Placement>& list = m_table.forShip(s);
+	CellSet blocked = k.missed | occupied;
+	int cand[MAXPLACEMENTS];
+	int nCand = 0;
+	for (int i = 0; i < list.size(); i++)
+	{
+		const CellSet& m = list[i].cells;
+		if (m.intersects(blocked))
+			continue;
+		if (k.sinkCell[s] >= 0)
+		{
+			//a sunk ship lies on hit cells only, through the cell that sank it
+			//and through no cell that sank another ship
+			if (!m.test(k.sinkCell[s]) || !k.hit.contains(m) || (m & k.sinkCells).count() != 1)
+				continue;
+		}
+		else if (m.intersects(k.sinkCells) || k.hit.contains(m)) //else it would have sunk
+			continue;
+		cand[nCand++] = i;
+	}
+	while (nCand > 0)
+	{
+		if (++steps > MAXSAMPLESTEPS)
+			return false;
+		int j = randInt(nCand);
+		int i = cand[j];
+		cand[j] = cand[--nCand];
+		CellSet next = occupied | list[i].cells;
+		if (k.hit.minus(next).count() > remainingLen[depth + 1]) //the rest can't cover the hits
+			continue;
+		chosen[s] = i;
+		if (placeFrom(k, order, remainingLen, depth + 1, next, chosen, steps))
+			return true;
+	}
+	return false;
+}
+
+int MctsPlayer::simulate(Layout& d, Knowledge& k, int cell) const
+{
+	int outcome = OUTCOME_MISS;
+	int s = d.shipAt[cell];
+	if (s >= 0 && !k.shot.test(cell))
+	{
+		outcome = OUTCOME_HIT;
+		d.unsunkHits.set(cell);
+		if (--d.left[s] == 0)
+		{
+			outcome = OUTCOME_SUNK + s;
+			d.unsunkHits = d.unsunkHits.minus(d.ship[s]);
+			d.shipsLeft--;
+		}
+	}
+	k.apply(cell, outcome);
+	return outcome;
+}
+
+int MctsPlayer::rolloutShot(const Knowledge& k, const Layout& d) const
+{
+	CellSet open = m_board.minus(k.shot);
+	CellSet cand;
+	if (d.unsunkHits.any()) //finish off wounded ships first
+	{
+		CellSet hits = d.unsunkHits;
+		for (int i = hits.first(); i >= 0; hits.reset(i), i = hits.first())
+			cand |= m_neighbors[i];
+		cand &= open;
+	}
+	if (cand.none())
+	{
+		cand = open & m_parity;
+		if (cand.none())
+			cand = open;
+	}
+	return cand.nth(randInt(cand.count()));
+}
+
+void MctsPlayer::computePriors(const Knowledge& k, double prior[]) const
+{
+	//like GoodPlayer's heatmap, but placements through hits count for much more
+	for (int i = 0; i < NCELLS; i++)
+		prior[i] = 0;
+	CellSet blocked = k.missed | k.sinkCells;
+	for (int s = 0; s < game().nShips(); s++)
+	{
+		if (k.sinkCell[s] >= 0)
+			continue;
+		const vector<Placement>& list = m_table.forShip(s);
+		for (int i = 0; i < list.size(); i++)
+		{
+			const Placement& pl = list[i];
+			if (pl.cells.intersects(blocked) || k.hit.contains(pl.cells))
+				continue;
+			double w = 1 + 20 * (pl.cells & k.hit).count();
+			for (int j = 0; j < pl.len; j++)
+				prior[pl.cell[j]] += w;
+		}
+	}
+	double maxPrior = 0;
+	for (int i = 0; i < NCELLS; i++)
+	{
+		if (k.shot.test(i))
+			prior[i] = 0;
+		maxPrior = max(maxPrior, prior[i]);
+	}
+	if (maxPrior > 0)
+		for (int i = 0; i < NCELLS; i++)
+			prior[i] /= maxPrior;
+}
+
+void MctsPlayer::expand(MctsNode* node, const Knowledge& k) const
+{
+	lock_guard<mutex> lock(node->lock);
+	if (node->expanded.load(memory_order_relaxed))
+		return;
+	double prior[NCELLS];
+	computePriors(k, prior);
+	CellSet open = m_board.minus(k.shot);
+	for (int i = open.first(); i >= 0; open.reset(i), i = open.first())
+		node->edges.push_back(new MctsEdge(i, prior[i]));
+	stable_sort(node->edges.begin(), node->edges.end(),
+		[](const MctsEdge* a, const MctsEdge* b) { return a->prior > b->prior; });
+	node->expanded.store(true, memory_order_release);
+}
+
+MctsEdge* MctsPlayer::select(MctsNode* node) const
+{
+	int n = node->visits.fetch_add(1, memory_order_relaxed) + 1;
+	//progressive widening: only the best-prior edges compete until the node has been visited a lot
+	int width = min((int)node->edges.size(), 1 + (int)(2 * sqrt((double)n)));
+	double logN = log((double)n);
+	MctsEdge* best = nullptr;
+	double bestScore = 0;
+	for (int i = 0; i < width; i++)
+	{
+		MctsEdge* e = node->edges[i];
+		int ev = e->visits.load(memory_order_relaxed);
+		if (ev == 0) //untried edges go first, in prior order
+		{
+			best = e;
+			break;
+		}
+		double q = e->reward.load(memory_order_relaxed) / 1000000.0 / ev;
+		double score = q + EXPLORATION * sqrt(logN / ev) + PRIORWEIGHT * e->prior / (1 + ev);
+		if (best == nullptr || score > bestScore)
+		{
+			best = e;
+			bestScore = score;
+		}
+	}
+	if (best != nullptr)
+		best->visits.fetch_add(1, memory_order_relaxed); //virtual loss until the reward arrives
+	return best;
+}
+
+MctsNode* MctsPlayer::child(MctsEdge* e, int outcome, bool& created) const
+{
+	lock_guard<mutex> lock(e->lock);
+	for (int i = 0; i < e->children.size(); i++)
+		if (e->children[i].first == outcome)
+			return e->children[i].second;
+	MctsNode* node = new MctsNode;
+	e->children.push_back(make_pair(outcome, node));
+	created = true;
+	return node;
+}
+
+Player* createMctsPlayer(string nm, const Game& g, int msPerMove, int nThreads)
+{
+	return new MctsPlayer(nm, g, msPerMove, nThreads);
+}
@@ -0,0 +1,17 @@
+#ifndef MCTSPLAYER_INCLUDED
+#define MCTSPLAYER_INCLUDED
+
+#include <string>
+
+class Player;
+class Game;
+
+// A player that searches several shots ahead with information-set Monte
+// Carlo tree search.  Each move gets msPerMove milliseconds, spread over
+// nThreads threads (0 means one per core).  All but the player's own thread
+// come from a pool of one per core shared by every MctsPlayer, so a
+// multithreaded tournament of them never runs more searching threads than
+// its games plus the cores.
+Player* createMctsPlayer(std::string nm, const Game& g, int msPerMove, int nThreads);
+
+#endif // MCTSPLAYER_INCLUDED
@@ -0,0 +1,89 @@
+#include "Placements.h"
+#include "Game.h"
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+PlacementTable::PlacementTable(const Game& g)
+	: m_rows(g.rows()), m_cols(g.cols())
+{
+	vector<int> lengths;
+	for (int i = 0; i < g.nShips(); i++)
+		lengths.push_back(g.shipLength(i));
+	build(lengths);
+}
+
+PlacementTable::PlacementTable(int rows, int cols, const vector<int>& lengths)
+	: m_rows(rows), m_cols(cols)
+{
+	build(lengths);
+}
+
+const PlacementTable& PlacementTable::shared(const Game& g)
+{
+	vector<int> lengths;
+	for (int i = 0; i < g.nShips(); i++)
+		lengths.push_back(g.shipLength(i));
+	return shared(g.rows(), g.cols(), lengths);
+}
+
+const PlacementTable& PlacementTable::shared(int rows, int cols, const vector<int>& lengths)
+{
+	//the tables live until the program ends; there are only as many as rulesets played
+	static mutex lock;
+	static map<vector<int>, PlacementTable*> tables;
+	vector<int> key = lengths;
+	key.push_back(rows);
+	key.push_back(cols);
+	lock_guard<mutex> guard(lock);
+	PlacementTable*& table = tables[key];
+	if (table == nullptr)
+		table = new PlacementTable(rows, cols, lengths);
+	return *table;
+}
+
+void PlacementTable::build(const vector<int>& lengths)
+{
+	m_lengths = lengths;
+	m_all = boardCells(m_rows, m_cols);
+	vector<int> builtLengths;
+	for (int i = 0; i < lengths.size(); i++)
+	{
+		int k;
+		for (k = 0; k < builtLengths.size() && builtLengths[k] != lengths[i]; k++)
+			;
+		m_forShip.push_back(k);
+		if (k < builtLengths.size())
+			continue;
+		builtLengths.push_back(lengths[i]);
+		m_byLength.push_back(vector<Placement>());
+		vector<Placement>& list = m_byLength.back();
+		// same order as the placeShip loops in the players: by cell, vertical first
+		for (int r = 0; r < m_rows; r++)
+		{
+			for (int c = 0; c < m_cols; c++)
+			{
+				for (int d = 0; d < 2; d++)
+				{
+					Placement pl;
+					pl.topOrLeft = Point(r, c);
+					pl.dir = (d == 0 ? VERTICAL : HORIZONTAL);
+					pl.len = lengths[i];
+					if (pl.len == 1 && pl.dir == HORIZONTAL) //same cells as the vertical one
+						continue;
+					if ((pl.dir == VERTICAL && r + pl.len > m_rows) || (pl.dir == HORIZONTAL && c + pl.len > m_cols))
+						continue;
+					for (int j = 0; j < pl.len; j++)
+					{
+						Point p = (pl.dir == VERTICAL ? Point(r + j, c) : Point(r, c + j));
+						pl.cell[j] = CellSet::index(p);
+						pl.cells.set(p);
+					}
+					list.push_back(pl);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef PLACEMENTS_INCLUDED
+#define PLACEMENTS_INCLUDED
+
+#include "globals.h"
+#include "CellSet.h"
+#include <vector>
+
+class Game;
+
+// One way a ship can lie on an empty board
+struct Placement
+{
+	CellSet cells;
+	Point topOrLeft;
+	Direction dir;
+	unsigned char len;
+	unsigned char cell[MAXROWS > MAXCOLS ? MAXROWS : MAXCOLS]; //CellSet indexes of the cells
+};
+
+// Every placement of every ship of a game, ignoring the other ships
+class PlacementTable
+{
+public:
+	PlacementTable(const Game& g);
+	PlacementTable(int rows, int cols, const std::vector<int>& lengths);
+	// The table for a board and fleet, built the first time it is asked for
+	// and then shared by every thread.  A table never changes once built, so
+	// players can hold on to it without copying.
+	static const PlacementTable& shared(const Game& g);
+	static const PlacementTable& shared(int rows, int cols, const std::vector<int>& lengths);
+	int rows() const { return m_rows; }
+	int cols() const { return m_cols; }
+	int nShips() const { return m_forShip.size(); }
+	int shipLength(int shipId) const { return m_lengths[shipId]; }
+	const std::vector<Placement>& forShip(int shipId) const { return m_byLength[m_forShip[shipId]]; }
+	const CellSet& allCells() const { return m_all; }
+
+private:
+	void build(const std::vector<int>& lengths);
+	int m_rows;
+	int m_cols;
+	std::vector<int> m_lengths;
+	std::vector<int> m_forShip;  //index into m_byLength; ships of equal length share a list
+	std::vector<std::vector<Placement>> m_byLength;
+	CellSet m_all;
+};
+
+#endif // PLACEMENTS_INCLUDED
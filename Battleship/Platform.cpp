@@ -0,0 +1,576 @@
+#include "Platform.h"
+#include <chrono>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+using namespace std;
+
+//******************** ChildProcess functions *************************
+
+const int CLOSE_WAIT_MS = 2000;  //how long close lets a child take to exit on its own
+
+ChildProcess::ChildProcess()
+	: m_bufPos(0), m_running(false)
+#ifdef _WIN32
+	, m_process(nullptr), m_job(nullptr), m_toChild(nullptr), m_fromChild(nullptr)
+#else
+	, m_pid(-1), m_toChild(-1), m_fromChild(-1), m_exited(false)
+#endif
+{}
+
+ChildProcess::~ChildProcess()
+{
+	close();
+}
+
+bool ChildProcess::readLine(string& line, int timeoutMs)
+{
+	chrono::steady_clock::time_point end = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+	for (;;)
+	{
+		size_t nl = m_buf.find('\n', m_bufPos);
+		if (nl != string::npos)
+		{
+			line.assign(m_buf, m_bufPos, nl - m_bufPos);
+			if (!line.empty() && line[line.size() - 1] == '\r')  //tolerate bots that write CRLF
+				line.erase(line.size() - 1);
+			m_bufPos = nl + 1;
+			return true;
+		}
+		if (m_bufPos > 0) //drop consumed bytes before reading more
+		{
+			m_buf.erase(0, m_bufPos);
+			m_bufPos = 0;
+		}
+		int left = -1;
+		if (timeoutMs >= 0)
+		{
+			left = (int)chrono::duration_cast<chrono::milliseconds>(end - chrono::steady_clock::now()).count();
+			if (left < 0)
+				return false;
+		}
+		if (!fill(left))
+			return false;
+	}
+}
+
+#ifdef _WIN32
+
+bool ChildProcess::start(const string& command)
+{
+	close();
+
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength = sizeof(sa);
+	sa.lpSecurityDescriptor = nullptr;
+	sa.bInheritHandle = TRUE;
+
+	HANDLE childIn, toChild, fromChild, childOut;
+	if (!CreatePipe(&childIn, &toChild, &sa, 0))
+		return false;
+	if (!CreatePipe(&fromChild, &childOut, &sa, 0))
+	{
+		CloseHandle(childIn);
+		CloseHandle(toChild);
+		return false;
+	}
+	//our ends of the pipes must not be inherited, or the child never sees EOF
+	SetHandleInformation(toChild, HANDLE_FLAG_INHERIT, 0);
+	SetHandleInformation(fromChild, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOA si;
+	ZeroMemory(&si, sizeof(si));
+	si.cb = sizeof(si);
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = childIn;
+	si.hStdOutput = childOut;
+	si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+	//the child starts suspended, so that it is in the job before it can start anything
+	HANDLE job = CreateJobObjectA(nullptr, nullptr);
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+	ZeroMemory(&limits, sizeof(limits));
+	limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+	PROCESS_INFORMATION pi;
+	string cmdLine = "cmd.exe /c " + command;
+	BOOL ok = job != nullptr &&
+		SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits)) &&
+		CreateProcessA(nullptr, &cmdLine[0], nullptr, nullptr, TRUE, CREATE_SUSPENDED,
+			nullptr, nullptr, &si, &pi);
+	CloseHandle(childIn);
+	CloseHandle(childOut);
+	if (ok && !AssignProcessToJobObject(job, pi.hProcess))
+	{
+		TerminateProcess(pi.hProcess, 1);
+		CloseHandle(pi.hThread);
+		CloseHandle(pi.hProcess);
+		ok = FALSE;
+	}
+	if (!ok)
+	{
+		if (job != nullptr)
+			CloseHandle(job);
+		CloseHandle(toChild);
+		CloseHandle(fromChild);
+		return false;
+	}
+	ResumeThread(pi.hThread);
+	CloseHandle(pi.hThread);
+	m_process = pi.hProcess;
+	m_job = job;
+	m_toChild = toChild;
+	m_fromChild = fromChild;
+	m_running = true;
+	return true;
+}
+
+bool ChildProcess::write(const string& data)
+{
+	if (!m_running)
+		return false;
+	size_t done = 0;
+	while (done < data.size())
+	{
+		DWORD n = 0;
+		if (!WriteFile(m_toChild, data.data() + done, DWORD(data.size() - done), &n, nullptr))
+			return false;
+		done += n;
+	}
+	return true;
+}
+
+bool ChildProcess::isRunning()
+{
+	return m_running && WaitForSingleObject(m_process, 0) == WAIT_TIMEOUT;
+}
+
+bool ChildProcess::fill(int timeoutMs)
+{
+	if (!m_running)
+		return false;
+	//anonymous pipes can't be waited on with a timeout, so poll them
+	for (int waited = 0; timeoutMs >= 0; waited++)
+	{
+		DWORD available = 0;
+		if (!PeekNamedPipe(m_fromChild, nullptr, 0, nullptr, &available, nullptr))
+			return false;
+		if (available > 0)
+			break;
+		if (waited >= timeoutMs)
+			return false;
+		Sleep(1);
+	}
+	char chunk[4096];
+	DWORD n = 0;
+	if (!ReadFile(m_fromChild, chunk, sizeof(chunk), &n, nullptr) || n == 0)
+		return false;
+	m_buf.append(chunk, n);
+	return true;
+}
+
+void ChildProcess::close()
+{
+	if (!m_running)
+		return;
+	//the child sees EOF on stdin and should exit; with our end of its stdout
+	//closed too, it can't be stuck writing to a pipe nobody reads
+	CloseHandle(m_toChild);
+	CloseHandle(m_fromChild);
+	if (WaitForSingleObject(m_process, CLOSE_WAIT_MS) != WAIT_OBJECT_0)
+		TerminateJobObject(m_job, 1);
+	CloseHandle(m_job);  //ends anything the child left running
+	CloseHandle(m_process);
+	m_toChild = m_fromChild = m_process = m_job = nullptr;
+	m_buf.clear();
+	m_bufPos = 0;
+	m_running = false;
+}
+
+void ChildProcess::kill()
+{
+	if (m_running)
+		TerminateJobObject(m_job, 1);
+	close();
+}
+
+#else
+
+bool ChildProcess::start(const string& command)
+{
+	close();
+
+	int in[2];
+	int out[2];
+	if (pipe(in) != 0)
+		return false;
+	if (pipe(out) != 0)
+	{
+		::close(in[0]);
+		::close(in[1]);
+		return false;
+	}
+	signal(SIGPIPE, SIG_IGN); //a dead bot should make write() fail, not kill us
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		::close(in[0]);
+		::close(in[1]);
+		::close(out[0]);
+		::close(out[1]);
+		return false;
+	}
+	if (pid == 0) //child
+	{
+		setpgid(0, 0);  //a group of its own, so kill reaches whatever the shell starts
+		dup2(in[0], 0);
+		dup2(out[1], 1);
+		::close(in[0]);
+		::close(in[1]);
+		::close(out[0]);
+		::close(out[1]);
+		execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+		_exit(127);
+	}
+	::close(in[0]);
+	::close(out[1]);
+	m_pid = pid;
+	m_toChild = in[1];
+	m_fromChild = out[0];
+	m_running = true;
+	return true;
+}
+
+bool ChildProcess::write(const string& data)
+{
+	if (!m_running)
+		return false;
+	size_t done = 0;
+	while (done < data.size())
+	{
+		ssize_t n = ::write(m_toChild, data.data() + done, data.size() - done);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		done += n;
+	}
+	return true;
+}
+
+bool ChildProcess::isRunning()
+{
+	if (!m_running || m_exited)
+		return false;
+	int status;
+	if (waitpid(m_pid, &status, WNOHANG) == m_pid)
+		m_exited = true;
+	return !m_exited;
+}
+
+bool ChildProcess::fill(int timeoutMs)
+{
+	if (!m_running)
+		return false;
+	char chunk[4096];
+	for (;;)
+	{
+		pollfd fd = { m_fromChild, POLLIN, 0 };
+		int ready = poll(&fd, 1, timeoutMs);
+		if (ready < 0 && errno == EINTR)
+			continue;
+		if (ready <= 0)
+			return false;
+		ssize_t n = ::read(m_fromChild, chunk, sizeof(chunk));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		m_buf.append(chunk, n);
+		return true;
+	}
+}
+
+void ChildProcess::close()
+{
+	if (!m_running)
+		return;
+	::close(m_toChild);  //child sees EOF on stdin and should exit
+	::close(m_fromChild);
+	for (int waited = 0; !m_exited; waited++)
+	{
+		int status;
+		pid_t done = waitpid(m_pid, &status, WNOHANG);
+		if (done == m_pid || (done < 0 && errno != EINTR))
+			break;
+		if (waited == CLOSE_WAIT_MS)
+			::kill(-m_pid, SIGKILL);  //it had its chance; the next wait reaps it
+		usleep(1000);
+	}
+	m_pid = m_toChild = m_fromChild = -1;
+	m_buf.clear();
+	m_bufPos = 0;
+	m_running = false;
+	m_exited = false;
+}
+
+void ChildProcess::kill()
+{
+	if (m_running && !m_exited)
+		::kill(-m_pid, SIGKILL);
+	close();
+}
+
+#endif
+
+//******************** MappedFile functions **************************
+
+MappedFile::MappedFile()
+	: m_data(nullptr), m_size(0)
+#ifdef _WIN32
+	, m_file(nullptr), m_mapping(nullptr)
+#else
+	, m_fd(-1)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path, size_t size)
+{
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER current;
+	if (!GetFileSizeEx(file, &current))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	if (current.QuadPart > (LONGLONG)size)
+		size = size_t(current.QuadPart);
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+		DWORD((unsigned long long)size >> 32), DWORD(size & 0xFFFFFFFF), nullptr); //grows the file, new bytes are zero
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (data == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_mapping = mapping;
+	m_data = data;
+	m_size = size;
+	return true;
+}
+
+bool MappedFile::openReadOnly(const string& path)
+{
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER current;
+	if (!GetFileSizeEx(file, &current) || current.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_mapping = mapping;
+	m_data = data;
+	m_size = size_t(current.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data == nullptr)
+		return;
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	CloseHandle(m_file);
+	m_data = m_file = m_mapping = nullptr;
+	m_size = 0;
+}
+
+#else
+
+bool MappedFile::open(const string& path, size_t size)
+{
+	close();
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	if (size_t(st.st_size) > size)
+		size = size_t(st.st_size);
+	else if (size_t(st.st_size) < size && ftruncate(fd, size) != 0) //new bytes are zero
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+	m_fd = fd;
+	m_data = data;
+	m_size = size;
+	return true;
+}
+
+bool MappedFile::openReadOnly(const string& path)
+{
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+	m_fd = fd;
+	m_data = data;
+	m_size = size_t(st.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data == nullptr)
+		return;
+	munmap(m_data, m_size);
+	::close(m_fd);
+	m_data = nullptr;
+	m_fd = -1;
+	m_size = 0;
+}
+
+#endif
+
+//******************** file functions *********************************
+
+#ifdef _WIN32
+
+bool writeFileAtomically(const string& path, const string& contents)
+{
+	string tmp = path + ".tmp";
+	HANDLE file = CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	DWORD written;
+	bool ok = WriteFile(file, contents.data(), DWORD(contents.size()), &written, nullptr) &&
+		written == contents.size() && FlushFileBuffers(file);
+	CloseHandle(file);
+	return ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+}
+
+string createTempFile(const string& prefix)
+{
+	char dir[MAX_PATH + 1];
+	char path[MAX_PATH + 1];
+	DWORD n = GetTempPathA(sizeof(dir), dir);
+	if (n == 0 || n > sizeof(dir) || GetTempFileNameA(dir, prefix.c_str(), 0, path) == 0)
+		return "";
+	return path;
+}
+
+#else
+
+bool writeFileAtomically(const string& path, const string& contents)
+{
+	string tmp = path + ".tmp";
+	int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+	size_t done = 0;
+	while (done < contents.size())
+	{
+		ssize_t n = ::write(fd, contents.data() + done, contents.size() - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+		{
+			::close(fd);
+			return false;
+		}
+		done += n;
+	}
+	bool ok = (fsync(fd) == 0);
+	::close(fd);
+	return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+string createTempFile(const string& prefix)
+{
+	const char* dir = getenv("TMPDIR");
+	string path = string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/" + prefix + "XXXXXX";
+	int fd = mkstemp(&path[0]);
+	if (fd < 0)
+		return "";
+	::close(fd);
+	return path;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef PLATFORM_INCLUDED
+#define PLATFORM_INCLUDED
+
+#include <string>
+
+// A child process whose stdin and stdout are connected to us through pipes.
+// Everything operating-system specific lives in Platform.cpp.
+class ChildProcess
+{
+public:
+	ChildProcess();
+	~ChildProcess();
+	bool start(const std::string& command); //runs command through the shell
+	bool isRunning();                    //false once the child has exited
+	bool write(const std::string& data); //one write call for the whole string
+	// Blocks until a full line (without '\n') arrives; false if the child
+	// closes its stdout or, with a timeout, if that many milliseconds pass
+	bool readLine(std::string& line, int timeoutMs = -1);
+	// Closes the pipes and waits a little for the child to exit, then ends it
+	void close();
+	void kill();                         //ends the child, and whatever it started, at once
+	// We prevent a ChildProcess object from being copied or assigned
+	ChildProcess(const ChildProcess&) = delete;
+	ChildProcess& operator=(const ChildProcess&) = delete;
+
+private:
+	bool fill(int timeoutMs); //reads more bytes from the child into m_buf
+	std::string m_buf;
+	size_t m_bufPos;
+	bool m_running;
+#ifdef _WIN32
+	void* m_process;
+	void* m_job;     //holds the shell and everything it starts, so kill can end them all
+	void* m_toChild;
+	void* m_fromChild;
+#else
+	int m_pid;
+	int m_toChild;
+	int m_fromChild;
+	bool m_exited;   //reaped by isRunning
+#endif
+};
+
+// A file mapped into memory for reading and writing.  Changes made through
+// data() reach the file without any explicit save, and other processes
+// that map the same file see them, even ones that opened it read-only.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	bool open(const std::string& path, size_t size); //creates or grows the file to size bytes
+	bool openReadOnly(const std::string& path);      //maps all of an existing file; data() must not be written
+	bool isOpen() const { return m_data != nullptr; }
+	void* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	void close();
+	// We prevent a MappedFile object from being copied or assigned
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+	void* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_fd;
+#endif
+};
+
+// Replaces the file at path with contents.  The data goes to path + ".tmp"
+// and reaches the disk before that file is renamed over path, so after a
+// crash path holds either the old contents or the new, never a mix.
+bool writeFileAtomically(const std::string& path, const std::string& contents);
+
+// Creates an empty file, with a name starting with prefix that no other
+// file has, in the directory for temporary files.  Returns its path, or an
+// empty string if it couldn't be created.
+std::string createTempFile(const std::string& prefix);
+
+#endif // PLATFORM_INCLUDED
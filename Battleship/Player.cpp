@@ -2,13 +2,106 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "CellSet.h"
+#include "PlayerState.h"
+#include "LayoutCounter.h"
+#include "Platform.h"
+#include "ShotStore.h"
+#include "LayoutStore.h"
+#include "MctsPlayer.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
-#include <queue>
+#include <map>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
 
+Point Player::recommendAttackBefore(Deadline /* deadline */)
+{
+	return recommendAttack(); //players that don't think long ignore the deadline
+}
+
+void Player::recommendAttacks(int n, vector<Point>& shots, Deadline deadline)
+{
+	//a player that keeps suggesting cells it already chose has nothing more to offer
+	shots.clear();
+	for (int repeats = 0; shots.size() < n && repeats < 2; )
+	{
+		Point p = recommendAttackBefore(deadline);
+		bool repeated = false;
+		for (int i = 0; i < shots.size(); i++)
+			if (shots[i].r == p.r && shots[i].c == p.c)
+				repeated = true;
+		if (repeated)
+			repeats++;
+		else
+		{
+			shots.push_back(p);
+			repeats = 0;
+		}
+	}
+}
+
+void Player::recordSalvoResult(const vector<ShotResult>& results)
+{
+	for (int i = 0; i < results.size(); i++)
+		recordAttackResult(results[i].p, results[i].validShot, results[i].shotHit,
+			results[i].shipDestroyed, results[i].shipId);
+}
+
+//*********************************************************************
+//  OpponentShotLog
+//*********************************************************************
+
+// Remembers the order of the opponent's shots during one game and adds it
+// to the ShotStore when the player owning the log is destroyed.  Nothing is
+// logged while the store is not in use.
+class OpponentShotLog
+{
+public:
+	OpponentShotLog(const Game& g);
+	~OpponentShotLog();
+	void setOpponent(const Player& opponent);
+	unsigned long long opponent() const { return m_opponent; }  //0 if not logging
+	void record(Point p);
+private:
+	const Game& m_game;
+	unsigned long long m_opponent;
+	int m_nShots;
+	unsigned char m_order[MAXROWS * MAXCOLS];
+};
+
+OpponentShotLog::OpponentShotLog(const Game& g) : m_game(g), m_opponent(0), m_nShots(0)
+{
+	memset(m_order, 0, sizeof(m_order));
+}
+
+OpponentShotLog::~OpponentShotLog()
+{
+	if (m_opponent != 0 && m_nShots > 0)
+		ShotStore::instance().recordGame(m_opponent, m_order);
+}
+
+void OpponentShotLog::setOpponent(const Player& opponent)
+{
+	m_opponent = ShotStore::instance().isOpen() ? opponentKey(opponent) : 0;
+}
+
+void OpponentShotLog::record(Point p)
+{
+	if (m_opponent == 0)
+		return;
+	if (m_nShots < 255)
+		m_nShots++;
+	if (m_game.isValid(p) && m_order[p.r * MAXCOLS + p.c] == 0) //only the first shot at a cell counts
+		m_order[p.r * MAXCOLS + p.c] = m_nShots;
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
@@ -22,13 +115,17 @@ public:
 	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
 		bool shipDestroyed, int shipId);
 	virtual void recordAttackByOpponent(Point p);
+	virtual void recordOpponent(const Player& opponent) { m_opponentShots.setOpponent(opponent); }
 private:
-	Point m_lastCellAttacked;
+	AwfulState m_state;
+	OpponentShotLog m_opponentShots;
 };
 
 AwfulPlayer::AwfulPlayer(string nm, const Game& g)
-	: Player(nm, g), m_lastCellAttacked(0, 0)
-{}
+	: Player(nm, g), m_opponentShots(g)
+{
+	m_state.start();
+}
 
 bool AwfulPlayer::placeShips(Board& b)
 {
@@ -41,17 +138,7 @@ bool AwfulPlayer::placeShips(Board& b)
 
 Point AwfulPlayer::recommendAttack()
 {
-	if (m_lastCellAttacked.c > 0)
-		m_lastCellAttacked.c--;
-	else
-	{
-		m_lastCellAttacked.c = game().cols() - 1;
-		if (m_lastCellAttacked.r > 0)
-			m_lastCellAttacked.r--;
-		else
-			m_lastCellAttacked.r = game().rows() - 1;
-	}
-	return m_lastCellAttacked;
+	return m_state.recommendAttack(game());
 }
 
 void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
@@ -61,9 +148,68 @@ void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
 	// AwfulPlayer completely ignores the result of any attack
 }
 
-void AwfulPlayer::recordAttackByOpponent(Point /* p */)
+void AwfulPlayer::recordAttackByOpponent(Point p)
 {
-	// AwfulPlayer completely ignores what the opponent does
+	// AwfulPlayer ignores what the opponent does, but the ShotStore doesn't
+	m_opponentShots.record(p);
+}
+
+// Places each ship at a random top or left cell and direction that fits,
+// so every placement of a ship is equally likely given the ships before it
+bool placeAtRandom(Board& b, const Game& g)
+{
+	const int MAXLAYOUTS = 50;
+	const int MAXTRIES = 100;
+	for (int layout = 0; layout < MAXLAYOUTS; layout++)
+	{
+		b.clear();
+		int i;
+		for (i = 0; i < g.nShips(); i++)
+		{
+			int tries;
+			for (tries = 0; tries < MAXTRIES; tries++)
+			{
+				Point p = g.randomPoint();
+				if (b.placeShip(p, i, randInt(2) == 0 ? HORIZONTAL : VERTICAL))
+					break;
+			}
+			if (tries == MAXTRIES)
+				break;
+		}
+		if (i == g.nShips())
+			return true;
+	}
+	b.clear();
+	return false;
+}
+
+//*********************************************************************
+//  HunterPlayer
+//*********************************************************************
+
+// HunterPlayer places its ships at random and hunts without ever targeting:
+// "random" fires at any cell not yet tried, "parity" at the cells of one
+// colour of the checkerboard first.
+
+class HunterPlayer : public Player
+{
+public:
+	HunterPlayer(string nm, const Game& g, bool parity);
+	virtual bool placeShips(Board& b) { return placeAtRandom(b, game()); }
+	virtual Point recommendAttack() { return m_state.recommendAttack(game()); }
+	virtual void recordAttackResult(Point p, bool /* validShot */, bool /* shotHit */,
+		bool /* shipDestroyed */, int /* shipId */) { m_state.recordAttackResult(game(), p); }
+	virtual void recordAttackByOpponent(Point p) { m_opponentShots.record(p); }
+	virtual void recordOpponent(const Player& opponent) { m_opponentShots.setOpponent(opponent); }
+private:
+	HunterState m_state;
+	OpponentShotLog m_opponentShots;
+};
+
+HunterPlayer::HunterPlayer(string nm, const Game& g, bool parity)
+	: Player(nm, g), m_opponentShots(g)
+{
+	m_state.start(g, parity);
 }
 
 //*********************************************************************
@@ -90,11 +236,13 @@ public:
 	virtual bool placeShips(Board& b);
 	virtual Point recommendAttack();
 	virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId) {}
-	virtual void recordAttackByOpponent(Point p) {}
+	virtual void recordAttackByOpponent(Point p) { m_opponentShots.record(p); }
+	virtual void recordOpponent(const Player& opponent) { m_opponentShots.setOpponent(opponent); }
 private:
 	bool shipCantFit(Board& b, Direction d, int shipId);
+	OpponentShotLog m_opponentShots;
 };
-HumanPlayer::HumanPlayer(string nm, const Game& g) : Player(nm, g)
+HumanPlayer::HumanPlayer(string nm, const Game& g) : Player(nm, g), m_opponentShots(g)
 {}
 bool HumanPlayer::isHuman() const
 {
@@ -203,16 +351,18 @@ public:
 	virtual bool placeShips(Board& b);
 	virtual Point recommendAttack();
 	virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
-	virtual void recordAttackByOpponent(Point p) {}
+	virtual void recordAttackByOpponent(Point p) { m_opponentShots.record(p); }
+	virtual void recordOpponent(const Player& opponent) { m_opponentShots.setOpponent(opponent); }
 private:
 	bool shipRec(Board& b, int shipId);
-	int state;
-	vector<Point> attacks;
-	Point transition;
+	MediocreState m_state;
+	OpponentShotLog m_opponentShots;
 
 };
-MediocrePlayer::MediocrePlayer(string nm, const Game& g) : Player(nm, g), state(1)
-{}
+MediocrePlayer::MediocrePlayer(string nm, const Game& g) : Player(nm, g), m_opponentShots(g)
+{
+	m_state.start();
+}
 bool MediocrePlayer::placeShips(Board& b)
 {
 	for (int i = 0; i < 50; i++)  //tries to placeShips 50 times
@@ -256,88 +406,11 @@ bool MediocrePlayer::shipRec(Board& b, int shipId) //recursion that goes through
 
 Point MediocrePlayer::recommendAttack()
 {
-	if (state == 2) //in state 2, algorithm finishes off a ship
-	{
-		vector<Point> temp; //stores all points that could be attacked
-		for (int i = transition.r - 4; i <= transition.r + 4; i++) //add points up and down of transition point
-		{
-			Point p(i, transition.c);
-			if (game().isValid(p))
-			{
-				bool shouldPush = true;
-				for (int j = 0; j < attacks.size(); j++)
-				{
-					if (p.r == attacks[j].r && p.c == attacks[j].c)
-					{
-						shouldPush = false;
-						break;
-					}
-				}
-				if (shouldPush)
-					temp.push_back(p);
-			}
-		}
-		for (int i = transition.c - 4; i <= transition.c + 4; i++) //add points left and right of transition point
-		{
-			Point p(transition.r, i);
-			if (game().isValid(p))
-			{
-				bool shouldPush = true;
-				for (int j = 0; j < attacks.size(); j++)
-				{
-					if (p.r == attacks[j].r && p.c == attacks[j].c)
-					{
-						shouldPush = false;
-						break;
-					}
-				}
-				if (shouldPush)
-					temp.push_back(p);
-			}
-		}
-		if (temp.empty()) //if there are no more positions in cross to attack, do state 1 algorithm below
-		{
-			state = 1;
-		}
-		else
-		{
-			return temp[randInt(temp.size())]; //choose random point from temp
-		}
-	}
-	//state 1 algorithm
-	Point p = game().randomPoint(); //choose random point on grid that has not been attacked
-	for (int i = 0; i < attacks.size(); i++)
-	{
-		if (p.r == attacks[i].r && p.c == attacks[i].c)
-		{
-			p = game().randomPoint();
-			i = -1;
-		}
-	}
-	return p;
+	return m_state.recommendAttack(game());
 }
-void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int /* shipId */)
 {
-	if (validShot)
-	{
-		attacks.push_back(p); //keep track of all attacks
-		if (shotHit)
-		{
-			if (shipDestroyed)
-			{
-				if (state == 2)
-					state = 1; //if ship was destroyed in state 2, switch back to state 1
-			}
-			else
-			{
-				if (state == 1) //if a ship is found, switch to state 2 to target that ship
-				{
-					transition = p;
-					state = 2;
-				}
-			}
-		}
-	}
+	m_state.recordAttackResult(p, validShot, shotHit, shipDestroyed);
 }
 
 //*********************************************************************
@@ -347,41 +420,42 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
 class GoodPlayer : public Player
 {
 public:
-	GoodPlayer(string nm, const Game& g);
+	GoodPlayer(string nm, const Game& g, const GoodParams& params);
 	virtual bool placeShips(Board& b);
 	virtual Point recommendAttack();
+	virtual void recommendAttacks(int n, vector<Point>& shots, Deadline deadline);
 	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
 		bool shipDestroyed, int shipId);
-	virtual void recordAttackByOpponent(Point p) {}
+	virtual void recordAttackByOpponent(Point p) { m_opponentShots.record(p); }
+	virtual void recordOpponent(const Player& opponent);
+protected:
+	OpponentShotLog m_opponentShots;
 private:
-	bool isAttacked(Point p);
 	bool shipRec(Board& b, int shipId);
-	vector<Point> attacks;
-	Board m_b; //board keeps track of attacked positions and helps calculate probabilities
-	vector<bool> m_ships; //false if ship is destroyed, true if not
-	int state;
-	queue<Point> transition; //transition points (like in MediocrePlayer) but keeps track of all potential transitions
-	int dir; //determines direction of target attack 0=N, 1=E, 2=S, 3=W, -1=none
+	GoodParams m_params;
+	GoodState m_state;
+	LayoutPrior m_prior;
+	bool m_hasPrior;  //m_prior holds enough of the opponent's layouts to be used
 };
 
-bool GoodPlayer::isAttacked(Point p)  //helper function that sees if a point has been attacked before
+GoodPlayer::GoodPlayer(string nm, const Game& g, const GoodParams& params)
+	: Player(nm, g), m_opponentShots(g), m_params(params), m_hasPrior(false)
 {
-	for (int i = 0; i < attacks.size(); i++)
-	{
-		if (p.r == attacks[i].r&&p.c == attacks[i].c)
-			return true;
-	}
-	return false;
+	m_state.start(g);
 }
 
-GoodPlayer::GoodPlayer(string nm, const Game& g) : Player(nm, g), m_b(g), state(1), dir(-1)
+void GoodPlayer::recordOpponent(const Player& opponent)
 {
-	vector<bool> temp(g.nShips(), true);
-	m_ships = temp;
+	const int MINGAMES = 5;  //layouts of this opponent seen before the prior is trusted
+	m_opponentShots.setOpponent(opponent);
+	m_hasPrior = m_params.usePrior &&
+		LayoutStore::instance().prior(opponentKey(opponent), game().rows(), game().cols(), MINGAMES, m_prior);
 }
 
 bool GoodPlayer::placeShips(Board& b) //placeShips is same as MediocrePlayer (improvements not needed to reach 80% win rate)
 {
+	if (m_params.randomPlacement)
+		return placeAtRandom(b, game());
 	for (int i = 0; i < 50; i++)
 	{
 		b.block();
@@ -421,184 +495,508 @@ bool GoodPlayer::shipRec(Board& b, int shipId)
 
 Point GoodPlayer::recommendAttack()
 {
-	if (state == 2) //state 2 is an enhanced "target" algorithm that more efficiently destroys a ship
+	return m_state.recommendAttack(game(), m_params, m_hasPrior ? &m_prior : nullptr);
+}
+
+void GoodPlayer::recommendAttacks(int n, vector<Point>& shots, Deadline /* deadline */)
+{
+	m_state.recommendAttacks(game(), m_params, n, shots, m_hasPrior ? &m_prior : nullptr);
+}
+
+void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	m_state.recordAttackResult(game(), p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+
+
+
+
+
+
+
+
+//*********************************************************************
+//  AdaptivePlayer
+//*********************************************************************
+
+// AdaptivePlayer attacks like GoodPlayer, but once the ShotStore has seen
+// enough games against this kind of opponent it places its ships in the
+// cells such opponents tend to reach last, and hunts with a prior from
+// where the opponent's ships were in earlier games.
+
+GoodParams adaptiveParams()
+{
+	GoodParams params;
+	params.usePrior = true;
+	return params;
+}
+
+class AdaptivePlayer : public GoodPlayer
+{
+public:
+	AdaptivePlayer(string nm, const Game& g) : GoodPlayer(nm, g, adaptiveParams()) {}
+	virtual bool placeShips(Board& b);
+private:
+	struct Placement
 	{
-		while (!transition.empty())
+		Point topOrLeft;
+		Direction dir;
+	};
+	bool randomLayout(Board& b, vector<Placement>& layout);
+};
+
+bool AdaptivePlayer::randomLayout(Board& b, vector<Placement>& layout) //places every ship at random, b must be empty
+{
+	layout.clear();
+	for (int i = 0; i < game().nShips(); i++)
+	{
+		Placement pl;
+		int tries;
+		for (tries = 0; tries < 100; tries++)
 		{
-			if (dir == 0) //North
-			{
-				for (int i = 2; i < game().rows(); i++)
-				{
-					if (game().isValid(Point(transition.front().r - i, transition.front().c)) && !isAttacked(Point(transition.front().r - i, transition.front().c)))
-						return Point(transition.front().r - i, transition.front().c);
-				}
-				dir = -1;
-			}
-			else if (dir == 1) //east
-			{
-				for (int i = 2; i < game().cols(); i++)
-				{
-					if (game().isValid(Point(transition.front().r, transition.front().c + i)) && !isAttacked(Point(transition.front().r, transition.front().c + i)))
-						return Point(transition.front().r, transition.front().c + i);
-				}
-				dir = -1;
-			}
-			else if (dir == 2) //south
-			{
-				for (int i = 2; i < game().rows(); i++)
-				{
-					if (game().isValid(Point(transition.front().r + i, transition.front().c)) && !isAttacked(Point(transition.front().r + i, transition.front().c)))
-						return Point(transition.front().r + i, transition.front().c);
-				}
-				dir = -1;
-			}
-			else if (dir == 3) //west
-			{
-				for (int i = 2; i < game().cols(); i++)
-				{
-					if (game().isValid(Point(transition.front().r, transition.front().c - i)) && !isAttacked(Point(transition.front().r, transition.front().c - i)))
-						return Point(transition.front().r, transition.front().c - i);
-				}
-				dir = -1;
-			}
-			if (dir == -1) //if direction not yet determined
-			{
-				if (game().isValid(Point(transition.front().r - 1, transition.front().c)) && !isAttacked(Point(transition.front().r - 1, transition.front().c)))
-					return Point(transition.front().r - 1, transition.front().c);
-				if (game().isValid(Point(transition.front().r, transition.front().c + 1)) && !isAttacked(Point(transition.front().r, transition.front().c + 1)))
-					return Point(transition.front().r, transition.front().c + 1);
-				if (game().isValid(Point(transition.front().r + 1, transition.front().c)) && !isAttacked(Point(transition.front().r + 1, transition.front().c)))
-					return Point(transition.front().r + 1, transition.front().c);
-				if (game().isValid(Point(transition.front().r, transition.front().c - 1)) && !isAttacked(Point(transition.front().r, transition.front().c - 1)))
-					return Point(transition.front().r, transition.front().c - 1);
-			}
-			transition.pop();
+			pl.topOrLeft = game().randomPoint();
+			pl.dir = (randInt(2) == 0 ? HORIZONTAL : VERTICAL);
+			if (b.placeShip(pl.topOrLeft, i, pl.dir))
+				break;
 		}
-	}//state 1 estimates the probability that a ship will be at a certain Point and chooses most likely point
-	vector<int> row(game().cols(), 1);
-	vector<vector<int>> probabilities(game().rows(), row); //probability calculated by adding each permutation in which a ship can be at each point, then multiplying permutations for all ships
-	for (int i = 0; i < game().nShips(); i++)
+		if (tries == 100)
+			return false;
+		layout.push_back(pl);
+	}
+	return true;
+}
+
+bool AdaptivePlayer::placeShips(Board& b)
+{
+	const int MINGAMES = 5;   //games against this opponent before the store is trusted
+	const int NLAYOUTS = 100; //random layouts to choose from
+
+	double late[MAXROWS][MAXCOLS];
+	if (!ShotStore::instance().lateness(m_opponentShots.opponent(), game().rows(), game().cols(), MINGAMES, late))
+		return GoodPlayer::placeShips(b);
+
+	vector<Placement> layout;
+	vector<Placement> best;
+	double bestScore = -1;
+	for (int k = 0; k < NLAYOUTS; k++)
 	{
-		if (m_ships[i]) //only looks at ships that aren't destroyed
+		b.clear();
+		if (!randomLayout(b, layout))
+			continue;
+		double score = 0; //sum over the ships' cells of how late the opponent gets there
+		for (int i = 0; i < layout.size(); i++)
 		{
-			vector<int> temp(game().cols(), 0);
-			vector<vector<int>> prob(game().rows(), temp);
-			for (int r = 0; r < game().rows(); r++)
+			for (int j = 0; j < game().shipLength(i); j++)
 			{
-				for (int c = 0; c < game().cols(); c++)
-				{
-					if (m_b.placeShip(Point(r, c), i, VERTICAL)) //places and unplaces ships to add up all possible configurations of ship
-					{
-						for (int j = 0; j < game().shipLength(i); j++)
-						{
-							prob[r + j][c]++;
-						}
-						m_b.unplaceShip(Point(r, c), i, VERTICAL);
-					}
-					if (m_b.placeShip(Point(r, c), i, HORIZONTAL))
-					{
-						for (int j = 0; j < game().shipLength(i); j++)
-						{
-							prob[r][c + j]++;
-						}
-						m_b.unplaceShip(Point(r, c), i, HORIZONTAL);
-					}
-				}
-			}
-			for (int r = 0; r < probabilities.size(); r++)
-			{
-				for (int c = 0; c < probabilities[r].size(); c++)
-				{
-					probabilities[r][c] *= prob[r][c];
-				}
+				if (layout[i].dir == HORIZONTAL)
+					score += late[layout[i].topOrLeft.r][layout[i].topOrLeft.c + j];
+				else
+					score += late[layout[i].topOrLeft.r + j][layout[i].topOrLeft.c];
 			}
 		}
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = layout;
+		}
 	}
-	int maxProb = 0; //find the maximum probability among all Points
-	for (int r = 0; r < probabilities.size(); r++)
+	b.clear();
+	if (best.empty())
+		return GoodPlayer::placeShips(b);
+	for (int i = 0; i < best.size(); i++)
+		b.placeShip(best[i].topOrLeft, i, best[i].dir);
+	return true;
+}
+
+//*********************************************************************
+//  ExactPlayer
+//*********************************************************************
+
+// ExactPlayer attacks like GoodPlayer until only a few ships are afloat.
+// Then the layouts left are few enough to count exactly, and it fires at
+// the cell that holds a ship in the most of them; in a salvo, at the cells
+// that do.
+
+class ExactPlayer : public GoodPlayer
+{
+public:
+	ExactPlayer(string nm, const Game& g)
+		: GoodPlayer(nm, g, GoodParams()), m_counter(g, 1), m_seen(g.nShips()), m_afloat(g.nShips())
+	{}
+	virtual Point recommendAttack();
+	virtual void recommendAttacks(int n, vector<Point>& shots, Deadline deadline);
+	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+		bool shipDestroyed, int shipId);
+private:
+	static const int ENDGAMESHIPS = 3;  //ships afloat when counting takes over
+	LayoutCounter m_counter;
+	FleetObservations m_seen;
+	int m_afloat;
+};
+
+Point ExactPlayer::recommendAttack()
+{
+	if (m_afloat > ENDGAMESHIPS)
+		return GoodPlayer::recommendAttack();
+	LayoutCount exact;
+	m_counter.count(m_seen, exact);
+	unsigned long long most = 0;
+	Point best[MAXROWS * MAXCOLS];
+	int nBest = 0;
+	for (int r = 0; r < game().rows(); r++)
 	{
-		for (int c = 0; c < probabilities[r].size(); c++)
+		for (int c = 0; c < game().cols(); c++)
 		{
-			if (probabilities[r][c] > maxProb)
-				maxProb = probabilities[r][c];
+			Point p(r, c);
+			if (m_seen.hit.test(p) || m_seen.missed.test(p) || exact.covering[r][c] < most)
+				continue;
+			if (exact.covering[r][c] > most)
+				nBest = 0;
+			most = exact.covering[r][c];
+			best[nBest++] = p;
 		}
 	}
-	vector<Point> targets;
-	for (int r = 0; r < probabilities.size(); r++)
+	if (nBest == 0) //nothing fits what was seen, so the counts can't help
+		return GoodPlayer::recommendAttack();
+	return best[randInt(nBest)];
+}
+
+void ExactPlayer::recommendAttacks(int n, vector<Point>& shots, Deadline deadline)
+{
+	if (m_afloat > ENDGAMESHIPS)
+	{
+		GoodPlayer::recommendAttacks(n, shots, deadline);
+		return;
+	}
+	//the n unshot cells covered by the most layouts, ties broken at random
+	LayoutCount exact;
+	m_counter.count(m_seen, exact);
+	struct Candidate
+	{
+		unsigned long long covering;
+		int tie;
+		Point p;
+	};
+	Candidate candidates[MAXROWS * MAXCOLS];
+	int nCandidates = 0;
+	for (int r = 0; r < game().rows(); r++)
 	{
-		for (int c = 0; c < probabilities[r].size(); c++)
+		for (int c = 0; c < game().cols(); c++)
 		{
-			if (probabilities[r][c] == maxProb)
-				targets.push_back(Point(r, c));
+			Point p(r, c);
+			if (m_seen.hit.test(p) || m_seen.missed.test(p) || exact.covering[r][c] == 0)
+				continue;
+			Candidate cand = { exact.covering[r][c], randInt(1 << 30), p };
+			candidates[nCandidates++] = cand;
 		}
 	}
+	if (nCandidates == 0) //nothing fits what was seen, so the counts can't help
+	{
+		GoodPlayer::recommendAttacks(n, shots, deadline);
+		return;
+	}
+	int wanted = min(n, nCandidates);
+	partial_sort(candidates, candidates + wanted, candidates + nCandidates,
+		[](const Candidate& x, const Candidate& y) { return x.covering > y.covering || (x.covering == y.covering && x.tie < y.tie); });
+	shots.clear();
+	for (int i = 0; i < wanted; i++)
+		shots.push_back(candidates[i].p);
+}
 
-	return targets[randInt(targets.size())]; //choose random Point among all maximum probability points
+void ExactPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	GoodPlayer::recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+	if (!validShot)
+		return;
+	m_seen.record(p, shotHit, shotHit && shipDestroyed, shipId);
+	if (shotHit && shipDestroyed)
+		m_afloat--;
 }
-void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+
+//*********************************************************************
+//  BotPlayer
+//*********************************************************************
+
+// A BotPlayer forwards every Player call to an external program over its
+// stdin/stdout.  The protocol is line based; r and c are row and column:
+//
+//   game <rows> <cols> <nShips> <len0> <len1> ...   start a new game
+//   place        reply: "<r> <c> <h|v>" for each ship on one line, or "fail"
+//   attack       reply: "<r> <c>"
+//   result <r> <c> <valid> <hit> <destroyed> <shipId>   (flags are 0/1)
+//   opponent <r> <c>
+//   end          the game is over
+//
+// Only place and attack are answered.  Everything else is queued and goes
+// out in the same write as the next request, so a turn costs one write and
+// one read.  The attack request for the next turn is sent as soon as the
+// opponent's shot is known, so the bot can work on it while we are busy
+// elsewhere.  Bot processes are kept after a game ends and reused by the
+// next BotPlayer with the same command, and whatever the old game still had
+// queued is sent together with the new game's first request.
+//
+// A process serves one game at a time, so messages are only ever batched
+// within a game; requests from different games never share a write.  A bot
+// that exits, sends a reply that can't be parsed, or doesn't answer a
+// request that has no deadline within BOT_REPLY_MS loses the game, and its
+// process is killed rather than reused, so the next game starts a fresh one.
+// An attack that misses the move's deadline only loses the turn: its reply
+// stays owed and is skipped when it arrives.  A bot still that far behind
+// when the game ends is killed too.
+
+const int BOT_REPLY_MS = 10000;
+
+struct BotConnection
+{
+	ChildProcess proc;
+	string out;        //queued messages not yet written
+	int repliesOwed;   //requests written whose replies nobody has read
+	bool broken;       //a write or read failed, so the bot's state is unknown
+	bool behind;       //a reply missed its deadline and hasn't arrived yet
+};
+
+class BotPool
 {
-	bool a;
-	bool b;
-	int c;
-	m_b.attack(p, a, b, c); //attacks recorded on board and vector
-	attacks.push_back(p);
-	if (validShot)
+public:
+	~BotPool();
+	BotConnection* acquire(const string& command);
+	void release(const string& command, BotConnection* conn);
+private:
+	mutex m_mutex;
+	map<string, vector<BotConnection*>> m_idle;
+};
+
+BotPool::~BotPool()
+{
+	for (map<string, vector<BotConnection*>>::iterator it = m_idle.begin(); it != m_idle.end(); it++)
 	{
-		if (shotHit)
+		for (int i = 0; i < it->second.size(); i++)
 		{
-			if (shipDestroyed)
-			{
-				m_ships[shipId] = false;
-				dir = -1;
-				if (transition.empty())
-					state = 1;
-				else
-					transition.pop(); //look at next transition point
-			}
+			it->second[i]->proc.write(it->second[i]->out);
+			delete it->second[i];  //closing the pipes tells the bot to exit
+		}
+	}
+}
+
+BotConnection* BotPool::acquire(const string& command)
+{
+	lock_guard<mutex> lock(m_mutex);
+	vector<BotConnection*>& idle = m_idle[command];
+	if (!idle.empty())
+	{
+		BotConnection* conn = idle.back();
+		idle.pop_back();
+		return conn;
+	}
+	BotConnection* conn = new BotConnection;
+	conn->repliesOwed = 0;
+	conn->broken = false;
+	conn->behind = false;
+	if (!conn->proc.start(command))
+	{
+		delete conn;
+		return nullptr;
+	}
+	return conn;
+}
+
+void BotPool::release(const string& command, BotConnection* conn)
+{
+	if (conn->broken || conn->behind || !conn->proc.isRunning())
+	{
+		conn->proc.kill();  //it may be hung, so don't wait for it to exit
+		delete conn;
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	m_idle[command].push_back(conn);
+}
+
+BotPool& botPool()
+{
+	static BotPool pool;
+	return pool;
+}
+
+class BotPlayer : public Player
+{
+public:
+	BotPlayer(string nm, const Game& g, string command, BotConnection* conn);
+	virtual ~BotPlayer();
+	virtual bool placeShips(Board& b);
+	virtual Point recommendAttack();
+	virtual Point recommendAttackBefore(Deadline deadline);
+	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+		bool shipDestroyed, int shipId);
+	virtual void recordAttackByOpponent(Point p);
+private:
+	bool sendRequest(const char* request);
+	bool readReply(string& reply, Deadline deadline);
+	string m_command;
+	BotConnection* m_conn;
+	bool m_attackRequested; //the next attack has already been asked for
+};
+
+BotPlayer::BotPlayer(string nm, const Game& g, string command, BotConnection* conn)
+	: Player(nm, g), m_command(command), m_conn(conn), m_attackRequested(false)
+{}
+
+BotPlayer::~BotPlayer()
+{
+	m_conn->out += "end\n";  //goes out with the next game's first request
+	botPool().release(m_command, m_conn);
+}
+
+bool BotPlayer::sendRequest(const char* request)
+{
+	if (m_conn->broken)
+		return false;
+	m_conn->out += request;
+	bool ok = m_conn->proc.write(m_conn->out);
+	m_conn->out.clear();
+	if (ok)
+		m_conn->repliesOwed++;
+	else
+		m_conn->broken = true;
+	return ok;
+}
+
+bool BotPlayer::readReply(string& reply, Deadline deadline)
+{
+	if (m_conn->broken)
+		return false;
+	while (m_conn->repliesOwed > 0)
+	{
+		int timeoutMs = BOT_REPLY_MS;
+		if (deadline != noDeadline())
+		{
+			chrono::steady_clock::duration left = deadline - chrono::steady_clock::now();
+			timeoutMs = max(0, (int)chrono::duration_cast<chrono::milliseconds>(left).count() + 1);
+		}
+		if (!m_conn->proc.readLine(reply, timeoutMs))
+		{
+			//past the deadline the bot is only late, unless it has exited
+			if (deadline == noDeadline() || !m_conn->proc.isRunning())
+				m_conn->broken = true;
 			else
-			{
-				transition.push(p);
-				if (state == 2 && dir == -1) //determine direction
-				{
-					if (p.r == transition.front().r - 1)
-						dir = 0;
-					else if (p.c == transition.front().c + 1)
-						dir = 1;
-					else if (p.r == transition.front().r + 1)
-						dir = 2;
-					else if (p.c == transition.front().c - 1)
-						dir = 3;
-				}
-				if (state == 1)
-				{
-					state = 2;
-				}
-			}
+				m_conn->behind = true;
+			return false;
 		}
-		else
+		m_conn->repliesOwed--;
+		if (m_conn->repliesOwed == 0) //earlier replies were to late requests or a game that has ended
 		{
-			if (state == 2)
-				dir = -1;  //previously chosen direction is incorrect, determine direction again
+			m_conn->behind = false;
+			return true;
 		}
 	}
+	return false;
 }
 
+bool BotPlayer::placeShips(Board& b)
+{
+	ostringstream header;
+	header << "game " << game().rows() << ' ' << game().cols() << ' ' << game().nShips();
+	for (int i = 0; i < game().nShips(); i++)
+		header << ' ' << game().shipLength(i);
+	header << '\n';
+	m_conn->out += header.str();
 
+	string reply;
+	if (!sendRequest("place\n") || !readReply(reply, noDeadline()))
+		return false;
+	istringstream in(reply);
+	vector<Point> placed;
+	vector<Direction> dirs;
+	for (int i = 0; i < game().nShips(); i++)
+	{
+		Point p;
+		char d = 'h';
+		bool ok = (in >> p.r >> p.c >> d) && (d == 'h' || d == 'v');
+		if (!ok)
+			m_conn->broken = true;
+		Direction dir = (d == 'h' ? HORIZONTAL : VERTICAL);
+		if (!ok || !b.placeShip(p, i, dir))
+		{
+			//leave the board as we found it
+			for (int j = 0; j < placed.size(); j++)
+				b.unplaceShip(placed[j], j, dirs[j]);
+			return false;
+		}
+		placed.push_back(p);
+		dirs.push_back(dir);
+	}
+	return true;
+}
 
+Point BotPlayer::recommendAttack()
+{
+	return recommendAttackBefore(noDeadline());
+}
 
+Point BotPlayer::recommendAttackBefore(Deadline deadline)
+{
+	if (!m_attackRequested && !sendRequest("attack\n"))
+		return Point(-1, -1);
+	m_attackRequested = false;
+	string reply;
+	if (!readReply(reply, deadline))
+		return Point(-1, -1);
+	Point p(-1, -1);
+	istringstream in(reply);
+	if (!(in >> p.r >> p.c))
+	{
+		m_conn->broken = true;
+		return Point(-1, -1);
+	}
+	return p;
+}
 
+void BotPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+	ostringstream msg;
+	msg << "result " << p.r << ' ' << p.c << ' ' << validShot << ' ' << shotHit
+		<< ' ' << shipDestroyed << ' ' << shipId << '\n';
+	m_conn->out += msg.str();
+}
 
-
-
+void BotPlayer::recordAttackByOpponent(Point p)
+{
+	//the opponent's shot is the last thing we learn before our next turn,
+	//so ask for that turn's attack in the same write
+	ostringstream msg;
+	msg << "opponent " << p.r << ' ' << p.c << '\n';
+	m_conn->out += msg.str();
+	m_attackRequested = sendRequest("attack\n");
+}
 
 //*********************************************************************
 //  createPlayer
 //*********************************************************************
 
-Player* createPlayer(string type, string nm, const Game& g)
+static Player* newPlayer(const string& type, const string& nm, const Game& g)
 {
+	if (type.compare(0, 4, "bot:") == 0) //"bot:<command>" runs an external program
+	{
+		BotConnection* conn = botPool().acquire(type.substr(4));
+		if (conn == nullptr)
+			return nullptr;
+		return new BotPlayer(nm, g, type.substr(4), conn);
+	}
+	if (type == "mcts") //"mcts:<ms>" sets the thinking time per move
+		return createMctsPlayer(nm, g, 100, 0);
+	if (type.compare(0, 5, "mcts:") == 0)
+		return createMctsPlayer(nm, g, atoi(type.c_str() + 5), 0);
+	if (type.compare(0, 5, "good:") == 0) //"good:<spec>" changes GoodParams, e.g. "good:combine=sum"
+	{
+		GoodParams params;
+		if (!params.parse(type.substr(5)))
+			return nullptr;
+		return new GoodPlayer(nm, g, params);
+	}
+
 	static string types[] = {
-		"human", "awful", "mediocre", "good"
+		"human", "awful", "mediocre", "good", "adaptive", "exact", "random", "parity"
 	};
 
 	int pos;
@@ -610,7 +1008,19 @@ Player* createPlayer(string type, string nm, const Game& g)
 	case 0:  return new HumanPlayer(nm, g);
 	case 1:  return new AwfulPlayer(nm, g);
 	case 2:  return new MediocrePlayer(nm, g);
-	case 3:  return new GoodPlayer(nm, g);
+	case 3:  return new GoodPlayer(nm, g, GoodParams());
+	case 4:  return new AdaptivePlayer(nm, g);
+	case 5:  return new ExactPlayer(nm, g);
+	case 6:  return new HunterPlayer(nm, g, false);
+	case 7:  return new HunterPlayer(nm, g, true);
 	default: return nullptr;
 	}
+}
+
+Player* createPlayer(string type, string nm, const Game& g)
+{
+	Player* p = newPlayer(type, nm, g);
+	if (p != nullptr)
+		p->m_type = type;  //what the stores know this kind of player by
+	return p;
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include "Timing.h"
 #include <string>
+#include <vector>
 
 class Point;
+struct ShotResult;
 class Board;
 class Game;
 
@@ -16,22 +19,35 @@ public:
 
 	virtual ~Player() {}
 
-	std::string name() const { return m_name; }
+	const std::string& name() const { return m_name; }
 	const Game& game() const { return m_game; }
+	// The type createPlayer made this player from; empty if it wasn't
+	const std::string& type() const { return m_type; }
 
 	virtual bool isHuman() const { return false; }
 
 	virtual bool placeShips(Board& b) = 0;
 	virtual Point recommendAttack() = 0;
+	// Players that can use more time override this: they should keep
+	// improving their choice and return the best one found by deadline
+	virtual Point recommendAttackBefore(Deadline deadline);
 	virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
 		bool shipDestroyed, int shipId) = 0;
 	virtual void recordAttackByOpponent(Point p) = 0;
+	virtual void recordOpponent(const Player& /* opponent */) {} //called before placeShips
+	// In the salvo variant a player fires n shots a turn and hears about
+	// them together.  By default the player is asked for one shot at a time
+	// and told the results one by one.
+	virtual void recommendAttacks(int n, std::vector<Point>& shots, Deadline deadline);
+	virtual void recordSalvoResult(const std::vector<ShotResult>& results);
 	// We prevent any kind of Player object from being copied or assigned
 	Player(const Player&) = delete;
 	Player& operator=(const Player&) = delete;
 
 private:
+	friend Player* createPlayer(std::string type, std::string nm, const Game& g);
 	std::string m_name;
+	std::string m_type;
 	const Game& m_game;
 };
 
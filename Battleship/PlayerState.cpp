@@ -0,0 +1,460 @@
+#include "PlayerState.h"
+#include "Game.h"
+#include "EndgameTable.h"
+#include "LayoutStore.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const int NCELLS = MAXROWS * MAXCOLS;
+
+//******************** AwfulState functions ***************************
+
+void AwfulState::start()
+{
+	r = c = 0;
+}
+
+Point AwfulState::recommendAttack(const Game& g)
+{
+	if (c > 0)
+		c--;
+	else
+	{
+		c = g.cols() - 1;
+		if (r > 0)
+			r--;
+		else
+			r = g.rows() - 1;
+	}
+	return Point(r, c);
+}
+
+//******************** MediocreState functions ************************
+
+void MediocreState::start()
+{
+	attacked.clear();
+	state = 1;
+	transition = 0;
+}
+
+Point MediocreState::recommendAttack(const Game& g)
+{
+	if (state == 2) //in state 2, algorithm finishes off a ship
+	{
+		Point t = CellSet::point(transition);
+		Point temp[4 * 4 + 2]; //every unattacked point within 4 of transition, up and down then left and right
+		int n = 0;
+		for (int i = t.r - 4; i <= t.r + 4; i++)
+		{
+			Point p(i, t.c);
+			if (g.isValid(p) && !attacked.test(p))
+				temp[n++] = p;
+		}
+		for (int i = t.c - 4; i <= t.c + 4; i++)
+		{
+			Point p(t.r, i);
+			if (g.isValid(p) && !attacked.test(p))
+				temp[n++] = p;
+		}
+		if (n > 0)
+			return temp[randInt(n)];
+		state = 1; //if there are no more positions in cross to attack, do state 1 algorithm below
+	}
+	//state 1 algorithm
+	Point p = g.randomPoint(); //choose random point on grid that has not been attacked
+	while (attacked.test(p))
+		p = g.randomPoint();
+	return p;
+}
+
+void MediocreState::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed)
+{
+	if (!validShot)
+		return;
+	attacked.set(p);
+	if (shotHit)
+	{
+		if (shipDestroyed)
+		{
+			if (state == 2)
+				state = 1; //if ship was destroyed in state 2, switch back to state 1
+		}
+		else if (state == 1) //if a ship is found, switch to state 2 to target that ship
+		{
+			transition = CellSet::index(p);
+			state = 2;
+		}
+	}
+}
+
+//******************** HunterState functions **************************
+
+void HunterState::start(const Game& g, bool parity)
+{
+	open = boardCells(g.rows(), g.cols());
+	first.clear();
+	if (parity)
+		for (int r = 0; r < g.rows(); r++)
+			for (int c = r % 2; c < g.cols(); c += 2)
+				first.set(Point(r, c));
+}
+
+Point HunterState::recommendAttack(const Game& /* g */)
+{
+	CellSet choices = open & first;
+	if (choices.none())
+		choices = open;
+	if (choices.none()) //every cell has been tried
+		return Point(0, 0);
+	return CellSet::point(choices.nth(randInt(choices.count())));
+}
+
+void HunterState::recordAttackResult(const Game& g, Point p)
+{
+	if (g.isValid(p))
+		open.reset(p);
+}
+
+//******************** GoodParams functions ***************************
+
+const char DIRECTIONS[] = "NESW";
+
+GoodParams::GoodParams()
+	: followLine(true), multiply(true), randomPlacement(false), usePrior(false)
+{
+	for (int d = 0; d < 4; d++)
+		probe[d] = d;
+}
+
+bool GoodParams::parse(const string& spec)
+{
+	GoodParams p = *this;
+	istringstream in(spec);
+	string item;
+	while (getline(in, item, ','))
+	{
+		size_t eq = item.find('=');
+		if (eq == string::npos)
+			return false;
+		string key = item.substr(0, eq);
+		string value = item.substr(eq + 1);
+		if (key == "probe")
+		{
+			//a permutation of N, E, S and W
+			if (value.size() != 4)
+				return false;
+			int seen = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				const char* d = strchr(DIRECTIONS, value[i]);
+				if (d == nullptr || value[i] == '\0' || (seen >> (d - DIRECTIONS) & 1))
+					return false;
+				p.probe[i] = d - DIRECTIONS;
+				seen |= 1 << (d - DIRECTIONS);
+			}
+		}
+		else if (key == "line" && (value == "0" || value == "1"))
+			p.followLine = (value == "1");
+		else if (key == "combine" && (value == "product" || value == "sum"))
+			p.multiply = (value == "product");
+		else if (key == "place" && (value == "backtrack" || value == "random"))
+			p.randomPlacement = (value == "random");
+		else if (key == "prior" && (value == "0" || value == "1"))
+			p.usePrior = (value == "1");
+		else
+			return false;
+	}
+	*this = p;
+	return true;
+}
+
+string GoodParams::str() const
+{
+	string probes;
+	for (int i = 0; i < 4; i++)
+		probes += DIRECTIONS[probe[i]];
+	return "probe=" + probes + ",line=" + (followLine ? "1" : "0") + ",combine=" +
+		(multiply ? "product" : "sum") + ",place=" + (randomPlacement ? "random" : "backtrack") + ",prior=" + (usePrior ? "1" : "0");
+}
+
+//******************** GoodState functions ****************************
+
+// Lookup tables for target mode on the largest board, by direction and
+// cell index: the neighbouring cell (-1 off the board), and the cells from
+// two steps away to the edge.  Cells off a smaller board are closed in
+// every GoodState, so one table serves all board sizes.
+struct TargetRays
+{
+	int step[4][NCELLS];
+	CellSet ray[4][NCELLS];
+
+	TargetRays()
+	{
+		const int dr[4] = { -1, 0, 1, 0 };
+		const int dc[4] = { 0, 1, 0, -1 };
+		for (int r = 0; r < MAXROWS; r++)
+		{
+			for (int c = 0; c < MAXCOLS; c++)
+			{
+				int cell = CellSet::index(Point(r, c));
+				for (int d = 0; d < 4; d++)
+				{
+					int rr = r + dr[d];
+					int cc = c + dc[d];
+					step[d][cell] = (rr >= 0 && rr < MAXROWS && cc >= 0 && cc < MAXCOLS) ? CellSet::index(Point(rr, cc)) : -1;
+					for (rr += dr[d], cc += dc[d]; rr >= 0 && rr < MAXROWS && cc >= 0 && cc < MAXCOLS; rr += dr[d], cc += dc[d])
+						ray[d][cell].set(Point(rr, cc));
+				}
+			}
+		}
+	}
+};
+
+const TargetRays& targetRays()
+{
+	static const TargetRays rays;
+	return rays;
+}
+
+void GoodState::start(const Game& g)
+{
+	closed = ~boardCells(g.rows(), g.cols());
+	afloat = ~0ULL;
+	state = 1;
+	dir = -1;
+	head = tail = 0;
+}
+
+int GoodState::untriedAlong(int d, int origin) const  //nearest open cell from two steps away in direction d, -1 if none
+{
+	CellSet untried = targetRays().ray[d][origin].minus(closed);
+	return (d == 1 || d == 2) ? untried.first() : untried.last(); //east and south have increasing indexes
+}
+
+Point GoodState::recommendAttack(const Game& g, const GoodParams& params, const LayoutPrior* prior)
+{
+	if (state == 2) //state 2 is an enhanced "target" algorithm that more efficiently destroys a ship
+	{
+		const TargetRays& rays = targetRays();
+		for (; head != tail; head++)
+		{
+			int origin = pending[head];
+			if (dir != -1 && params.followLine) //keep going the way the hits line up
+			{
+				int next = untriedAlong(dir, origin);
+				if (next >= 0)
+					return CellSet::point(next);
+				dir = -1;
+			}
+			for (int i = 0; i < 4; i++) //direction not yet determined, try the neighbours in probe order
+			{
+				int next = rays.step[params.probe[i]][origin];
+				if (next >= 0 && !closed.test(next))
+					return CellSet::point(next);
+			}
+		}
+	}//state 1 estimates the probability that a ship will be at a certain Point and chooses most likely point
+	int density[MAXROWS][MAXCOLS];
+	densityMap(g, params, density, prior);
+	int maxProb = 0; //find the maximum probability among all Points
+	for (int r = 0; r < g.rows(); r++)
+		for (int c = 0; c < g.cols(); c++)
+			maxProb = max(maxProb, density[r][c]);
+	Point targets[NCELLS];
+	int n = 0;
+	for (int r = 0; r < g.rows(); r++)
+		for (int c = 0; c < g.cols(); c++)
+			if (density[r][c] == maxProb)
+				targets[n++] = Point(r, c);
+	return targets[randInt(n)]; //choose random Point among all maximum probability points
+}
+
+void weigh(const Game& g, const LayoutPrior& prior, int density[MAXROWS][MAXCOLS])
+{
+	for (int r = 0; r < g.rows(); r++)
+		for (int c = 0; c < g.cols(); c++)
+			density[r][c] *= prior.weight[r][c];
+}
+
+void GoodState::densityMap(const Game& g, const GoodParams& params, int density[MAXROWS][MAXCOLS],
+	const LayoutPrior* prior) const
+{
+	//a ship fits at (r,c) going down or right if that many open cells start there
+	int down[MAXROWS + 1][MAXCOLS];
+	int right[MAXROWS][MAXCOLS + 1];
+	for (int c = 0; c < g.cols(); c++)
+		down[g.rows()][c] = 0;
+	for (int r = g.rows() - 1; r >= 0; r--)
+	{
+		right[r][g.cols()] = 0;
+		for (int c = g.cols() - 1; c >= 0; c--)
+		{
+			bool open = !closed.test(Point(r, c));
+			down[r][c] = open ? down[r + 1][c] + 1 : 0;
+			right[r][c] = open ? right[r][c + 1] + 1 : 0;
+			//a product starts from the prior's weight, so weighting it costs nothing
+			density[r][c] = (params.multiply ? (prior != nullptr ? prior->weight[r][c] : 1) : 0);
+		}
+	}
+	if (params.multiply && endgameDensity(g, down, right, density))
+	{
+		if (prior != nullptr) //the table's densities replaced the starting weights
+			weigh(g, *prior, density);
+		return;
+	}
+	for (int i = 0; i < g.nShips(); i++)
+	{
+		if (i < MAXSHIPS && !(afloat >> i & 1)) //only looks at ships that aren't destroyed
+			continue;
+		//a ship of length 1 counts once down and once right, like any other.  The
+		//original GoodPlayer counted on a scratch Board whose unplaceShip checked
+		//the cell right of a horizontal ship rather than the ship's own cells, so
+		//its first horizontal length-1 ship was never removed and blocked every
+		//later count; that slip is not copied here
+		int len = g.shipLength(i);
+		int count[MAXROWS][MAXCOLS] = {};
+		for (int r = 0; r < g.rows(); r++)
+		{
+			for (int c = 0; c < g.cols(); c++)
+			{
+				if (down[r][c] >= len)
+					for (int j = 0; j < len; j++)
+						count[r + j][c]++;
+				if (right[r][c] >= len)
+					for (int j = 0; j < len; j++)
+						count[r][c + j]++;
+			}
+		}
+		for (int r = 0; r < g.rows(); r++)
+			for (int c = 0; c < g.cols(); c++)
+				density[r][c] = (params.multiply ? density[r][c] * count[r][c] : density[r][c] + count[r][c]);
+	}
+	if (prior != nullptr && !params.multiply)
+		weigh(g, *prior, density);
+}
+
+bool GoodState::endgameDensity(const Game& g, const int down[][MAXCOLS], const int right[][MAXCOLS + 1],
+	int density[MAXROWS][MAXCOLS]) const
+{
+	//the tables know one or two ships afloat
+	const EndgameTable& table = EndgameTable::instance();
+	if (!table.isOpen())
+		return false;
+	int lengths[2];
+	int nAfloat = 0;
+	for (int i = 0; i < g.nShips() && nAfloat <= 2; i++)
+	{
+		if (i < MAXSHIPS && !(afloat >> i & 1))
+			continue;
+		if (nAfloat < 2)
+			lengths[nAfloat] = g.shipLength(i);
+		nAfloat++;
+	}
+	int fleet = EndgameTable::fleetIndex(nAfloat, lengths);
+	if (fleet < 0)
+		return false;
+
+	//runs of open cells ending at each cell from the north and west, to go with down and right
+	const int M = EndgameTable::MAXRUN;
+	int up[MAXROWS + 1][MAXCOLS];
+	int left[MAXROWS][MAXCOLS + 1];
+	for (int c = 0; c < g.cols(); c++)
+		up[0][c] = 0;
+	for (int r = 0; r < g.rows(); r++)
+	{
+		left[r][0] = 0;
+		for (int c = 0; c < g.cols(); c++)
+		{
+			bool open = down[r][c] > 0;
+			up[r + 1][c] = open ? up[r][c] + 1 : 0;
+			left[r][c + 1] = open ? left[r][c] + 1 : 0;
+			density[r][c] = open ? table.density(fleet, EndgameTable::key(min(up[r][c], M), min(right[r][c + 1], M),
+				min(down[r + 1][c], M), min(left[r][c], M))) : 0;
+		}
+	}
+	return true;
+}
+
+void GoodState::recommendAttacks(const Game& g, const GoodParams& params, int n, vector<Point>& shots,
+	const LayoutPrior* prior)
+{
+	//while chasing a ship the first shot goes where recommendAttack would aim;
+	//the rest are the n most likely cells of one density map, ties broken at random
+	shots.clear();
+	if (n <= 0)
+		return;
+	if (state == 2)
+		shots.push_back(recommendAttack(g, params, prior));
+	int density[MAXROWS][MAXCOLS];
+	densityMap(g, params, density, prior);
+	struct Candidate
+	{
+		int prob;
+		int tie;
+		Point p;
+	};
+	Candidate candidates[NCELLS];
+	int nCandidates = 0;
+	for (int r = 0; r < g.rows(); r++)
+	{
+		for (int c = 0; c < g.cols(); c++)
+		{
+			if (density[r][c] == 0 || (!shots.empty() && shots[0].r == r && shots[0].c == c))
+				continue;
+			Candidate cand = { density[r][c], randInt(1 << 30), Point(r, c) };
+			candidates[nCandidates++] = cand;
+		}
+	}
+	int wanted = min(n - (int)shots.size(), nCandidates);
+	partial_sort(candidates, candidates + wanted, candidates + nCandidates,
+		[](const Candidate& x, const Candidate& y) { return x.prob > y.prob || (x.prob == y.prob && x.tie < y.tie); });
+	for (int i = 0; i < wanted; i++)
+		shots.push_back(candidates[i].p);
+}
+
+void GoodState::recordAttackResult(const Game& g, Point p, bool validShot, bool shotHit,
+	bool shipDestroyed, int shipId)
+{
+	if (g.isValid(p))
+		closed.set(p);
+	if (!validShot)
+		return;
+	if (shotHit)
+	{
+		if (shipDestroyed)
+		{
+			if (shipId >= 0 && shipId < MAXSHIPS)
+				afloat &= ~(1ULL << shipId);
+			dir = -1;
+			if (head == tail)
+				state = 1;
+			else
+				head++; //look at next transition point
+		}
+		else
+		{
+			pending[tail++] = CellSet::index(p);
+			if (state == 2 && dir == -1) //determine direction
+			{
+				Point origin = CellSet::point(pending[head]);
+				if (p.r == origin.r - 1)
+					dir = 0;
+				else if (p.c == origin.c + 1)
+					dir = 1;
+				else if (p.r == origin.r + 1)
+					dir = 2;
+				else if (p.c == origin.c - 1)
+					dir = 3;
+			}
+			state = 2;
+		}
+	}
+	else if (state == 2)
+		dir = -1;  //previously chosen direction is incorrect, determine direction again
+}
@@ -0,0 +1,103 @@
+#ifndef PLAYERSTATE_INCLUDED
+#define PLAYERSTATE_INCLUDED
+
+#include "globals.h"
+#include "CellSet.h"
+#include <string>
+#include <vector>
+
+class Game;
+struct LayoutPrior;
+
+// Everything the built-in strategies remember during a game, each in one
+// small block with no pointers or heap storage, so that a server can keep
+// millions of games in a flat array.  What every game of a kind shares (the
+// Game with its rules, lookup tables) is passed in rather than stored.
+// start must be called before the first move of each game.  The Player
+// classes for these strategies are thin wrappers around them.
+
+struct AwfulState
+{
+	void start();
+	Point recommendAttack(const Game& g);
+
+	unsigned char r;  //last cell attacked
+	unsigned char c;
+};
+
+struct MediocreState
+{
+	void start();
+	Point recommendAttack(const Game& g);
+	void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed);
+
+	CellSet attacked;          //valid shots so far
+	unsigned char state;       //1 hunts at random, 2 finishes off a ship
+	unsigned char transition;  //CellSet index of the hit that started state 2
+};
+
+// Fires at random cells not yet tried and ignores what it hits.  With
+// parity it tries the cells with r+c even first, as every ship of two or
+// more cells covers one of them.
+struct HunterState
+{
+	void start(const Game& g, bool parity);
+	Point recommendAttack(const Game& g);
+	void recordAttackResult(const Game& g, Point p);
+
+	CellSet open;     //cells not yet attacked
+	CellSet first;    //cells to try before the rest
+};
+
+// The rules of thumb GoodPlayer plays by, so that a tuner can try others.
+// The defaults are the hand-picked ones.
+struct GoodParams
+{
+	GoodParams();
+	// Sets the parameters named in a spec such as "probe=NESW,line=1,
+	// combine=product,place=backtrack"; false if it is malformed
+	bool parse(const std::string& spec);
+	std::string str() const;  //a spec naming every parameter
+
+	unsigned char probe[4];   //order target mode tries a hit's neighbours in, 0=N, 1=E, 2=S, 3=W
+	bool followLine;          //after two hits in a row, keep firing along them
+	bool multiply;            //combine the ships' placement counts by product rather than sum
+	bool randomPlacement;     //place ships at random rather than by backtracking on a half-blocked board
+	bool usePrior;            //weight the hunt by where this opponent's ships were in earlier games
+};
+
+struct GoodState
+{
+	static const int MAXSHIPS = 64;  //ships after these are never counted as destroyed
+
+	void start(const Game& g);
+	// prior, if not null, weights each cell of the hunt (see LayoutStore)
+	Point recommendAttack(const Game& g, const GoodParams& params, const LayoutPrior* prior = nullptr);
+	void recommendAttacks(const Game& g, const GoodParams& params, int n, std::vector<Point>& shots,
+		const LayoutPrior* prior = nullptr);
+	void recordAttackResult(const Game& g, Point p, bool validShot, bool shotHit,
+		bool shipDestroyed, int shipId);
+	// Product (or sum) over the ships afloat of the placements covering each cell
+	void densityMap(const Game& g, const GoodParams& params, int density[MAXROWS][MAXCOLS],
+		const LayoutPrior* prior = nullptr) const;
+
+	CellSet closed;                //cells attacked so far, and every cell off the board
+	unsigned long long afloat;     //bit i is set until ship i is destroyed
+	unsigned char state;           //1 hunts by density, 2 targets the hits
+	signed char dir;               //direction of target attack 0=N, 1=E, 2=S, 3=W, -1=none
+	unsigned char head;            //pending[head..tail) are the hits still to follow up,
+	unsigned char tail;            //oldest first; a cell is hit once, so it never wraps
+	unsigned char pending[MAXROWS * MAXCOLS];
+
+private:
+	int untriedAlong(int d, int origin) const;
+	// densityMap from the EndgameTable, given the runs of open cells down
+	// and right from each cell; false if the table doesn't have this fleet
+	bool endgameDensity(const Game& g, const int down[][MAXCOLS], const int right[][MAXCOLS + 1],
+		int density[MAXROWS][MAXCOLS]) const;
+};
+
+static_assert(sizeof(AwfulState) <= 64 && sizeof(MediocreState) <= 64 && sizeof(HunterState) <= 64 &&
+	sizeof(GoodState) <= 128, "player state has outgrown its cache lines");
+
+#endif // PLAYERSTATE_INCLUDED
@@ -0,0 +1,171 @@
+#include "Renderer.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//******************** Screen functions *******************************
+
+Screen::Screen(int rows, int cols)
+	: m_rows(0), m_cols(0), m_fresh(true)
+{
+	resize(rows, cols);
+}
+
+void Screen::resize(int rows, int cols)
+{
+	m_rows = rows;
+	m_cols = cols;
+	m_next.assign(rows * cols, ' ');
+	m_shown.assign(rows * cols, ' ');
+	m_fresh = true;
+}
+
+void Screen::clear()
+{
+	m_next.assign(m_rows * m_cols, ' ');
+}
+
+void Screen::put(int r, int c, const string& text)
+{
+	int col = c;
+	for (int i = 0; i < text.size(); i++)
+	{
+		if (text[i] == '\n')
+		{
+			r++;
+			col = c;
+			continue;
+		}
+		if (r >= 0 && r < m_rows && col >= 0 && col < m_cols)
+			m_next[r * m_cols + col] = text[i];
+		col++;
+	}
+}
+
+void Screen::invalidate()
+{
+	m_fresh = true;
+}
+
+void Screen::present(ostream& out)
+{
+	char move[32];
+	m_out.clear();
+	if (m_fresh)
+	{
+		m_out += "\x1b[2J";  //clear the terminal
+		m_shown.assign(m_rows * m_cols, ' ');
+		m_fresh = false;
+	}
+	for (int r = 0; r < m_rows; r++)
+	{
+		int c = 0;
+		while (c < m_cols)
+		{
+			int i = r * m_cols + c;
+			if (m_next[i] == m_shown[i])
+			{
+				c++;
+				continue;
+			}
+			//a run of changes; short unchanged gaps are cheaper to rewrite than to jump over
+			int end = c + 1;
+			for (int gap = 0; end < m_cols && gap < 4; end++)
+			{
+				if (m_next[r * m_cols + end] != m_shown[r * m_cols + end])
+					gap = 0;
+				else
+					gap++;
+			}
+			while (m_next[r * m_cols + end - 1] == m_shown[r * m_cols + end - 1])
+				end--;
+			snprintf(move, sizeof(move), "\x1b[%d;%dH", r + 1, c + 1);
+			m_out += move;
+			m_out.append(m_next, i, end - c);
+			c = end;
+		}
+	}
+	snprintf(move, sizeof(move), "\x1b[%d;1H", m_rows + 1); //leave the cursor below the frame
+	m_out += move;
+	m_shown = m_next;
+	out.write(m_out.data(), m_out.size());
+	out.flush();
+}
+
+//******************** TiledView functions ****************************
+
+// A tile shows the turn, the names of the players and both boards side by side.
+// Boards are at most MAXCOLS+2 characters wide and MAXROWS+1 lines high.
+
+const int TILEWIDTH = 2 * (MAXCOLS + 2) + 4;
+const int TILEHEIGHT = MAXROWS + 3;
+const chrono::milliseconds TILEINTERVAL(30); //redraw a tile at most this often
+
+TiledView::Tile::Tile()
+	: m_lastDrawn(chrono::steady_clock::now() - TILEINTERVAL)
+{}
+
+void TiledView::Tile::turnPlayed(const Player& p1, const Board& b1, const Player& p2, const Board& b2,
+	int turn, bool gameOver)
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if (!gameOver && now - m_lastDrawn < TILEINTERVAL)
+		return;  //nobody can watch faster than this anyway
+	m_lastDrawn = now;
+
+	//draw into a scratch buffer so the lock is held only for the swap
+	string left;
+	string right;
+	b1.render(false, left);
+	b2.render(false, right);
+	//the header is the turn, or the turn the game ended on, then as much of the names as fits
+	m_scratch = (gameOver ? "over " : "turn ") + to_string(turn) + "  ";
+	size_t nameLen = (TILEWIDTH - 1 - 4 - m_scratch.size()) / 2;
+	m_scratch += p1.name().substr(0, nameLen) + " vs " + p2.name().substr(0, nameLen) + "\n";
+	size_t i = 0;
+	size_t j = 0;
+	while (i < left.size() || j < right.size())
+	{
+		size_t start = m_scratch.size();
+		while (i < left.size() && left[i] != '\n')
+			m_scratch += left[i++];
+		i++;
+		if (m_scratch.size() - start < MAXCOLS + 6)
+			m_scratch.append(MAXCOLS + 6 - (m_scratch.size() - start), ' ');
+		while (j < right.size() && right[j] != '\n')
+			m_scratch += right[j++];
+		j++;
+		m_scratch += '\n';
+	}
+	lock_guard<mutex> lock(m_mutex);
+	m_text.swap(m_scratch);
+}
+
+string TiledView::Tile::snapshot()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_text;
+}
+
+TiledView::TiledView(int nTiles, int screenCols)
+	: m_tiles(nTiles), m_perRow(screenCols / TILEWIDTH > 0 ? screenCols / TILEWIDTH : 1),
+	m_screen(((nTiles + m_perRow - 1) / m_perRow) * TILEHEIGHT, m_perRow * TILEWIDTH)
+{}
+
+GameObserver* TiledView::tile(int i)
+{
+	return &m_tiles[i];
+}
+
+void TiledView::present(ostream& out)
+{
+	m_screen.clear();
+	for (int i = 0; i < m_tiles.size(); i++)
+		m_screen.put((i / m_perRow) * TILEHEIGHT, (i % m_perRow) * TILEWIDTH, m_tiles[i].snapshot());
+	m_screen.present(out);
+}
@@ -0,0 +1,65 @@
+#ifndef RENDERER_INCLUDED
+#define RENDERER_INCLUDED
+
+#include "Game.h"
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// A character screen that remembers what the terminal is showing.  Each
+// frame is drawn into memory with put(), and present() sends only the
+// cells that changed, with ANSI cursor moves, in a single write.
+class Screen
+{
+public:
+	Screen(int rows, int cols);
+	void resize(int rows, int cols);
+	void clear();       //blanks the frame being drawn
+	void put(int r, int c, const std::string& text); //lines after a '\n' start again at column c
+	void present(std::ostream& out);
+	void invalidate();  //the next present() redraws everything
+
+private:
+	int m_rows;
+	int m_cols;
+	std::string m_next;   //frame being drawn, m_rows * m_cols characters
+	std::string m_shown;  //what the terminal shows
+	bool m_fresh;
+	std::string m_out;    //escape sequences for one present()
+};
+
+// Shows many games at once, one tile per game.  Each tile is a
+// GameObserver that the thread playing the game updates; present() is
+// called from one other thread to put all tiles on the screen.
+class TiledView
+{
+public:
+	TiledView(int nTiles, int screenCols); //tiles are laid out in rows as wide as the screen
+	GameObserver* tile(int i);
+	void present(std::ostream& out);
+	// We prevent a TiledView object from being copied or assigned
+	TiledView(const TiledView&) = delete;
+	TiledView& operator=(const TiledView&) = delete;
+
+private:
+	class Tile : public GameObserver
+	{
+	public:
+		Tile();
+		virtual void turnPlayed(const Player& p1, const Board& b1, const Player& p2, const Board& b2,
+			int turn, bool gameOver);
+		std::string snapshot();
+	private:
+		std::mutex m_mutex;
+		std::string m_text;
+		std::string m_scratch;
+		std::chrono::steady_clock::time_point m_lastDrawn;
+	};
+	std::vector<Tile> m_tiles;
+	int m_perRow;
+	Screen m_screen;
+};
+
+#endif // RENDERER_INCLUDED
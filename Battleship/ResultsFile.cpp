@@ -0,0 +1,266 @@
+#include "ResultsFile.h"
+#include "Platform.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+const int MAXNAME = 32;
+const char MAGIC[8] = { 'B', 'S', 'R', 'E', 'S', 'U', 'L', '1' };
+
+struct ResultsHeader
+{
+	char magic[8];
+	char name[2][MAXNAME];
+	int nShips;
+	char symbol[ResultsBlock::MAXSHIPS];
+};
+
+//******************** ResultsBlock functions *************************
+
+void ResultsBlock::record(int k, unsigned int matchSeed, int first, const GameRecord& rec)
+{
+	int i = rows++;
+	game[i] = k;
+	seed[i] = matchSeed;
+	this->first[i] = first;
+	winner[i] = (rec.winner < 0 ? -1 : rec.winner ^ first);
+	turns[i] = rec.turns;
+	for (int seat = 0; seat < 2; seat++)
+	{
+		int e = seat ^ first;
+		shots[e][i] = rec.shots[seat];
+		for (int j = 0; j < MAXSHIPS; j++)
+			sunkAfter[e][j][i] = rec.sunkAfter[seat][j];
+		moveSeconds[e][i] = (float)rec.moveLatency[seat].total();
+	}
+}
+
+template<typename T>
+void appendColumn(string& bytes, const T* column, int n)
+{
+	bytes.append(reinterpret_cast<const char*>(column), n * sizeof(T));
+}
+
+// Appends the file form of a block's rows to bytes
+void encodeBlock(const ResultsBlock& block, int nShips, string& bytes)
+{
+	int n = block.rows;
+	bytes.append(reinterpret_cast<const char*>(&n), sizeof(n));
+	appendColumn(bytes, block.game, n);
+	appendColumn(bytes, block.seed, n);
+	appendColumn(bytes, block.first, n);
+	appendColumn(bytes, block.winner, n);
+	appendColumn(bytes, block.turns, n);
+	for (int e = 0; e < 2; e++)
+		appendColumn(bytes, block.shots[e], n);
+	for (int e = 0; e < 2; e++)
+		for (int j = 0; j < nShips; j++)
+			appendColumn(bytes, block.sunkAfter[e][j], n);
+	for (int e = 0; e < 2; e++)
+		appendColumn(bytes, block.moveSeconds[e], n);
+}
+
+template<typename T>
+bool readColumn(FILE* f, T* column, int n)
+{
+	return fread(column, sizeof(T), n, f) == (size_t)n;
+}
+
+// Reads the next block of the file into block.  Returns false at the end
+// of the file, and also, clearing ok, if the block is cut short.
+bool readBlock(FILE* f, int nShips, ResultsBlock& block, bool& ok)
+{
+	int n;
+	block.rows = 0;
+	if (fread(&n, sizeof(n), 1, f) != 1)
+		return false;
+	ok = n > 0 && n <= ResultsBlock::ROWS &&
+		readColumn(f, block.game, n) && readColumn(f, block.seed, n) &&
+		readColumn(f, block.first, n) && readColumn(f, block.winner, n) &&
+		readColumn(f, block.turns, n) && readColumn(f, block.shots[0], n) && readColumn(f, block.shots[1], n);
+	for (int e = 0; e < 2 && ok; e++)
+		for (int j = 0; j < nShips && ok; j++)
+			ok = readColumn(f, block.sunkAfter[e][j], n);
+	ok = ok && readColumn(f, block.moveSeconds[0], n) && readColumn(f, block.moveSeconds[1], n);
+	if (ok)
+		block.rows = n;
+	return ok;
+}
+
+// Moves row from to row to of block
+void moveRow(ResultsBlock& block, int from, int to)
+{
+	block.game[to] = block.game[from];
+	block.seed[to] = block.seed[from];
+	block.first[to] = block.first[from];
+	block.winner[to] = block.winner[from];
+	block.turns[to] = block.turns[from];
+	for (int e = 0; e < 2; e++)
+	{
+		block.shots[e][to] = block.shots[e][from];
+		for (int j = 0; j < ResultsBlock::MAXSHIPS; j++)
+			block.sunkAfter[e][j][to] = block.sunkAfter[e][j][from];
+		block.moveSeconds[e][to] = block.moveSeconds[e][from];
+	}
+}
+
+//******************** ResultsWriter functions ************************
+
+ResultsWriter::ResultsWriter()
+	: m_file(nullptr), m_nShips(0)
+{}
+
+ResultsWriter::~ResultsWriter()
+{
+	close();
+}
+
+bool ResultsWriter::create(const string& path, const string names[2], const Ruleset& rules,
+	const vector<char>* played, int firstGame)
+{
+	close();
+	if (rules.ships.size() > ResultsBlock::MAXSHIPS)
+		return false;
+	ResultsHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	for (int i = 0; i < 2; i++)
+		strncpy(header.name[i], names[i].c_str(), MAXNAME - 1);
+	header.nShips = rules.ships.size();
+	for (int j = 0; j < header.nShips; j++)
+		header.symbol[j] = rules.ships[j].symbol;
+
+	if (played != nullptr)
+	{
+		FILE* old = fopen(path.c_str(), "rb");
+		if (old != nullptr)
+		{
+			ResultsHeader existing;
+			size_t got = fread(&existing, 1, sizeof(existing), old);  //an empty file is started afresh
+			if (got > 0 && (got < sizeof(existing) || memcmp(&existing, &header, sizeof(header)) != 0))
+			{
+				fclose(old);
+				return false;
+			}
+			//rows of games the match will play again were written after its
+			//last checkpoint; keep the rest, and replace the file in one step
+			string kept(reinterpret_cast<const char*>(&header), sizeof(header));
+			ResultsBlock* block = new ResultsBlock;
+			bool complete = true;  //a block cut short by a crash is dropped with its games
+			while (readBlock(old, header.nShips, *block, complete))
+			{
+				int n = 0;
+				for (int i = 0; i < block->rows; i++)
+				{
+					int k = block->game[i] - firstGame;
+					if (k >= 0 && k < played->size() && (*played)[k])
+						moveRow(*block, i, n++);
+				}
+				block->rows = n;
+				if (n > 0)
+					encodeBlock(*block, header.nShips, kept);
+			}
+			delete block;
+			fclose(old);
+			if (!writeFileAtomically(path, kept))
+				return false;
+			m_file = fopen(path.c_str(), "ab");
+			m_nShips = header.nShips;
+			return m_file != nullptr;
+		}
+	}
+	m_file = fopen(path.c_str(), "wb");
+	if (m_file == nullptr)
+		return false;
+	if (fwrite(&header, sizeof(header), 1, m_file) != 1)
+	{
+		close();
+		return false;
+	}
+	m_nShips = header.nShips;
+	return true;
+}
+
+void ResultsWriter::write(ResultsBlock& block)
+{
+	if (block.rows == 0)
+		return;
+	lock_guard<mutex> lock(m_mutex);
+	if (m_file != nullptr)
+	{
+		m_bytes.clear();
+		encodeBlock(block, m_nShips, m_bytes);
+		fwrite(m_bytes.data(), 1, m_bytes.size(), m_file);
+	}
+	block.rows = 0;
+}
+
+void ResultsWriter::flush()
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (m_file != nullptr)
+		fflush(m_file);
+}
+
+void ResultsWriter::close()
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (m_file != nullptr)
+		fclose(m_file);
+	m_file = nullptr;
+}
+
+//******************** CSV export *************************************
+
+bool exportResultsCsv(const string& path, ostream& out)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+	if (f == nullptr)
+		return false;
+	ResultsHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header.nShips < 0 || header.nShips > ResultsBlock::MAXSHIPS)
+	{
+		fclose(f);
+		return false;
+	}
+	string name[2];
+	for (int e = 0; e < 2; e++)
+		name[e] = string(header.name[e], strnlen(header.name[e], MAXNAME));
+
+	//entrants are numbered, as a match may be between two of the same type
+	out << "game,seed,entrant0,entrant1,first,winner,turns";
+	for (int e = 0; e < 2; e++)
+		out << ",shots" << e;
+	for (int e = 0; e < 2; e++)
+		for (int j = 0; j < header.nShips; j++)
+			out << ",sunk" << e << "_" << header.symbol[j];
+	for (int e = 0; e < 2; e++)
+		out << ",move_seconds" << e;
+	out << '\n';
+
+	//the rows are read a block at a time, so the export needs no more
+	//memory for a long match than for a short one
+	ResultsBlock* block = new ResultsBlock;
+	bool ok = true;
+	while (readBlock(f, header.nShips, *block, ok))
+	{
+		for (int i = 0; i < block->rows; i++)
+		{
+			out << block->game[i] << ',' << block->seed[i] << ',' << name[0] << ',' << name[1] << ','
+				<< (int)block->first[i] << ',' << (int)block->winner[i] << ',' << block->turns[i];
+			for (int e = 0; e < 2; e++)
+				out << ',' << block->shots[e][i];
+			for (int e = 0; e < 2; e++)
+				for (int j = 0; j < header.nShips; j++)
+					out << ',' << block->sunkAfter[e][j][i];
+			for (int e = 0; e < 2; e++)
+				out << ',' << block->moveSeconds[e][i];
+			out << '\n';
+		}
+	}
+	delete block;
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,71 @@
+#ifndef RESULTSFILE_INCLUDED
+#define RESULTSFILE_INCLUDED
+
+#include "Game.h"
+#include "Ruleset.h"
+#include <cstdio>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Up to ROWS games' results held column by column until they are written
+// out together.  Each worker thread fills its own block, so recording a
+// game is a few stores with no locking.  Entrant 0 is type[0] of the match.
+struct ResultsBlock
+{
+	static const int ROWS = 4096;
+	static const int MAXSHIPS = GameRecord::MAXTIMEDSHIPS;
+
+	ResultsBlock() : rows(0) {}
+	bool full() const { return rows == ROWS; }
+	// first is the entrant in seat 0, as in MatchStats::record
+	void record(int k, unsigned int matchSeed, int first, const GameRecord& rec);
+
+	int rows;
+	int game[ROWS];                   //game k was seeded with matchSeed + k
+	unsigned int seed[ROWS];          //matchSeed
+	signed char first[ROWS];
+	signed char winner[ROWS];         //entrant, -1 if the game could not be played
+	unsigned short turns[ROWS];
+	unsigned short shots[2][ROWS];    //per entrant
+	unsigned short sunkAfter[2][MAXSHIPS][ROWS]; //shots entrant i had fired when it sank ship j, 0 if it didn't
+	float moveSeconds[2][ROWS];       //time entrant i spent deciding its shots
+};
+
+// A file of per-game results, written a block at a time from any thread.
+// The file starts with a header naming the entrants and ships, followed
+// by blocks: a row count, then each column of the block in the order of
+// ResultsBlock's members, only the sunkAfter columns of real ships, in
+// the machine's byte order.  Rows are in the order blocks fill up, not by
+// game number.
+class ResultsWriter
+{
+public:
+	ResultsWriter();
+	~ResultsWriter();
+	// With played, a resumed match adds to the file of the run it continues,
+	// if that was for the same entrants and fleet.  Only the rows of games
+	// already played (game k if played[k - firstGame] is set) are kept; the
+	// rest are dropped, as the match plays those games again.
+	bool create(const std::string& path, const std::string names[2], const Ruleset& rules,
+		const std::vector<char>* played = nullptr, int firstGame = 0);
+	void write(ResultsBlock& block); //writes out the rows and empties the block
+	void flush();  //hands everything written so far to the operating system
+	void close();
+	// We prevent a ResultsWriter object from being copied or assigned
+	ResultsWriter(const ResultsWriter&) = delete;
+	ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+private:
+	std::FILE* m_file;
+	int m_nShips;
+	std::string m_bytes;  //the block being written, kept to save allocating
+	std::mutex m_mutex;
+};
+
+// Writes the results file at path to out as CSV with a header line, one
+// block at a time.  Returns false if path isn't a results file.
+bool exportResultsCsv(const std::string& path, std::ostream& out);
+
+#endif // RESULTSFILE_INCLUDED
@@ -0,0 +1,71 @@
+#include "Ruleset.h"
+#include "Game.h"
+#include "globals.h"
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+Ruleset Ruleset::standard()
+{
+	Ruleset r;
+	r.rows = 10;
+	r.cols = 10;
+	ShipSpec fleet[] = {
+		{ 5, 'A', "aircraft carrier" },
+		{ 4, 'B', "battleship" },
+		{ 3, 'D', "destroyer" },
+		{ 3, 'S', "submarine" },
+		{ 2, 'P', "patrol boat" }
+	};
+	r.ships.assign(fleet, fleet + sizeof(fleet) / sizeof(fleet[0]));
+	return r;
+}
+
+bool Ruleset::addShipsTo(Game& g) const
+{
+	for (int i = 0; i < ships.size(); i++)
+		if (!g.addShip(ships[i].length, ships[i].symbol, ships[i].name))
+			return false;
+	return true;
+}
+
+bool Ruleset::parse(const string& spec, string& error)
+{
+	istringstream in(spec);
+	string word;
+	if (in >> word && word == "standard" && !(in >> word))
+	{
+		*this = standard();
+		return true;
+	}
+	in.clear();
+	in.str(spec);
+	if (!(in >> rows >> cols) || rows < 1 || rows > MAXROWS || cols < 1 || cols > MAXCOLS)
+	{
+		error = "the board must be from 1x1 to " + to_string(MAXROWS) + "x" + to_string(MAXCOLS);
+		return false;
+	}
+	ships.clear();
+	while (in >> word)
+	{
+		ShipSpec ship = { atoi(word.c_str() + 1), word[0], string(1, word[0]) };
+		if (word.size() < 2 || ship.length < 1)
+		{
+			error = "bad ship \"" + word + "\"";
+			return false;
+		}
+		ships.push_back(ship);
+	}
+	return true;
+}
+
+string Ruleset::str() const
+{
+	string s = to_string(rows) + "x" + to_string(cols);
+	for (int i = 0; i < ships.size(); i++)
+		s += " " + string(1, ships[i].symbol) + to_string(ships[i].length);
+	return s;
+}
@@ -0,0 +1,33 @@
+#ifndef RULESET_INCLUDED
+#define RULESET_INCLUDED
+
+#include <string>
+#include <vector>
+
+class Game;
+
+struct ShipSpec
+{
+	int length;
+	char symbol;
+	std::string name;
+};
+
+// The board size and fleet of a game, so that runners can set up as many
+// identical Games as they need
+struct Ruleset
+{
+	int rows;
+	int cols;
+	std::vector<ShipSpec> ships;
+
+	static Ruleset standard(); //10 x 10 with the five classic ships
+	bool addShipsTo(Game& g) const;
+	// Reads "standard", or the rows and columns followed by each ship as its
+	// symbol and length, e.g. "8 8 A5 B4 P2".  Returns false with a reason
+	// in error if spec is malformed.
+	bool parse(const std::string& spec, std::string& error);
+	std::string str() const; //the same form, with the size written as 8x8
+};
+
+#endif // RULESET_INCLUDED
@@ -0,0 +1,193 @@
+#include "ShotStore.h"
+#include "Game.h"
+#include "Platform.h"
+#include "Player.h"
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const int NSLOTS = 64;  //opponent/board-size combinations the store can tell apart
+const int NCELLS = MAXROWS * MAXCOLS;
+const char MAGIC[8] = { 'B', 'S', 'S', 'H', 'O', 'T', 'S', '1' };
+
+struct ShotSlot
+{
+	atomic<unsigned long long> key;  //0 while the slot is unclaimed
+	atomic<unsigned int> games;
+	atomic<unsigned int> shots[NCELLS];     //games in which the cell was shot
+	atomic<unsigned int> orderSum[NCELLS];  //sum of the shot numbers that reached the cell
+};
+
+struct ShotStoreHeader
+{
+	char magic[8];
+	unsigned int nSlots;
+	unsigned int nCells;
+};
+
+const size_t STORE_BYTES = sizeof(ShotStoreHeader) + NSLOTS * sizeof(ShotSlot);
+
+static bool validStore(const MappedFile& file)
+{
+	const ShotStoreHeader* header = static_cast<const ShotStoreHeader*>(file.data());
+	return memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->nSlots == NSLOTS &&
+		header->nCells == NCELLS && file.size() >= STORE_BYTES;
+}
+
+ShotStore& ShotStore::instance()
+{
+	static ShotStore store;
+	return store;
+}
+
+ShotStore::ShotStore()
+	: m_file(nullptr), m_slots(nullptr), m_frozenDepth(0)
+{}
+
+ShotStore::~ShotStore()
+{
+	delete m_file;
+}
+
+bool ShotStore::open(const string& path)
+{
+	MappedFile* file = new MappedFile;
+	if (!file->open(path, STORE_BYTES))
+	{
+		delete file;
+		return false;
+	}
+	ShotStoreHeader* header = static_cast<ShotStoreHeader*>(file->data());
+	if (header->nSlots == 0) //a new file
+	{
+		memcpy(header->magic, MAGIC, sizeof(MAGIC));
+		header->nSlots = NSLOTS;
+		header->nCells = NCELLS;
+	}
+	if (!validStore(*file))
+	{
+		delete file;
+		return false;
+	}
+	delete m_file;
+	m_file = file;
+	m_path = path;
+	m_slots = reinterpret_cast<ShotSlot*>(header + 1);
+	return true;
+}
+
+unsigned long long opponentKey(const Player& opponent)
+{
+	const string& type = opponent.type().empty() ? opponent.name() : opponent.type();
+	const Game& g = opponent.game();
+	unsigned long long key = 14695981039346656037ULL;  //FNV-1a over the type and rules
+	for (int i = 0; i < type.size(); i++)
+		key = (key ^ (unsigned char)type[i]) * 1099511628211ULL;
+	key = (key ^ g.rows()) * 1099511628211ULL;
+	key = (key ^ g.cols()) * 1099511628211ULL;
+	for (int i = 0; i < g.nShips(); i++)
+		key = (key ^ g.shipLength(i)) * 1099511628211ULL;
+	return key == 0 ? 1 : key;
+}
+
+ShotSlot* ShotStore::findSlot(ShotSlot* slots, unsigned long long key, bool create)
+{
+	for (int i = 0; i < NSLOTS; i++) //linear probing; a slot once claimed is never released
+	{
+		ShotSlot* slot = &slots[(key + i) % NSLOTS];
+		unsigned long long current = slot->key.load(memory_order_acquire);
+		if (current == key)
+			return slot;
+		if (current == 0)
+		{
+			if (!create)
+				return nullptr;
+			if (slot->key.compare_exchange_strong(current, key, memory_order_acq_rel) || current == key)
+				return slot;
+		}
+	}
+	return nullptr;  //store is full
+}
+
+void ShotStore::recordGame(unsigned long long opponent, const unsigned char order[])
+{
+	if (m_slots == nullptr)
+		return;
+	ShotSlot* slot = findSlot(m_slots, opponent, true);
+	if (slot == nullptr)
+		return;
+	for (int i = 0; i < NCELLS; i++)
+	{
+		if (order[i] != 0)
+		{
+			slot->shots[i].fetch_add(1, memory_order_relaxed);
+			slot->orderSum[i].fetch_add(order[i], memory_order_relaxed);
+		}
+	}
+	slot->games.fetch_add(1, memory_order_relaxed);
+}
+
+bool ShotStore::lateness(unsigned long long opponent, int rows, int cols, int minGames,
+	double late[MAXROWS][MAXCOLS]) const
+{
+	if (m_slots == nullptr)
+		return false;
+	ShotSlot* slots = m_slots;
+	if (m_frozenDepth > 0 && !m_frozen.empty())
+		slots = reinterpret_cast<ShotSlot*>(m_frozen.data());
+	ShotSlot* slot = findSlot(slots, opponent, false);
+	if (slot == nullptr)
+		return false;
+	unsigned int games = slot->games.load(memory_order_relaxed);
+	if (games == 0 || games < minGames)
+		return false;
+	for (int r = 0; r < rows; r++)
+	{
+		for (int c = 0; c < cols; c++)
+		{
+			unsigned int shots = slot->shots[r * MAXCOLS + c].load(memory_order_relaxed);
+			unsigned int sum = slot->orderSum[r * MAXCOLS + c].load(memory_order_relaxed);
+			if (shots > games) //counters are read without a lock, so clamp
+				shots = games;
+			late[r][c] = (sum + double(games - shots) * (rows * cols + 1)) / games;
+		}
+	}
+	return true;
+}
+
+void ShotStore::freeze()
+{
+	if (m_frozenDepth++ > 0 || m_slots == nullptr)
+		return;
+	m_frozen.resize((NSLOTS * sizeof(ShotSlot) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long));
+	memcpy(&m_frozen[0], m_slots, NSLOTS * sizeof(ShotSlot));  //no game is playing, so nothing changes under us
+}
+
+void ShotStore::thaw()
+{
+	if (m_frozenDepth > 0)
+		m_frozenDepth--;
+}
+
+bool ShotStore::saveSnapshot(const string& path) const
+{
+	if (m_slots == nullptr)
+		return false;
+	const char* data = static_cast<const char*>(m_file->data());
+	return writeFileAtomically(path, string(data, data + STORE_BYTES));
+}
+
+bool ShotStore::freezeFrom(const string& path)
+{
+	MappedFile snapshot;
+	if (m_slots == nullptr || !snapshot.openReadOnly(path) || snapshot.size() < sizeof(ShotStoreHeader) ||
+		!validStore(snapshot))
+		return false;
+	m_frozenDepth++;
+	m_frozen.resize((NSLOTS * sizeof(ShotSlot) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long));
+	memcpy(&m_frozen[0], static_cast<const ShotStoreHeader*>(snapshot.data()) + 1, NSLOTS * sizeof(ShotSlot));
+	return true;
+}
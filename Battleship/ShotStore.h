@@ -0,0 +1,65 @@
+#ifndef SHOTSTORE_INCLUDED
+#define SHOTSTORE_INCLUDED
+
+#include "globals.h"
+#include <string>
+#include <vector>
+
+class MappedFile;
+class Player;
+struct ShotSlot;
+
+// Hash of a player's createPlayer type (its name, for a player made some
+// other way) and the board size and ship lengths of its game: the key the
+// stores file things about a kind of player under; never 0
+unsigned long long opponentKey(const Player& opponent);
+
+// ShotStore collects, across games, when each kind of opponent shoots each
+// cell.  It is shared by every player in every thread: writers only ever
+// do relaxed atomic adds, so nothing is locked.  The counts live in a
+// memory-mapped file and carry over to later runs; until open() succeeds
+// the store is not in use, and nothing is recorded or learned.
+class ShotStore
+{
+public:
+	static ShotStore& instance();
+	~ShotStore();
+	bool open(const std::string& path);  //call before any games start
+	bool isOpen() const { return m_slots != nullptr; }
+	const std::string& path() const { return m_path; }
+	// order[r*MAXCOLS+c] is the number of the opponent's shot that first hit
+	// cell (r,c), counting from 1, or 0 if the cell was never shot
+	void recordGame(unsigned long long opponent, const unsigned char order[]);
+	// Fills late with the average shot number at which the opponent reaches
+	// each cell (cells never shot count as rows*cols+1).  Returns false if
+	// fewer than minGames games against this opponent have been recorded.
+	bool lateness(unsigned long long opponent, int rows, int cols, int minGames,
+		double late[MAXROWS][MAXCOLS]) const;
+	// Until the matching thaw, lateness answers from the counts as they were
+	// when freeze was called, though games go on adding to the store.  A
+	// Tournament freezes the store while it runs, so what its players learn
+	// doesn't depend on which games happened to finish first.  Calls nest;
+	// make them when no game is playing.
+	void freeze();
+	void thaw();
+	// For runs split between processes: saveSnapshot writes the counts as
+	// they are now to a new store file, and freezeFrom freezes this store
+	// with the counts in such a file instead of its own, so every process
+	// learns from the same counts
+	bool saveSnapshot(const std::string& path) const;
+	bool freezeFrom(const std::string& path);
+	// We prevent a ShotStore object from being copied or assigned
+	ShotStore(const ShotStore&) = delete;
+	ShotStore& operator=(const ShotStore&) = delete;
+
+private:
+	ShotStore();
+	static ShotSlot* findSlot(ShotSlot* slots, unsigned long long key, bool create);
+	MappedFile* m_file;
+	std::string m_path;
+	ShotSlot* m_slots;                        //nullptr until open() succeeds
+	mutable std::vector<unsigned long long> m_frozen; //the slots as freeze found them
+	int m_frozenDepth;
+};
+
+#endif // SHOTSTORE_INCLUDED
@@ -0,0 +1,270 @@
+#include "Statistics.h"
+#include "Game.h"
+#include "Ruleset.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const double Z95 = 1.959964;  //standard normal quantile for a two-sided 95% interval
+const int NRESAMPLES = 1000;
+
+//******************** RunningMean functions **************************
+
+void RunningMean::add(double x)
+{
+	m_n++;
+	double delta = x - m_mean;
+	m_mean += delta / m_n;
+	m_m2 += delta * (x - m_mean);
+}
+
+void RunningMean::merge(const RunningMean& other)
+{
+	if (other.m_n == 0)
+		return;
+	long long n = m_n + other.m_n;
+	double delta = other.m_mean - m_mean;
+	m_mean += delta * other.m_n / n;
+	m_m2 += other.m_m2 + delta * delta * (double(m_n) * other.m_n / n);
+	m_n = n;
+}
+
+double RunningMean::stddev() const
+{
+	return sqrt(variance());
+}
+
+void RunningMean::save(ostream& out) const
+{
+	out << m_n << ' ' << setprecision(17) << m_mean << ' ' << m_m2;
+}
+
+bool RunningMean::load(istream& in)
+{
+	return bool(in >> m_n >> m_mean >> m_m2);
+}
+
+//******************** interval functions *****************************
+
+void wilsonInterval(long long successes, long long n, double& lo, double& hi)
+{
+	if (n == 0)
+	{
+		lo = 0;
+		hi = 1;
+		return;
+	}
+	double p = double(successes) / n;
+	double z2 = Z95 * Z95;
+	double centre = (p + z2 / (2 * n)) / (1 + z2 / n);
+	double half = Z95 * sqrt(p * (1 - p) / n + z2 / (4.0 * n * n)) / (1 + z2 / n);
+	lo = max(0.0, centre - half);
+	hi = min(1.0, centre + half);
+}
+
+void bootstrapMeanInterval(const unsigned int counts[], int n, double& lo, double& hi)
+{
+	unsigned long long total = 0;
+	for (int i = 0; i < n; i++)
+		total += counts[i];
+	lo = hi = 0;
+	if (total == 0)
+		return;
+	//a resample of the games is a multinomial draw over the histogram's
+	//buckets, made one binomial per bucket, so its cost doesn't grow with
+	//the number of games
+	mt19937_64 generator(12345);  //not the game generator: reports mustn't change later games
+	vector<double> means(NRESAMPLES);
+	for (int r = 0; r < NRESAMPLES; r++)
+	{
+		unsigned long long left = total;
+		unsigned long long weightLeft = total;
+		double sum = 0;
+		for (int i = 0; i < n && left > 0; i++)
+		{
+			if (counts[i] == 0)
+				continue;
+			unsigned long long k = left;
+			if (counts[i] < weightLeft)
+				k = binomial_distribution<unsigned long long>(left, double(counts[i]) / weightLeft)(generator);
+			sum += double(i) * k;
+			left -= k;
+			weightLeft -= counts[i];
+		}
+		means[r] = sum / total;
+	}
+	sort(means.begin(), means.end());
+	lo = means[int(NRESAMPLES * 0.025)];
+	hi = means[int(NRESAMPLES * 0.975) - 1];
+}
+
+//******************** MatchStats functions ***************************
+
+MatchStats::MatchStats()
+	: games(0)
+{
+	for (int e = 0; e < 2; e++)
+	{
+		for (int s = 0; s < 2; s++)
+			gamesInSeat[e][s] = winsInSeat[e][s] = 0;
+		for (int n = 0; n < NSHOTS; n++)
+			shotsToWin[e][n] = 0;
+		shots[e] = hits[e] = 0;
+		for (int i = 0; i < MAXSHIPS; i++)
+			sinkShotSum[e][i] = sinkCount[e][i] = 0;
+	}
+}
+
+void MatchStats::record(const GameRecord& rec, int first)
+{
+	if (rec.winner < 0)
+		return;
+	games++;
+	turns.add(rec.turns);
+	for (int seat = 0; seat < 2; seat++)
+	{
+		int e = seat ^ first;
+		gamesInSeat[e][seat]++;
+		shots[e] += rec.shots[seat];
+		hits[e] += rec.hits[seat];
+		for (int i = 0; i < MAXSHIPS; i++)
+		{
+			if (rec.sunkAfter[seat][i] > 0)
+			{
+				sinkShotSum[e][i] += rec.sunkAfter[seat][i];
+				sinkCount[e][i]++;
+			}
+		}
+	}
+	int e = rec.winner ^ first;
+	winsInSeat[e][rec.winner]++;
+	shotsToWin[e][min(rec.shots[rec.winner], NSHOTS - 1)]++;
+}
+
+void MatchStats::merge(const MatchStats& other)
+{
+	games += other.games;
+	turns.merge(other.turns);
+	for (int e = 0; e < 2; e++)
+	{
+		for (int s = 0; s < 2; s++)
+		{
+			gamesInSeat[e][s] += other.gamesInSeat[e][s];
+			winsInSeat[e][s] += other.winsInSeat[e][s];
+		}
+		for (int n = 0; n < NSHOTS; n++)
+			shotsToWin[e][n] += other.shotsToWin[e][n];
+		shots[e] += other.shots[e];
+		hits[e] += other.hits[e];
+		for (int i = 0; i < MAXSHIPS; i++)
+		{
+			sinkShotSum[e][i] += other.sinkShotSum[e][i];
+			sinkCount[e][i] += other.sinkCount[e][i];
+		}
+	}
+}
+
+string MatchStats::report(const string names[2], const Ruleset& rules) const
+{
+	string text;
+	char line[256];
+	for (int e = 0; e < 2; e++)
+	{
+		long long wins = winsInSeat[e][0] + winsInSeat[e][1];
+		double lo;
+		double hi;
+		wilsonInterval(wins, games, lo, hi);
+		snprintf(line, sizeof(line), "%s won %lld of %lld (%.1f%%, 95%% CI %.1f-%.1f%%)", names[e].c_str(),
+			wins, games, games > 0 ? 100.0 * wins / games : 0.0, 100 * lo, 100 * hi);
+		text += line;
+		for (int s = 0; s < 2; s++)
+		{
+			snprintf(line, sizeof(line), ", %.1f%% moving %s", gamesInSeat[e][s] > 0 ?
+				100.0 * winsInSeat[e][s] / gamesInSeat[e][s] : 0.0, s == 0 ? "first" : "second");
+			text += line;
+		}
+		text += "\n";
+
+		if (wins > 0)
+		{
+			long long sum = 0;
+			for (int n = 0; n < NSHOTS; n++)
+				sum += (long long)n * shotsToWin[e][n];
+			bootstrapMeanInterval(shotsToWin[e], NSHOTS, lo, hi);
+			snprintf(line, sizeof(line), "  shots to win %.1f (95%% CI %.1f-%.1f)", double(sum) / wins, lo, hi);
+			text += line;
+		}
+		snprintf(line, sizeof(line), "  hit ratio %.1f%%\n", shots[e] > 0 ? 100.0 * hits[e] / shots[e] : 0.0);
+		text += line;
+
+		text += "  shots to sink:";
+		for (int i = 0; i < rules.ships.size() && i < MAXSHIPS; i++)
+		{
+			if (sinkCount[e][i] == 0)
+				continue;
+			snprintf(line, sizeof(line), " %s %.1f", rules.ships[i].name.c_str(),
+				double(sinkShotSum[e][i]) / sinkCount[e][i]);
+			text += line;
+		}
+		text += "\n";
+	}
+	snprintf(line, sizeof(line), "turns per game %.1f (sd %.1f)\n", turns.mean(), turns.stddev());
+	text += line;
+	return text;
+}
+
+void MatchStats::save(ostream& out) const
+{
+	//only the histogram buckets in use, as bucket/count pairs
+	out << games << ' ';
+	turns.save(out);
+	for (int e = 0; e < 2; e++)
+	{
+		out << ' ' << gamesInSeat[e][0] << ' ' << gamesInSeat[e][1] << ' ' << winsInSeat[e][0] << ' '
+			<< winsInSeat[e][1] << ' ' << shots[e] << ' ' << hits[e];
+		for (int i = 0; i < MAXSHIPS; i++)
+			out << ' ' << sinkShotSum[e][i] << ' ' << sinkCount[e][i];
+		int used = 0;
+		for (int n = 0; n < NSHOTS; n++)
+			if (shotsToWin[e][n] != 0)
+				used++;
+		out << ' ' << used;
+		for (int n = 0; n < NSHOTS; n++)
+			if (shotsToWin[e][n] != 0)
+				out << ' ' << n << ' ' << shotsToWin[e][n];
+	}
+	out << '\n';
+}
+
+bool MatchStats::load(istream& in)
+{
+	*this = MatchStats();
+	if (!(in >> games) || !turns.load(in))
+		return false;
+	for (int e = 0; e < 2; e++)
+	{
+		if (!(in >> gamesInSeat[e][0] >> gamesInSeat[e][1] >> winsInSeat[e][0] >> winsInSeat[e][1] >>
+			shots[e] >> hits[e]))
+			return false;
+		for (int i = 0; i < MAXSHIPS; i++)
+			if (!(in >> sinkShotSum[e][i] >> sinkCount[e][i]))
+				return false;
+		int used;
+		if (!(in >> used))
+			return false;
+		for (int k = 0; k < used; k++)
+		{
+			int n;
+			if (!(in >> n) || n < 0 || n >= NSHOTS || !(in >> shotsToWin[e][n]))
+				return false;
+		}
+	}
+	return true;
+}
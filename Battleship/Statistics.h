@@ -0,0 +1,66 @@
+#ifndef STATISTICS_INCLUDED
+#define STATISTICS_INCLUDED
+
+#include "globals.h"
+#include "Game.h"
+#include <iosfwd>
+#include <string>
+
+struct Ruleset;
+
+// A mean and variance kept up to date one value at a time (Welford), which
+// can also be merged with another's (Chan et al.)
+class RunningMean
+{
+public:
+	RunningMean() : m_n(0), m_mean(0), m_m2(0) {}
+	void add(double x);
+	void merge(const RunningMean& other);
+	long long count() const { return m_n; }
+	double mean() const { return m_mean; }
+	double variance() const { return m_n > 1 ? m_m2 / (m_n - 1) : 0; }
+	double stddev() const;
+	void save(std::ostream& out) const;
+	bool load(std::istream& in);
+
+private:
+	long long m_n;
+	double m_mean;
+	double m_m2;  //sum of squared differences from the mean
+};
+
+// A 95% Wilson score interval for a proportion of successes out of n
+void wilsonInterval(long long successes, long long n, double& lo, double& hi);
+
+// A 95% percentile-bootstrap interval for the mean of the values whose
+// histogram is counts[0..n-1], from 1000 resamples.  Deterministic.
+void bootstrapMeanInterval(const unsigned int counts[], int n, double& lo, double& hi);
+
+// Everything a tournament wants to know about the games one thread has
+// played, in fixed-size arrays so that it can be copied and merged
+// cheaply and kept in shared memory.  Index e is an entrant, as in
+// TournamentResult; a seat is 0 for the player that moved first.
+struct MatchStats
+{
+	static const int MAXSHIPS = GameRecord::MAXTIMEDSHIPS;
+	static const int NSHOTS = MAXROWS * MAXCOLS + 1;
+
+	MatchStats();
+	void record(const GameRecord& rec, int first); //first is the entrant in seat 0
+	void merge(const MatchStats& other);
+	std::string report(const std::string names[2], const Ruleset& rules) const;
+	void save(std::ostream& out) const;
+	bool load(std::istream& in);
+
+	long long games;
+	long long gamesInSeat[2][2];        //[entrant][seat]
+	long long winsInSeat[2][2];
+	unsigned int shotsToWin[2][NSHOTS]; //the last bucket also counts longer wins
+	long long shots[2];
+	long long hits[2];
+	RunningMean turns;
+	long long sinkShotSum[2][MAXSHIPS]; //shots entrant e needed to sink the opponent's ship
+	long long sinkCount[2][MAXSHIPS];
+};
+
+#endif // STATISTICS_INCLUDED
@@ -0,0 +1,191 @@
+#include "Sweep.h"
+#include "Game.h"
+#include "Placements.h"
+#include "Player.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+const int GAMES_PER_CHUNK = 50;
+
+SweepConfig::SweepConfig()
+	: nGames(100), seed(1), nThreads(0), salvo(false)
+{}
+
+bool SweepConfig::read(const string& path, string& error)
+{
+	ifstream in(path);
+	if (!in)
+	{
+		error = "can't open " + path;
+		return false;
+	}
+	string line;
+	for (int n = 1; getline(in, line); n++)
+	{
+		line = line.substr(0, line.find('#'));
+		istringstream words(line);
+		string word;
+		if (!(words >> word))
+			continue;
+		string where = path + " line " + to_string(n) + ": ";
+		if (word == "players")
+		{
+			while (words >> word)
+				types.push_back(word);
+		}
+		else if (word == "games" && words >> nGames && nGames > 0)
+			;
+		else if (word == "seed" && words >> seed)
+			;
+		else if (word == "salvo")
+			salvo = true;
+		else if (word == "rules")
+		{
+			Ruleset rules;
+			string spec;
+			getline(words, spec);
+			if (!rules.parse(spec, error))
+			{
+				error = where + error;
+				return false;
+			}
+			Game g(rules.rows, rules.cols);
+			if (!rules.addShipsTo(g))
+			{
+				error = where + "the ships don't fit " + rules.str();
+				return false;
+			}
+			rulesets.push_back(rules);
+		}
+		else
+		{
+			error = where + "can't make sense of \"" + line + "\"";
+			return false;
+		}
+	}
+	if (types.size() < 2 || rulesets.empty())
+	{
+		error = path + " must name at least two players and one ruleset";
+		return false;
+	}
+	for (int i = 0; i < types.size(); i++)
+	{
+		Game g(10, 10);
+		Ruleset::standard().addShipsTo(g);
+		Player* p = createPlayer(types[i], types[i], g);
+		delete p;
+		if (p == nullptr || types[i] == "human")
+		{
+			error = types[i] + " is not a computer player";
+			return false;
+		}
+	}
+	return true;
+}
+
+//******************** Sweep functions ********************************
+
+Sweep::Sweep(const SweepConfig& config)
+	: m_config(config)
+{}
+
+vector<SweepEntry> Sweep::run()
+{
+	//build the tables up front, and guess from them what a game costs
+	vector<double> cost;
+	for (int i = 0; i < m_config.rulesets.size(); i++)
+	{
+		const Ruleset& rules = m_config.rulesets[i];
+		vector<int> lengths;
+		for (int s = 0; s < rules.ships.size(); s++)
+			lengths.push_back(rules.ships[s].length);
+		const PlacementTable& table = PlacementTable::shared(rules.rows, rules.cols, lengths);
+		double placements = 0;
+		for (int s = 0; s < table.nShips(); s++)
+			placements += table.forShip(s).size();
+		cost.push_back(rules.rows * rules.cols * placements);
+	}
+
+	vector<SweepEntry> entries;
+	for (int i = 0; i < m_config.rulesets.size(); i++)
+	{
+		for (int a = 0; a < m_config.types.size(); a++)
+		{
+			for (int b = a + 1; b < m_config.types.size(); b++)
+			{
+				SweepEntry e;
+				e.ruleset = i;
+				e.type[0] = a;
+				e.type[1] = b;
+				e.seconds = 0;
+				entries.push_back(e);
+			}
+		}
+	}
+
+	struct Chunk
+	{
+		int entry;
+		int firstGame;
+		int nGames;
+		TournamentResult result;
+		double seconds;
+	};
+	vector<Chunk> chunks;
+	for (int e = 0; e < entries.size(); e++)
+	{
+		for (int k = 0; k < m_config.nGames; k += GAMES_PER_CHUNK)
+		{
+			Chunk c;
+			c.entry = e;
+			c.firstGame = k;
+			c.nGames = min(GAMES_PER_CHUNK, m_config.nGames - k);
+			c.seconds = 0;
+			chunks.push_back(c);
+		}
+	}
+	stable_sort(chunks.begin(), chunks.end(), [&](const Chunk& x, const Chunk& y) {
+		return cost[entries[x.entry].ruleset] * x.nGames > cost[entries[y.entry].ruleset] * y.nGames;
+	});
+
+	int nThreads = m_config.nThreads;
+	if (nThreads <= 0)
+		nThreads = max(1, (int)thread::hardware_concurrency());
+	atomic<int> next(0);
+	auto worker = [&]() {
+		for (int i = next++; i < chunks.size(); i = next++)
+		{
+			Chunk& c = chunks[i];
+			const SweepEntry& e = entries[c.entry];
+			TournamentConfig config;
+			config.rules = m_config.rulesets[e.ruleset];
+			for (int j = 0; j < 2; j++)
+				config.type[j] = config.name[j] = m_config.types[e.type[j]];
+			config.seed = m_config.seed;
+			config.salvo = m_config.salvo;
+			config.firstGame = c.firstGame;
+			config.nGames = c.nGames;
+			config.nThreads = 1;
+			Tournament t(config);
+			c.result = t.run();
+			c.seconds = c.result.seconds;
+		}
+	};
+	vector<thread> threads;
+	for (int t = 0; t < min(nThreads, (int)chunks.size()); t++)
+		threads.push_back(thread(worker));
+	for (int t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	for (int i = 0; i < chunks.size(); i++)
+	{
+		entries[chunks[i].entry].result.merge(chunks[i].result);
+		entries[chunks[i].entry].seconds += chunks[i].seconds;
+	}
+	return entries;
+}
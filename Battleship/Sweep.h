@@ -0,0 +1,59 @@
+#ifndef SWEEP_INCLUDED
+#define SWEEP_INCLUDED
+
+#include "Ruleset.h"
+#include "Tournament.h"
+#include <string>
+#include <vector>
+
+// What to sweep, read from a file of lines like these (# starts a comment):
+//
+//   players good mediocre exact     every pair of these plays a match
+//   games 200                       games in each match
+//   seed 1                          game k starts with seedRandom(seed + k)
+//   salvo                           play the salvo variant
+//   rules standard                  one line per ruleset, as Ruleset::parse reads it
+//   rules 8 8 A5 B4 D3 P2
+struct SweepConfig
+{
+	SweepConfig();
+	bool read(const std::string& path, std::string& error);
+	std::vector<std::string> types;  //createPlayer types
+	std::vector<Ruleset> rulesets;
+	int nGames;
+	unsigned int seed;
+	int nThreads;                    //0 means one per core
+	bool salvo;
+};
+
+// One match of the sweep: two of the types under one ruleset
+struct SweepEntry
+{
+	int ruleset;          //index into SweepConfig::rulesets
+	int type[2];          //indexes into SweepConfig::types
+	TournamentResult result;
+	double seconds;       //time spent playing its games, summed over the threads
+};
+
+// Plays every pair of types under every ruleset.  Each ruleset's placement
+// tables are built once before any game starts and shared by all threads.
+// The matches are cut into chunks of games that the threads take in turn,
+// the chunks whose rulesets look dearest (board cells times placements)
+// first, so a large board isn't left to one thread at the end while the
+// others sit idle.  Every game is seeded from its number alone, so the
+// results don't depend on the number of threads.
+class Sweep
+{
+public:
+	Sweep(const SweepConfig& config);
+	// Returns the matches by ruleset, then by pair of types in order
+	std::vector<SweepEntry> run();
+	// We prevent a Sweep object from being copied or assigned
+	Sweep(const Sweep&) = delete;
+	Sweep& operator=(const Sweep&) = delete;
+
+private:
+	SweepConfig m_config;
+};
+
+#endif // SWEEP_INCLUDED
@@ -0,0 +1,134 @@
+#include "Timing.h"
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Durations are kept in whole nanoseconds.  Values below 16ns get a bucket
+// each; above that every power of two is split into 16 buckets.
+
+LatencyHistogram::LatencyHistogram()
+{
+	clear();
+}
+
+void LatencyHistogram::clear()
+{
+	for (int i = 0; i < NBUCKETS; i++)
+		m_counts[i] = 0;
+	m_count = 0;
+	m_total = 0;
+	m_max = 0;
+}
+
+int LatencyHistogram::bucketOf(unsigned long long ns)
+{
+	if (ns < 16)
+		return int(ns);
+	int e = 0;
+	while ((ns >> e) >= 32)
+		e++;
+	//now 16 <= ns >> e < 32
+	int b = 16 + e * 16 + int((ns >> e) - 16);
+	return b < NBUCKETS ? b : NBUCKETS - 1;
+}
+
+double LatencyHistogram::bucketUpperBound(int bucket)
+{
+	if (bucket < 16)
+		return (bucket + 1) * 1e-9;
+	int e = (bucket - 16) / 16;
+	int sub = (bucket - 16) % 16;
+	return double((unsigned long long)(16 + sub + 1) << e) * 1e-9;
+}
+
+void LatencyHistogram::record(double seconds)
+{
+	if (seconds < 0)
+		seconds = 0;
+	m_counts[bucketOf((unsigned long long)(seconds * 1e9))]++;
+	m_count++;
+	m_total += seconds;
+	if (seconds > m_max)
+		m_max = seconds;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	for (int i = 0; i < NBUCKETS; i++)
+		m_counts[i] += other.m_counts[i];
+	m_count += other.m_count;
+	m_total += other.m_total;
+	if (other.m_max > m_max)
+		m_max = other.m_max;
+}
+
+double LatencyHistogram::percentile(double pct) const
+{
+	if (m_count == 0)
+		return 0;
+	long long rank = (long long)(pct / 100 * m_count + 0.5);
+	if (rank < 1)
+		rank = 1;
+	long long seen = 0;
+	for (int i = 0; i < NBUCKETS; i++)
+	{
+		seen += m_counts[i];
+		if (seen >= rank)
+			return bucketUpperBound(i) < m_max ? bucketUpperBound(i) : m_max;
+	}
+	return m_max;
+}
+
+string LatencyHistogram::summary() const
+{
+	return "p50 " + formatSeconds(percentile(50)) + "  p90 " + formatSeconds(percentile(90)) +
+		"  p99 " + formatSeconds(percentile(99)) + "  max " + formatSeconds(m_max);
+}
+
+void LatencyHistogram::save(ostream& out) const
+{
+	//only the buckets in use, as bucket/count pairs
+	int used = 0;
+	for (int i = 0; i < NBUCKETS; i++)
+		if (m_counts[i] != 0)
+			used++;
+	out << m_count << ' ' << setprecision(17) << m_total << ' ' << m_max << ' ' << used;
+	for (int i = 0; i < NBUCKETS; i++)
+		if (m_counts[i] != 0)
+			out << ' ' << i << ' ' << m_counts[i];
+	out << '\n';
+}
+
+bool LatencyHistogram::load(istream& in)
+{
+	clear();
+	int used;
+	if (!(in >> m_count >> m_total >> m_max >> used))
+		return false;
+	for (int k = 0; k < used; k++)
+	{
+		int i;
+		long long n;
+		if (!(in >> i >> n) || i < 0 || i >= NBUCKETS)
+			return false;
+		m_counts[i] = n;
+	}
+	return true;
+}
+
+string formatSeconds(double seconds)
+{
+	char buf[32];
+	if (seconds < 1e-6)
+		snprintf(buf, sizeof(buf), "%.0fns", seconds * 1e9);
+	else if (seconds < 1e-3)
+		snprintf(buf, sizeof(buf), "%.1fus", seconds * 1e6);
+	else if (seconds < 1)
+		snprintf(buf, sizeof(buf), "%.2fms", seconds * 1e3);
+	else
+		snprintf(buf, sizeof(buf), "%.2fs", seconds);
+	return buf;
+}
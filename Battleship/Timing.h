@@ -0,0 +1,53 @@
+#ifndef TIMING_INCLUDED
+#define TIMING_INCLUDED
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+// The point in time by which a player must have decided
+typedef std::chrono::steady_clock::time_point Deadline;
+
+inline Deadline noDeadline()
+{
+	return Deadline::max();
+}
+
+// Seconds elapsed since start
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A histogram of durations with buckets about 6% wide, from nanoseconds to
+// minutes, so that percentiles can be read off without keeping every sample
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+	void clear();
+	void record(double seconds);
+	void merge(const LatencyHistogram& other);
+	long long count() const { return m_count; }
+	double total() const { return m_total; }
+	double mean() const { return m_count == 0 ? 0 : m_total / m_count; }
+	double max() const { return m_max; }
+	double percentile(double pct) const; //e.g. percentile(99); 0 if empty
+	std::string summary() const;         //"p50 ... p90 ... p99 ... max ..."
+	void save(std::ostream& out) const;  //one line that load() reads back
+	bool load(std::istream& in);
+
+private:
+	static const int NBUCKETS = 560;
+	static int bucketOf(unsigned long long ns);
+	static double bucketUpperBound(int bucket);
+	long long m_counts[NBUCKETS];
+	long long m_count;
+	double m_total;
+	double m_max;
+};
+
+// A short human-readable duration such as "850ns", "12.3us", "4.56ms" or "2.1s"
+std::string formatSeconds(double seconds);
+
+#endif // TIMING_INCLUDED
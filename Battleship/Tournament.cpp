@@ -0,0 +1,369 @@
+#include "Tournament.h"
+#include "Dashboard.h"
+#include "Game.h"
+#include "LayoutStore.h"
+#include "Platform.h"
+#include "Player.h"
+#include "Renderer.h"
+#include "ResultsFile.h"
+#include "ShotStore.h"
+#include "TranscriptLog.h"
+#include "globals.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+TournamentConfig::TournamentConfig()
+	: rules(Ruleset::standard()), firstGame(0), nGames(0), seed(1), nThreads(0),
+	msPerMove(0), msPerGame(0), salvo(false), watch(false), checkpointSeconds(30), resume(false),
+	dropTranscript(false)
+{
+	type[0] = type[1] = "good";
+	name[0] = "Player 1";
+	name[1] = "Player 2";
+}
+
+TournamentResult::TournamentResult()
+	: games(0), noResult(0), seconds(0)
+{
+	for (int i = 0; i < 2; i++)
+		wins[i] = timeouts[i] = lateMoves[i] = 0;
+}
+
+void TournamentResult::merge(const TournamentResult& other)
+{
+	games += other.games;
+	noResult += other.noResult;
+	for (int i = 0; i < 2; i++)
+	{
+		wins[i] += other.wins[i];
+		timeouts[i] += other.timeouts[i];
+		lateMoves[i] += other.lateMoves[i];
+		moveLatency[i].merge(other.moveLatency[i]);
+	}
+	stats.merge(other.stats);
+}
+
+Tournament::Tournament(const TournamentConfig& config)
+	: m_config(config), m_dashboard(nullptr), m_results(nullptr), m_transcript(nullptr)
+{}
+
+TournamentResult Tournament::run()
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	int nThreads = m_config.nThreads;
+	if (nThreads <= 0)
+		nThreads = max(1, (int)thread::hardware_concurrency());
+
+	//done[k - firstGame] is set for games an earlier run already played
+	vector<char> done(m_config.nGames, 0);
+	TournamentResult total;
+	if (m_config.resume && !m_config.checkpoint.empty() && !loadCheckpoint(done, total))
+	{
+		cout << "No usable checkpoint in " << m_config.checkpoint << "; starting from the first game." << endl;
+		done.assign(m_config.nGames, 0);
+		total = TournamentResult();
+	}
+	double earlierSeconds = total.seconds;
+
+	//when watching, each worker draws its games into its own tile and
+	//this thread puts the tiles on the screen a few times a second
+	TiledView* view = nullptr;
+	if (m_config.watch)
+		view = new TiledView(nThreads, 80);
+	Dashboard dashboard;
+	if (!m_config.dashboard.empty())
+	{
+		if (dashboard.create(m_config.dashboard, m_config.name, m_config.nGames))
+			m_dashboard = &dashboard;
+		else
+			cout << "Could not create dashboard file " << m_config.dashboard << endl;
+	}
+	ResultsWriter results;
+	if (!m_config.results.empty())
+	{
+		if (results.create(m_config.results, m_config.name, m_config.rules, m_config.resume ? &done : nullptr,
+			m_config.firstGame))
+			m_results = &results;
+		else
+			cout << "Could not create results file " << m_config.results << endl;
+	}
+	ofstream transcriptFile;
+	TranscriptLog* transcript = nullptr;
+	if (!m_config.transcript.empty())
+	{
+		transcriptFile.open(m_config.transcript);
+		if (transcriptFile)
+			transcript = m_transcript = new TranscriptLog(transcriptFile, m_config.dropTranscript ? LOG_DROP : LOG_WAIT);
+		else
+			cout << "Could not create transcript file " << m_config.transcript << endl;
+	}
+
+	//each worker keeps its own totals, touched by no other thread while it
+	//plays.  To take a checkpoint this thread bumps the epoch; each worker
+	//notices between games, copies its totals to the shown fields and
+	//answers with that epoch.  Nothing is read while it can be written, so
+	//no locks are needed, and the workers pay one relaxed load per game.
+	//A worker also writes out its results rows before answering, so the
+	//results file holds every game a checkpoint counts as played.
+	//The padding keeps the workers' answers on different cache lines.
+	struct WorkerTotals
+	{
+		TournamentResult result;
+		vector<int> played;
+		TournamentResult shownResult;
+		vector<int> shownPlayed;
+		char pad1[64];
+		atomic<int> shownEpoch;
+		char pad2[64];
+	};
+	vector<WorkerTotals> totals(nThreads);
+	for (int t = 0; t < nThreads; t++)
+		totals[t].shownEpoch = 0;
+	atomic<int> epoch(0);
+	atomic<bool> stop(false);
+	atomic<int> next(m_config.firstGame);
+	int end = m_config.firstGame + m_config.nGames;
+	atomic<int> running(nThreads);
+	auto answer = [&](WorkerTotals& mine, ResultsBlock* rows) {
+		int e = epoch.load(memory_order_acquire);
+		if (mine.shownEpoch.load(memory_order_relaxed) == e)
+			return;
+		if (rows != nullptr)
+			m_results->write(*rows);
+		mine.shownResult = mine.result;
+		mine.shownPlayed = mine.played;
+		mine.shownEpoch.store(e, memory_order_release);
+	};
+	auto worker = [&](int t) {
+		WorkerTotals& mine = totals[t];
+		ResultsBlock* rows = (m_results != nullptr ? new ResultsBlock : nullptr);
+		for (int k = next++; k < end; k = next++)
+		{
+			if (done[k - m_config.firstGame])
+				continue;
+			playGame(k, mine.result, view != nullptr ? view->tile(t) : nullptr, rows);
+			mine.played.push_back(k);
+			if (rows != nullptr && rows->full())
+				m_results->write(*rows);
+			answer(mine, rows);
+		}
+		if (rows != nullptr)
+			m_results->write(*rows);
+		delete rows;
+		running--;
+		while (!stop.load(memory_order_acquire)) //still answer checkpoints until all are done
+		{
+			answer(mine, nullptr);
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	};
+	//live is true while the workers run; afterwards their own totals are read
+	auto progress = [&](vector<char>& doneNow, bool live) {
+		int e = (live ? epoch.fetch_add(1, memory_order_release) + 1 : 0);
+		doneNow = done;
+		TournamentResult sum = total;
+		for (int t = 0; t < nThreads; t++)
+		{
+			if (live)
+				while (totals[t].shownEpoch.load(memory_order_acquire) != e)
+					this_thread::sleep_for(chrono::milliseconds(1));
+			const TournamentResult& result = (live ? totals[t].shownResult : totals[t].result);
+			const vector<int>& played = (live ? totals[t].shownPlayed : totals[t].played);
+			sum.merge(result);
+			for (int i = 0; i < played.size(); i++)
+				doneNow[played[i] - m_config.firstGame] = 1;
+		}
+		sum.seconds = earlierSeconds + secondsSince(start);
+		return sum;
+	};
+
+	//players learn only from games before the run, whatever order its games end in
+	ShotStore::instance().freeze();
+	LayoutStore::instance().freeze();
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++)
+		threads.push_back(thread(worker, t));
+	if (view != nullptr || !m_config.checkpoint.empty())
+	{
+		chrono::steady_clock::time_point lastSaved = chrono::steady_clock::now();
+		vector<char> doneNow;
+		while (running > 0)
+		{
+			if (view != nullptr)
+				view->present(cout);
+			if (!m_config.checkpoint.empty() && secondsSince(lastSaved) >= m_config.checkpointSeconds)
+			{
+				TournamentResult sum = progress(doneNow, true);
+				if (m_results != nullptr)
+					m_results->flush();
+				if (!saveCheckpoint(doneNow, sum))
+					cout << "Could not save checkpoint " << m_config.checkpoint << endl;
+				lastSaved = chrono::steady_clock::now();
+			}
+			this_thread::sleep_for(chrono::milliseconds(100));
+		}
+		if (view != nullptr)
+			view->present(cout);
+	}
+	stop = true;
+	for (int t = 0; t < threads.size(); t++)
+		threads[t].join();
+	ShotStore::instance().thaw();
+	LayoutStore::instance().thaw();
+	delete view;
+	dashboard.finish();
+	m_dashboard = nullptr;
+	results.close();
+	m_results = nullptr;
+	if (transcript != nullptr)
+	{
+		transcript->close();
+		if (transcript->droppedGames() > 0)
+			cout << transcript->droppedGames() << " games were left out of " << m_config.transcript
+				<< " because it fell behind." << endl;
+		delete transcript;
+		m_transcript = nullptr;
+	}
+
+	vector<char> doneNow;
+	total = progress(doneNow, false);
+	if (!m_config.checkpoint.empty() && !saveCheckpoint(doneNow, total))
+		cout << "Could not save checkpoint " << m_config.checkpoint << endl;
+	return total;
+}
+
+void Tournament::playGame(int k, TournamentResult& result, GameObserver* observer, ResultsBlock* rows) const
+{
+	seedRandom(m_config.seed + k);
+	Game g(m_config.rules.rows, m_config.rules.cols);
+	g.setTranscript(nullptr);
+	g.setTranscriptLog(m_transcript);
+	g.setTimeLimits(m_config.msPerMove, m_config.msPerGame);
+	g.setObserver(observer);
+	g.setSalvo(m_config.salvo);
+	result.games++;
+	if (!m_config.rules.addShipsTo(g))
+	{
+		result.noResult++;
+		if (m_dashboard != nullptr)
+			m_dashboard->recordGame(-1, 0);
+		return;
+	}
+
+	Player* entrants[2];
+	for (int i = 0; i < 2; i++)
+		entrants[i] = createPlayer(m_config.type[i], m_config.name[i], g);
+
+	int first = k % 2; //entrant sitting in seat 0
+	GameRecord rec;
+	g.play(entrants[first], entrants[1 - first], false, &rec);
+	if (rec.winner < 0)
+		result.noResult++;
+	else
+		result.wins[rec.winner ^ first]++;
+	result.stats.record(rec, first);
+	if (rows != nullptr)
+		rows->record(k, m_config.seed, first, rec);
+	if (m_dashboard != nullptr)
+		m_dashboard->recordGame(rec.winner < 0 ? -1 : rec.winner ^ first, rec.winner < 0 ? 0 : rec.shots[rec.winner]);
+	for (int seat = 0; seat < 2; seat++)
+	{
+		int e = seat ^ first;
+		if (rec.timedOut[seat])
+			result.timeouts[e]++;
+		result.lateMoves[e] += rec.lateMoves[seat];
+		result.moveLatency[e].merge(rec.moveLatency[seat]);
+	}
+	delete entrants[0];
+	delete entrants[1];
+}
+
+//******************** checkpoint functions ***************************
+
+// A checkpoint is a small text file:
+//   BSCHECKPOINT2
+//   <seed> <firstGame> <nGames> <rows> <cols> <ships>
+//   <type of entrant 0>
+//   <type of entrant 1>
+//   <number of ranges> <from> <to> ...     games from..to-1 have been played
+//   <games> <noResult> <wins> <timeouts> <lateMoves> <seconds>
+//   <latency of entrant 0>
+//   <latency of entrant 1>
+//   <MatchStats>
+
+const char CHECKPOINTMAGIC[] = "BSCHECKPOINT2";
+
+string matchLine(const TournamentConfig& c)
+{
+	string line = to_string(c.seed) + " " + to_string(c.firstGame) + " " + to_string(c.nGames) + " " +
+		to_string(c.rules.rows) + " " + to_string(c.rules.cols) + (c.salvo ? " salvo " : " ");
+	for (int i = 0; i < c.rules.ships.size(); i++)
+		line += to_string(c.rules.ships[i].length) + c.rules.ships[i].symbol;
+	return line;
+}
+
+bool Tournament::saveCheckpoint(const vector<char>& done, const TournamentResult& result) const
+{
+	ostringstream out;
+	out << CHECKPOINTMAGIC << '\n' << matchLine(m_config) << '\n'
+		<< m_config.type[0] << '\n' << m_config.type[1] << '\n';
+	vector<int> ranges;
+	for (int i = 0; i < done.size(); i++)
+	{
+		if (done[i] && (i == 0 || !done[i - 1]))
+			ranges.push_back(m_config.firstGame + i);
+		if (done[i] && (i + 1 == done.size() || !done[i + 1]))
+			ranges.push_back(m_config.firstGame + i + 1);
+	}
+	out << ranges.size() / 2;
+	for (int i = 0; i < ranges.size(); i++)
+		out << ' ' << ranges[i];
+	out << '\n' << result.games << ' ' << result.noResult;
+	for (int i = 0; i < 2; i++)
+		out << ' ' << result.wins[i] << ' ' << result.timeouts[i] << ' ' << result.lateMoves[i];
+	out << ' ' << setprecision(17) << result.seconds << '\n';
+	result.moveLatency[0].save(out);
+	result.moveLatency[1].save(out);
+	result.stats.save(out);
+	return writeFileAtomically(m_config.checkpoint, out.str());
+}
+
+bool Tournament::loadCheckpoint(vector<char>& done, TournamentResult& result) const
+{
+	ifstream in(m_config.checkpoint.c_str());
+	string line;
+	if (!getline(in, line) || line != CHECKPOINTMAGIC)
+		return false;
+	if (!getline(in, line) || line != matchLine(m_config))
+		return false;
+	for (int i = 0; i < 2; i++)
+		if (!getline(in, line) || line != m_config.type[i])
+			return false;
+	int nRanges;
+	if (!(in >> nRanges))
+		return false;
+	for (int r = 0; r < nRanges; r++)
+	{
+		int from;
+		int to;
+		if (!(in >> from >> to) || from < m_config.firstGame || to > m_config.firstGame + m_config.nGames)
+			return false;
+		for (int k = from; k < to; k++)
+			done[k - m_config.firstGame] = 1;
+	}
+	if (!(in >> result.games >> result.noResult))
+		return false;
+	for (int i = 0; i < 2; i++)
+		if (!(in >> result.wins[i] >> result.timeouts[i] >> result.lateMoves[i]))
+			return false;
+	return (in >> result.seconds) && result.moveLatency[0].load(in) && result.moveLatency[1].load(in) &&
+		result.stats.load(in);
+}
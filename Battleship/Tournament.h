@@ -0,0 +1,78 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include "Ruleset.h"
+#include "Statistics.h"
+#include "Timing.h"
+#include <string>
+#include <vector>
+
+class GameObserver;
+class Dashboard;
+class ResultsWriter;
+class TranscriptLog;
+struct ResultsBlock;
+
+struct TournamentConfig
+{
+	TournamentConfig();
+	Ruleset rules;
+	std::string type[2];  //createPlayer types of the two entrants
+	std::string name[2];
+	int firstGame;        //games firstGame .. firstGame+nGames-1 are played
+	int nGames;
+	unsigned int seed;    //game k starts with seedRandom(seed + k)
+	int nThreads;         //0 means one per core
+	int msPerMove;        //time limits for Game::setTimeLimits, 0 for none
+	int msPerGame;
+	bool salvo;           //play the salvo variant
+	bool watch;           //show every worker's current game on the terminal while playing
+	std::string dashboard; //file that 'view' can watch while the games run, empty for none
+	std::string checkpoint; //file the progress is saved in every checkpointSeconds, empty for none
+	int checkpointSeconds;
+	bool resume;          //continue from checkpoint if it holds an earlier run of the same games
+	std::string results;  //file every game's result is written to, empty for none
+	std::string transcript; //file every game's transcript is written to, empty for none
+	bool dropTranscript;  //leave games out of the transcript rather than wait for it
+};
+
+// Totals for the two entrants, index 0 being type[0]
+struct TournamentResult
+{
+	TournamentResult();
+	void merge(const TournamentResult& other);
+	int games;
+	int noResult;         //games that could not be played
+	int wins[2];
+	int timeouts[2];      //games lost on time
+	int lateMoves[2];
+	LatencyHistogram moveLatency[2];
+	MatchStats stats;
+	double seconds;       //wall-clock time of the run
+};
+
+// Plays a series of games between two kinds of player on worker threads.
+// Entrant 0 moves first in even-numbered games.  Every game is seeded from
+// its number alone, so for players that don't depend on timing the result
+// is the same however many threads run it.  Players that learn from the
+// ShotStore or LayoutStore see them as they were when the run started.
+class Tournament
+{
+public:
+	Tournament(const TournamentConfig& config);
+	TournamentResult run();
+	// We prevent a Tournament object from being copied or assigned
+	Tournament(const Tournament&) = delete;
+	Tournament& operator=(const Tournament&) = delete;
+
+private:
+	void playGame(int k, TournamentResult& result, GameObserver* observer, ResultsBlock* rows) const;
+	bool saveCheckpoint(const std::vector<char>& done, const TournamentResult& result) const;
+	bool loadCheckpoint(std::vector<char>& done, TournamentResult& result) const;
+	TournamentConfig m_config;
+	Dashboard* m_dashboard;
+	ResultsWriter* m_results;
+	TranscriptLog* m_transcript;
+};
+
+#endif // TOURNAMENT_INCLUDED
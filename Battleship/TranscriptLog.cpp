@@ -0,0 +1,436 @@
+#include "TranscriptLog.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+using namespace std;
+
+//******************** the transcript's wording ***********************
+
+void describeTurn(string& frame, const string& attacker, const string& defender)
+{
+	frame += attacker;
+	frame += "'s turn.  Board for ";
+	frame += defender;
+	frame += ":\n";
+}
+
+void describeShot(string& frame, const Game& g, const string& attacker, const ShotResult& shot,
+	bool late, bool boardFollows)
+{
+	//appended piece by piece, so that once frame has grown no turn allocates
+	char where[32];
+	snprintf(where, sizeof(where), "(%d,%d)", shot.p.r, shot.p.c);
+	const char* end = (boardFollows ? ", resulting in:\n" : ".\n");
+	frame += attacker;
+	if (late || !shot.validShot)
+	{
+		frame += (late ? " took too long and wasted a shot at " : " wasted a shot at ");
+		frame += where;
+		frame += ".\n";
+		return;
+	}
+	frame += " attacked ";
+	frame += where;
+	if (!shot.shotHit) //all outputs copy the given sample program
+		frame += " and missed";
+	else if (!shot.shipDestroyed)
+		frame += " and hit something";
+	else
+	{
+		frame += " and destroyed the ";
+		frame += g.shipName(shot.shipId);
+	}
+	frame += end;
+}
+
+string timeoutMessage(const string& attacker, const string& defender)
+{
+	return attacker + " ran out of time.  " + defender + " wins!\n";
+}
+
+//******************** events and rings *******************************
+
+enum EventKind {
+	EVENT_START, EVENT_TURN, EVENT_SHOT, EVENT_BOARD, EVENT_TIMEOUT, EVENT_WON
+};
+
+const int SHOT_VALID = 1, SHOT_HIT = 2, SHOT_DESTROYED = 4, SHOT_LATE = 8, SHOT_BOARD_FOLLOWS = 16;
+
+// Every record starts with one of these.  A game's opening record goes on
+// with the rules, the players' names and both layouts.
+struct LogEvent
+{
+	unsigned short size;  //of the whole record
+	unsigned char kind;
+	unsigned char seat;   //of the attacker
+	unsigned char flags;
+	unsigned char unused;
+	short r;
+	short c;
+	short shipId;
+};
+
+struct TranscriptRing
+{
+	TranscriptRing(size_t bytes, thread::id id)
+		: buffer(bytes), head(0), owner(id), dropping(false), tail(0), game(nullptr), open(false)
+	{
+		boards[0] = boards[1] = nullptr;
+	}
+	~TranscriptRing()
+	{
+		delete boards[0];
+		delete boards[1];
+		delete game;
+	}
+
+	vector<char> buffer;     //its size is a power of two
+	//written by the game thread
+	atomic<size_t> head;     //bytes ever written
+	thread::id owner;
+	bool dropping;           //an event of the current game didn't fit
+	vector<char> opening;    //where a game's opening record is put together
+	char pad[64];            //keeps the two threads' fields on different cache lines
+	//written by the log's thread
+	atomic<size_t> tail;     //bytes ever read
+	Game* game;              //set up with the rules of the last game opened
+	string rules;            //those rules, as the opening record has them
+	Board* boards[2];
+	string names[2];
+	string text;             //the current game's transcript so far
+	bool open;               //a game has started and not yet ended
+};
+
+// Each thread remembers its ring in the log it last used
+struct RingCache
+{
+	unsigned long long serial;
+	TranscriptRing* ring;
+};
+
+thread_local RingCache t_ringCache = { 0, nullptr };
+atomic<unsigned long long> nextLogSerial(1);
+
+//******************** TranscriptLog functions ************************
+
+TranscriptLog::TranscriptLog(ostream& out, LogOverflow overflow, int ringBytes)
+	: m_out(out), m_overflow(overflow), m_ringBytes(1024), m_serial(nextLogSerial++), m_stop(false),
+	m_droppedGames(0)
+{
+	while (m_ringBytes < ringBytes) //a power of two, so that positions wrap with a mask
+		m_ringBytes *= 2;
+	m_thread = thread(&TranscriptLog::run, this);
+}
+
+TranscriptLog::~TranscriptLog()
+{
+	close();
+	for (int i = 0; i < m_rings.size(); i++)
+		delete m_rings[i];
+}
+
+void TranscriptLog::close()
+{
+	if (!m_thread.joinable())
+		return;
+	m_stop = true;
+	m_thread.join();
+}
+
+TranscriptRing& TranscriptLog::ring()
+{
+	if (t_ringCache.serial == m_serial)
+		return *t_ringCache.ring;
+	lock_guard<mutex> lock(m_mutex);
+	thread::id id = this_thread::get_id();
+	TranscriptRing* found = nullptr;
+	for (int i = 0; i < m_rings.size() && found == nullptr; i++)
+		if (m_rings[i]->owner == id)
+			found = m_rings[i];
+	if (found == nullptr)
+	{
+		found = new TranscriptRing(m_ringBytes, id);
+		m_rings.push_back(found);
+	}
+	t_ringCache.serial = m_serial;
+	t_ringCache.ring = found;
+	return *found;
+}
+
+bool TranscriptLog::push(TranscriptRing& ring, const char* data, size_t size)
+{
+	size_t capacity = ring.buffer.size();
+	if (size > capacity)
+		return false;
+	size_t head = ring.head.load(memory_order_relaxed);
+	while (capacity - (head - ring.tail.load(memory_order_acquire)) < size)
+	{
+		if (m_overflow == LOG_DROP)
+			return false;
+		this_thread::yield();
+	}
+	size_t at = head & (capacity - 1);
+	size_t first = min(size, capacity - at);
+	memcpy(&ring.buffer[at], data, first);
+	memcpy(&ring.buffer[0], data + first, size - first);
+	ring.head.store(head + size, memory_order_release);
+	return true;
+}
+
+void TranscriptLog::startGame(const Game& g, const Player* players[2], const Board* boards[2])
+{
+	TranscriptRing& r = ring();
+	r.dropping = false;
+	vector<char>& rec = r.opening;
+	rec.assign(sizeof(LogEvent), 0);
+	auto putString = [&rec](const string& s) {
+		size_t n = min(s.size(), size_t(0xffff));
+		rec.push_back(char(n & 0xff));
+		rec.push_back(char(n >> 8));
+		rec.insert(rec.end(), s.begin(), s.begin() + n);
+	};
+	rec.push_back(char(g.rows()));
+	rec.push_back(char(g.cols()));
+	rec.push_back(char(g.nShips() & 0xff));
+	rec.push_back(char(g.nShips() >> 8));
+	for (int i = 0; i < g.nShips(); i++)
+	{
+		rec.push_back(char(g.shipLength(i)));
+		rec.push_back(g.shipSymbol(i));
+		putString(g.shipName(i));
+	}
+	for (int b = 0; b < 2; b++)
+	{
+		putString(players[b]->name());
+		for (int i = 0; i < g.nShips(); i++)
+		{
+			Point top(-1, -1);
+			Direction dir = HORIZONTAL;
+			boards[b]->shipPlacement(i, top, dir);
+			rec.push_back(char(top.r));
+			rec.push_back(char(top.c));
+			rec.push_back(char(dir));
+		}
+	}
+	LogEvent e = { (unsigned short)rec.size(), EVENT_START, 0, 0, 0, 0, 0, -1 };
+	memcpy(&rec[0], &e, sizeof(e));
+	if (rec.size() > 0xffff || !push(r, &rec[0], rec.size()))
+	{
+		r.dropping = true;
+		m_droppedGames++;
+	}
+}
+
+void TranscriptLog::post(int kind, int seat, const ShotResult* shot, int flags)
+{
+	TranscriptRing& r = ring();
+	if (r.dropping) //the game is already lost to the transcript
+		return;
+	LogEvent e = { sizeof(LogEvent), (unsigned char)kind, (unsigned char)seat, (unsigned char)flags, 0, 0, 0, -1 };
+	if (shot != nullptr)
+	{
+		e.r = (short)shot->p.r;
+		e.c = (short)shot->p.c;
+		e.shipId = (short)shot->shipId;
+	}
+	if (!push(r, reinterpret_cast<const char*>(&e), sizeof(e)))
+	{
+		r.dropping = true;
+		m_droppedGames++;
+	}
+}
+
+void TranscriptLog::turn(int seat)
+{
+	post(EVENT_TURN, seat, nullptr, 0);
+}
+
+void TranscriptLog::shot(int seat, const ShotResult& shot, bool late, bool boardFollows)
+{
+	int flags = (shot.validShot ? SHOT_VALID : 0) | (shot.shotHit ? SHOT_HIT : 0) |
+		(shot.shipDestroyed ? SHOT_DESTROYED : 0) | (late ? SHOT_LATE : 0) | (boardFollows ? SHOT_BOARD_FOLLOWS : 0);
+	post(EVENT_SHOT, seat, &shot, flags);
+}
+
+void TranscriptLog::board(int seat)
+{
+	post(EVENT_BOARD, seat, nullptr, 0);
+}
+
+void TranscriptLog::timedOut(int seat)
+{
+	post(EVENT_TIMEOUT, seat, nullptr, 0);
+}
+
+void TranscriptLog::won(int seat)
+{
+	post(EVENT_WON, seat, nullptr, 0);
+}
+
+//******************** the log's thread *******************************
+
+void TranscriptLog::run()
+{
+	const size_t WRITE_BYTES = 1 << 20; //finished games are written in chunks of about this size
+	vector<TranscriptRing*> rings;
+	vector<char> record;
+	for (;;)
+	{
+		//anything logged before stop was set is read in this sweep
+		bool stopping = m_stop.load(memory_order_acquire);
+		{
+			lock_guard<mutex> lock(m_mutex);
+			rings = m_rings;
+		}
+		bool idle = true;
+		for (int i = 0; i < rings.size(); i++)
+		{
+			//only what is there now, so that one busy thread can't hold up the rest
+			TranscriptRing& r = *rings[i];
+			size_t capacity = r.buffer.size();
+			size_t head = r.head.load(memory_order_acquire);
+			size_t tail = r.tail.load(memory_order_relaxed);
+			while (tail < head)
+			{
+				LogEvent e;
+				record.resize(sizeof(e));
+				for (size_t k = 0; k < sizeof(e); k++)
+					record[k] = r.buffer[(tail + k) & (capacity - 1)];
+				memcpy(&e, &record[0], sizeof(e));
+				record.resize(e.size);
+				for (size_t k = sizeof(e); k < e.size; k++)
+					record[k] = r.buffer[(tail + k) & (capacity - 1)];
+				tail += e.size;
+				r.tail.store(tail, memory_order_release);
+				format(r, record);
+				idle = false;
+			}
+			if (m_pending.size() >= WRITE_BYTES)
+			{
+				m_out.write(m_pending.data(), m_pending.size());
+				m_pending.clear();
+			}
+		}
+		if (idle)
+		{
+			if (!m_pending.empty())
+			{
+				m_out.write(m_pending.data(), m_pending.size());
+				m_pending.clear();
+			}
+			m_out.flush();
+			if (stopping)
+				return;
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+}
+
+void TranscriptLog::format(TranscriptRing& r, const vector<char>& record)
+{
+	LogEvent e;
+	memcpy(&e, &record[0], sizeof(e));
+	if (e.kind == EVENT_START)
+	{
+		//a game still open here lost its ending to LOG_DROP and is forgotten
+		size_t at = sizeof(e);
+		auto getByte = [&]() { return (unsigned char)record[at++]; };
+		auto getString = [&]() {
+			size_t n = getByte();
+			n |= size_t(getByte()) << 8;
+			at += n;
+			return string(&record[at - n], n);
+		};
+		int rows = getByte();
+		int cols = getByte();
+		int nShips = getByte();
+		nShips |= getByte() << 8;
+		vector<int> lengths(nShips);
+		vector<char> symbols(nShips);
+		vector<string> shipNames(nShips);
+		for (int i = 0; i < nShips; i++)
+		{
+			lengths[i] = getByte();
+			symbols[i] = char(getByte());
+			shipNames[i] = getString();
+		}
+		string rules(&record[sizeof(e)], at - sizeof(e));
+		if (r.game == nullptr || rules != r.rules)
+		{
+			for (int b = 0; b < 2; b++)
+				delete r.boards[b];
+			delete r.game;
+			r.game = new Game(rows, cols);
+			for (int i = 0; i < nShips; i++)
+				r.game->addShip(lengths[i], symbols[i], shipNames[i]);
+			r.boards[0] = new Board(*r.game);
+			r.boards[1] = new Board(*r.game);
+			r.rules = rules;
+		}
+		for (int b = 0; b < 2; b++)
+		{
+			r.names[b] = getString();
+			r.boards[b]->clear();
+			for (int i = 0; i < nShips; i++)
+			{
+				int top = (signed char)getByte();
+				int left = (signed char)getByte();
+				Direction dir = Direction(getByte());
+				if (top >= 0)
+					r.boards[b]->placeShip(Point(top, left), i, dir);
+			}
+		}
+		r.text.clear();
+		r.open = true;
+		return;
+	}
+	if (!r.open)
+		return;
+
+	int seat = e.seat;
+	Board& target = *r.boards[1 - seat];
+	switch (e.kind)
+	{
+	case EVENT_TURN:
+		describeTurn(r.text, r.names[seat], r.names[1 - seat]);
+		target.render(false, r.text);
+		break;
+	case EVENT_SHOT:
+	{
+		ShotResult shot = { Point(e.r, e.c), (e.flags & SHOT_VALID) != 0, (e.flags & SHOT_HIT) != 0,
+			(e.flags & SHOT_DESTROYED) != 0, e.shipId };
+		if (shot.validShot) //the game's board took the shot, so this one does too
+		{
+			bool shotHit;
+			bool shipDestroyed;
+			int shipId;
+			target.attack(shot.p, shotHit, shipDestroyed, shipId);
+		}
+		describeShot(r.text, *r.game, r.names[seat], shot, (e.flags & SHOT_LATE) != 0,
+			(e.flags & SHOT_BOARD_FOLLOWS) != 0);
+		break;
+	}
+	case EVENT_BOARD:
+		target.render(false, r.text);
+		break;
+	case EVENT_TIMEOUT:
+	case EVENT_WON:
+		if (e.kind == EVENT_TIMEOUT)
+			r.text += timeoutMessage(r.names[seat], r.names[1 - seat]);
+		else
+		{
+			r.text += r.names[seat];
+			r.text += " wins!\n";
+		}
+		m_pending += r.text;
+		r.open = false;
+		break;
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef TRANSCRIPTLOG_INCLUDED
+#define TRANSCRIPTLOG_INCLUDED
+
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Game;
+class Board;
+class Player;
+struct ShotResult;
+struct TranscriptRing;
+
+// The transcript's wording, shared by Game's own transcript and the log
+void describeTurn(std::string& frame, const std::string& attacker, const std::string& defender);
+void describeShot(std::string& frame, const Game& g, const std::string& attacker, const ShotResult& shot,
+	bool late, bool boardFollows);
+std::string timeoutMessage(const std::string& attacker, const std::string& defender);
+
+// What a game thread does when its buffer is full because the log's thread
+// has fallen behind: wait for room, slowing the games to the speed of the
+// output, or leave the rest of that game out of the transcript
+enum LogOverflow {
+	LOG_WAIT, LOG_DROP
+};
+
+// Writes the transcripts of games played on many threads without making
+// them wait on the output.  Game threads describe each game as small binary
+// events in a ring buffer of their own, which only they write and only the
+// log's thread reads, so nothing is locked or allocated per turn.  The
+// log's thread replays the events on boards of its own, formats them in
+// the layout Game's own transcript has, and writes whole games, in the
+// order they end, to out in large chunks.  A game is written all or not at
+// all: with LOG_DROP, one that lost an event is left out and counted.
+class TranscriptLog
+{
+public:
+	TranscriptLog(std::ostream& out, LogOverflow overflow, int ringBytes = 1 << 20);
+	~TranscriptLog(); //calls close
+	// Called by Game::play on the thread playing the game; the players
+	// mustn't be human
+	void startGame(const Game& g, const Player* players[2], const Board* boards[2]);
+	void turn(int seat);
+	void shot(int seat, const ShotResult& shot, bool late, bool boardFollows);
+	void board(int seat);  //the board seat attacked, as it is now
+	void timedOut(int seat);
+	void won(int seat);
+	// Writes out everything the games have logged and stops the log's
+	// thread.  Call when no game is playing.
+	void close();
+	long long droppedGames() const { return m_droppedGames; }
+	// We prevent a TranscriptLog object from being copied or assigned
+	TranscriptLog(const TranscriptLog&) = delete;
+	TranscriptLog& operator=(const TranscriptLog&) = delete;
+
+private:
+	TranscriptRing& ring();  //the calling thread's
+	void post(int kind, int seat, const ShotResult* shot, int flags);
+	bool push(TranscriptRing& ring, const char* data, size_t size);
+	void run();  //the log's thread
+	void format(TranscriptRing& ring, const std::vector<char>& record);
+	std::ostream& m_out;
+	LogOverflow m_overflow;
+	int m_ringBytes;
+	unsigned long long m_serial;        //tells this log apart from any earlier one at the same address
+	std::mutex m_mutex;                 //guards m_rings
+	std::vector<TranscriptRing*> m_rings;
+	std::atomic<bool> m_stop;
+	std::atomic<long long> m_droppedGames;
+	std::string m_pending;              //finished games not yet written
+	std::thread m_thread;
+};
+
+#endif // TRANSCRIPTLOG_INCLUDED
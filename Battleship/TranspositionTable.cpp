@@ -0,0 +1,120 @@
+#include "TranspositionTable.h"
+#include "globals.h"
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// A slot's data packs the move (16 bits), a used flag (1 bit), depth (15 bits)
+// and value (32 bits); the flag keeps real data from ever being 0
+const unsigned int NOMOVE = 0xFFFF;
+const unsigned long long USED = 1ULL << 47;
+
+unsigned long long packEntry(const TTEntry& e)
+{
+	unsigned int move = (e.bestMove.r < 0 ? NOMOVE : e.bestMove.r * MAXCOLS + e.bestMove.c);
+	return (unsigned long long)(move & 0xFFFF) << 48 |
+		USED | (unsigned long long)(e.depth & 0x7FFF) << 32 |
+		(unsigned int)e.value;
+}
+
+TTEntry unpackEntry(unsigned long long data)
+{
+	TTEntry e;
+	unsigned int move = (unsigned int)(data >> 48);
+	e.bestMove = (move == NOMOVE ? Point(-1, -1) : Point(move / MAXCOLS, move % MAXCOLS));
+	e.depth = (int)((data >> 32) & 0x7FFF);
+	e.value = (int)(unsigned int)(data & 0xFFFFFFFF);
+	return e;
+}
+
+TranspositionTable::TranspositionTable(size_t bytes)
+	: m_probes(0), m_hits(0), m_stores(0), m_replacements(0)
+{
+	size_t n = 1;
+	while (n * 2 * sizeof(Slot) <= bytes) //largest power of two that fits
+		n *= 2;
+	m_slots = new Slot[n];
+	m_mask = n - 1;
+	clear();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	delete[] m_slots;
+}
+
+atomic<bool> sharedMade(false);
+
+TranspositionTable& TranspositionTable::shared()
+{
+	static TranspositionTable table(16 * 1024 * 1024);
+	sharedMade.store(true, memory_order_relaxed);
+	return table;
+}
+
+bool TranspositionTable::sharedInUse()
+{
+	return sharedMade.load(memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(unsigned long long key, TTEntry& entry) const
+{
+	m_probes.fetch_add(1, memory_order_relaxed);
+	const Slot& slot = m_slots[key & m_mask];
+	unsigned long long data = slot.data.load(memory_order_relaxed);
+	unsigned long long check = slot.check.load(memory_order_relaxed);
+	if ((check ^ data) != key || data == 0)
+		return false;
+	m_hits.fetch_add(1, memory_order_relaxed);
+	entry = unpackEntry(data);
+	return true;
+}
+
+void TranspositionTable::store(unsigned long long key, const TTEntry& entry)
+{
+	Slot& slot = m_slots[key & m_mask];
+	unsigned long long oldData = slot.data.load(memory_order_relaxed);
+	unsigned long long oldKey = slot.check.load(memory_order_relaxed) ^ oldData;
+	if (oldData != 0 && oldKey != key)
+	{
+		//keep a different position if more work went into it
+		if (unpackEntry(oldData).depth > entry.depth)
+			return;
+		m_replacements.fetch_add(1, memory_order_relaxed);
+	}
+	unsigned long long data = packEntry(entry);
+	slot.check.store(key ^ data, memory_order_relaxed);
+	slot.data.store(data, memory_order_relaxed);
+	m_stores.fetch_add(1, memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+	for (size_t i = 0; i <= m_mask; i++)
+	{
+		m_slots[i].check.store(0, memory_order_relaxed);
+		m_slots[i].data.store(0, memory_order_relaxed);
+	}
+	m_probes = m_hits = m_stores = m_replacements = 0;
+}
+
+TTStats TranspositionTable::stats() const
+{
+	TTStats s;
+	s.probes = m_probes.load(memory_order_relaxed);
+	s.hits = m_hits.load(memory_order_relaxed);
+	s.stores = m_stores.load(memory_order_relaxed);
+	s.replacements = m_replacements.load(memory_order_relaxed);
+	s.capacity = m_mask + 1;
+	s.bytes = s.capacity * sizeof(Slot);
+	return s;
+}
+
+string TTStats::summary() const
+{
+	ostringstream out;
+	out << "probes " << probes << "  hits " << hits << " (" << int(100 * hitRate() + 0.5) << "%)  stores "
+		<< stores << "  replacements " << replacements << "  " << bytes / (1024 * 1024) << " MB";
+	return out.str();
+}
@@ -0,0 +1,64 @@
+#ifndef TRANSPOSITIONTABLE_INCLUDED
+#define TRANSPOSITIONTABLE_INCLUDED
+
+#include "globals.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+// What a player wants to remember about a position.  bestMove is in the
+// frame of the hash that was used as the key, so a player keying on a
+// canonical hash stores applySymmetry(sym, move) and undoes it on probe.
+struct TTEntry
+{
+	Point bestMove;
+	int value;
+	int depth;  //how much work went into value; deeper entries are kept
+};
+
+struct TTStats
+{
+	unsigned long long probes;
+	unsigned long long hits;
+	unsigned long long stores;
+	unsigned long long replacements; //stores that evicted a different position
+	size_t bytes;
+	size_t capacity; //entries
+	double hitRate() const { return probes == 0 ? 0 : double(hits) / probes; }
+	std::string summary() const; //"probes ... hits ...% stores ... replacements ... MB"
+};
+
+// A fixed-size hash table of TTEntry values that any number of threads can
+// probe and store into without locks.  Each slot keeps its payload next to
+// the key xor the payload, so a slot torn by two simultaneous writers just
+// fails to match and reads as a miss.
+class TranspositionTable
+{
+public:
+	TranspositionTable(size_t bytes);
+	~TranspositionTable();
+	static TranspositionTable& shared(); //16 MB table for players that want to share
+	static bool sharedInUse();           //whether shared() has been called, so its stats mean something
+	bool probe(unsigned long long key, TTEntry& entry) const;
+	void store(unsigned long long key, const TTEntry& entry);
+	void clear();
+	TTStats stats() const;
+	// We prevent a TranspositionTable object from being copied or assigned
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+private:
+	struct Slot
+	{
+		std::atomic<unsigned long long> check; //key ^ data
+		std::atomic<unsigned long long> data;
+	};
+	Slot* m_slots;
+	size_t m_mask;
+	mutable std::atomic<unsigned long long> m_probes;
+	mutable std::atomic<unsigned long long> m_hits;
+	std::atomic<unsigned long long> m_stores;
+	std::atomic<unsigned long long> m_replacements;
+};
+
+#endif // TRANSPOSITIONTABLE_INCLUDED
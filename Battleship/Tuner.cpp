@@ -0,0 +1,121 @@
+#include "Tuner.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+TuningConfig::TuningConfig()
+	: rules(Ruleset::standard()), opponent("good"), nCandidates(32), firstRoundGames(200),
+	maxGames(6400), seed(1), nThreads(0)
+{}
+
+//******************** TuningCandidate functions **********************
+
+double TuningCandidate::winRate() const
+{
+	int played = result.games - result.noResult;
+	return played == 0 ? 0 : double(result.wins[0]) / played;
+}
+
+void TuningCandidate::interval(double& lo, double& hi) const
+{
+	wilsonInterval(result.wins[0], result.games - result.noResult, lo, hi);
+}
+
+//******************** Tuner functions ********************************
+
+Tuner::Tuner(const TuningConfig& config)
+	: m_config(config)
+{}
+
+void Tuner::drawCandidates(vector<TuningCandidate>& candidates) const
+{
+	//the candidates get a generator of their own, as the games reseed randInt
+	mt19937 rng(m_config.seed);
+	set<string> seen;
+	TuningCandidate c;
+	c.droppedInRound = -1;
+	candidates.push_back(c); //the defaults
+	seen.insert(c.params.str());
+	for (int tries = 0; candidates.size() < m_config.nCandidates && tries < 100 * m_config.nCandidates; tries++)
+	{
+		GoodParams& p = c.params;
+		shuffle(p.probe, p.probe + 4, rng);
+		p.followLine = (rng() & 1) != 0;
+		p.multiply = (rng() & 1) != 0;
+		p.randomPlacement = (rng() & 1) != 0;
+		if (seen.insert(p.str()).second)
+			candidates.push_back(c);
+	}
+}
+
+vector<TuningCandidate> Tuner::run(ostream& log)
+{
+	vector<TuningCandidate> candidates;
+	drawCandidates(candidates);
+
+	int played = 0;  //games 0 .. played-1 have been played by every candidate still running
+	int nRunning = candidates.size();
+	for (int round = 0, games = m_config.firstRoundGames; nRunning > 1 && played < m_config.maxGames; round++, games *= 2)
+	{
+		TournamentConfig config;
+		config.rules = m_config.rules;
+		config.type[1] = config.name[1] = m_config.opponent;
+		config.seed = m_config.seed;
+		config.nThreads = m_config.nThreads;
+		config.firstGame = played;
+		config.nGames = min(games, m_config.maxGames) - played;
+		double seconds = 0;
+		for (int i = 0; i < candidates.size(); i++)
+		{
+			if (candidates[i].droppedInRound >= 0)
+				continue;
+			config.type[0] = config.name[0] = "good:" + candidates[i].params.str();
+			Tournament t(config);
+			TournamentResult r = t.run();
+			candidates[i].result.merge(r);
+			seconds += r.seconds;
+		}
+		played += config.nGames;
+
+		//a candidate is clearly losing if even its best case is below the leader's worst
+		int leader = -1;
+		for (int i = 0; i < candidates.size(); i++)
+			if (candidates[i].droppedInRound < 0 && (leader < 0 || candidates[i].winRate() > candidates[leader].winRate()))
+				leader = i;
+		double leaderLo;
+		double leaderHi;
+		candidates[leader].interval(leaderLo, leaderHi);
+		int dropped = 0;
+		for (int i = 0; i < candidates.size(); i++)
+		{
+			double lo;
+			double hi;
+			candidates[i].interval(lo, hi);
+			if (candidates[i].droppedInRound < 0 && hi < leaderLo)
+			{
+				candidates[i].droppedInRound = round;
+				dropped++;
+			}
+		}
+		ostringstream line;
+		line << "round " << round + 1 << ": " << nRunning << " candidates played " << played << " games each in "
+			<< formatSeconds(seconds) << "; " << dropped << " dropped; leader wins " << fixed << setprecision(1)
+			<< 100 * candidates[leader].winRate() << "% (" << 100 * leaderLo << "-" << 100 * leaderHi << "%)";
+		log << line.str() << endl;
+		nRunning -= dropped;
+	}
+
+	//those still running first, then the ones that lasted longest
+	stable_sort(candidates.begin(), candidates.end(), [](const TuningCandidate& a, const TuningCandidate& b) {
+		int ra = (a.droppedInRound < 0 ? 1 << 30 : a.droppedInRound);
+		int rb = (b.droppedInRound < 0 ? 1 << 30 : b.droppedInRound);
+		return ra != rb ? ra > rb : a.winRate() > b.winRate();
+	});
+	return candidates;
+}
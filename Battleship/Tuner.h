@@ -0,0 +1,53 @@
+#ifndef TUNER_INCLUDED
+#define TUNER_INCLUDED
+
+#include "PlayerState.h"
+#include "Ruleset.h"
+#include "Tournament.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct TuningConfig
+{
+	TuningConfig();
+	Ruleset rules;
+	std::string opponent;  //createPlayer type every candidate plays against
+	int nCandidates;       //parameter sets tried, the defaults among them
+	int firstRoundGames;   //games each candidate plays in the first round
+	int maxGames;          //the rounds double the games until a candidate has played this many
+	unsigned int seed;     //for the games and for drawing candidates
+	int nThreads;          //0 means one per core
+};
+
+struct TuningCandidate
+{
+	GoodParams params;
+	TournamentResult result;  //entrant 0 is the candidate
+	int droppedInRound;       //-1 while it is still in the running
+	double winRate() const;
+	void interval(double& lo, double& hi) const; //95% interval for the win rate
+};
+
+// Searches GoodParams for the set that beats an opponent most often, by
+// racing: every candidate in the running plays the same numbered games in
+// each round, so they all see the same layouts and luck, and a candidate
+// whose win rate is clearly below the leader's is dropped.  Each round's
+// games are played by a Tournament on every core.  The space is small, so
+// candidates are drawn at random without repeats.
+class Tuner
+{
+public:
+	Tuner(const TuningConfig& config);
+	// Reports each round to log; returns every candidate, best first
+	std::vector<TuningCandidate> run(std::ostream& log);
+	// We prevent a Tuner object from being copied or assigned
+	Tuner(const Tuner&) = delete;
+	Tuner& operator=(const Tuner&) = delete;
+
+private:
+	void drawCandidates(std::vector<TuningCandidate>& candidates) const;
+	TuningConfig m_config;
+};
+
+#endif // TUNER_INCLUDED
@@ -0,0 +1,109 @@
+#include "Zobrist.h"
+#include "globals.h"
+
+using namespace std;
+
+const int MAXSHIPKEYS = 64;
+
+// The keys are fixed rather than drawn from randInt so that hashes mean the
+// same thing in every run and every process.
+struct ZobristKeys
+{
+	ZobristKeys();
+	unsigned long long cell[MAXROWS][MAXCOLS][4];
+	unsigned long long ship[MAXSHIPKEYS];
+};
+
+ZobristKeys::ZobristKeys()
+{
+	unsigned long long x = 0x9E3779B97F4A7C15ULL;
+	for (int r = 0; r < MAXROWS; r++)
+	{
+		for (int c = 0; c < MAXCOLS; c++)
+		{
+			cell[r][c][UNSHOT] = 0; //an unshot cell contributes nothing
+			for (int s = MISSED; s <= SUNK; s++)
+				cell[r][c][s] = splitMix64(x);
+		}
+	}
+	for (int i = 0; i < MAXSHIPKEYS; i++)
+		ship[i] = splitMix64(x);
+}
+
+const ZobristKeys& keys()
+{
+	static const ZobristKeys k;
+	return k;
+}
+
+int nSymmetries(int rows, int cols)
+{
+	return rows == cols ? 8 : 4;
+}
+
+Point applySymmetry(int sym, Point p, int rows, int cols)
+{
+	switch (sym)
+	{
+	case 0:  return p;
+	case 1:  return Point(p.r, cols - 1 - p.c);             //mirror left-right
+	case 2:  return Point(rows - 1 - p.r, p.c);             //mirror top-bottom
+	case 3:  return Point(rows - 1 - p.r, cols - 1 - p.c);  //rotate 180
+	case 4:  return Point(p.c, p.r);                        //transpose (square only from here on)
+	case 5:  return Point(p.c, rows - 1 - p.r);             //rotate 90 one way
+	case 6:  return Point(cols - 1 - p.c, p.r);             //rotate 90 the other way
+	default: return Point(cols - 1 - p.c, rows - 1 - p.r);  //anti-transpose
+	}
+}
+
+Point undoSymmetry(int sym, Point p, int rows, int cols)
+{
+	//every symmetry is its own inverse except the two quarter turns
+	if (sym == 5)
+		return applySymmetry(6, p, rows, cols);
+	if (sym == 6)
+		return applySymmetry(5, p, rows, cols);
+	return applySymmetry(sym, p, rows, cols);
+}
+
+//******************** ShotHash functions *****************************
+
+ShotHash::ShotHash(int rows, int cols)
+	: m_rows(rows), m_cols(cols), m_nSyms(nSymmetries(rows, cols))
+{
+	clear();
+}
+
+void ShotHash::clear()
+{
+	for (int s = 0; s < 8; s++)
+		m_hash[s] = 0;
+}
+
+void ShotHash::setCell(Point p, CellState oldState, CellState newState)
+{
+	const ZobristKeys& k = keys();
+	for (int s = 0; s < m_nSyms; s++)
+	{
+		Point q = applySymmetry(s, p, m_rows, m_cols);
+		m_hash[s] ^= k.cell[q.r][q.c][oldState] ^ k.cell[q.r][q.c][newState];
+	}
+}
+
+void ShotHash::setShipSunk(int shipId)
+{
+	unsigned long long key = keys().ship[shipId % MAXSHIPKEYS];
+	for (int s = 0; s < m_nSyms; s++)
+		m_hash[s] ^= key;
+}
+
+int ShotHash::canonicalSymmetry() const
+{
+	int best = 0;
+	for (int s = 1; s < m_nSyms; s++)
+	{
+		if (m_hash[s] < m_hash[best])
+			best = s;
+	}
+	return best;
+}
@@ -0,0 +1,39 @@
+#ifndef ZOBRIST_INCLUDED
+#define ZOBRIST_INCLUDED
+
+#include "globals.h"
+
+// What a shooter knows about a cell
+enum CellState {
+	UNSHOT, MISSED, HIT, SUNK
+};
+
+// A square board has 8 symmetries (rotations and reflections), any other
+// board has 4.  Symmetry 0 is the identity.
+int nSymmetries(int rows, int cols);
+Point applySymmetry(int sym, Point p, int rows, int cols);
+Point undoSymmetry(int sym, Point p, int rows, int cols);
+
+// Zobrist hash of the shot/hit/sunk state of a board and of which ships
+// have been sunk.  The hash is kept for every symmetric image of the board
+// at once, so a symmetry-independent canonical hash costs no more than a
+// minimum over a handful of numbers.
+class ShotHash
+{
+public:
+	ShotHash(int rows, int cols);
+	void clear();
+	void setCell(Point p, CellState oldState, CellState newState);
+	void setShipSunk(int shipId); //toggles; call once per sunk ship
+	unsigned long long hash() const { return m_hash[0]; }
+	unsigned long long canonicalHash() const { return m_hash[canonicalSymmetry()]; }
+	int canonicalSymmetry() const; //the symmetry whose image has the smallest hash
+
+private:
+	int m_rows;
+	int m_cols;
+	int m_nSyms;
+	unsigned long long m_hash[8];
+};
+
+#endif // ZOBRIST_INCLUDED
@@ -19,13 +19,45 @@ public:
 	int c;
 };
 
+// What became of one shot of a salvo
+struct ShotResult
+{
+	Point p;
+	bool validShot;
+	bool shotHit;
+	bool shipDestroyed;
+	int shipId;  //the ship destroyed, -1 if none
+};
+
+// Each thread has its own generator, so players in different threads
+// neither race nor disturb one another's sequences
+inline std::mt19937& randomGenerator()
+{
+	thread_local std::mt19937 generator(std::random_device{}());
+	return generator;
+}
+
+// Restart the calling thread's random sequence, e.g. to replay a game
+inline void seedRandom(unsigned int seed)
+{
+	randomGenerator().seed(seed);
+}
+
 // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-	static std::random_device rd;
-	static std::mt19937 generator(rd());
 	std::uniform_int_distribution<> distro(0, limit - 1);
-	return distro(generator);
+	return distro(randomGenerator());
+}
+
+// Advance state and return the next number of the SplitMix64 sequence;
+// handy for fixed tables of well-mixed 64-bit values
+inline unsigned long long splitMix64(unsigned long long& state)
+{
+	unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
 }
 
 #endif // GLOBALS_INCLUDED
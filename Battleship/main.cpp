@@ -1,7 +1,34 @@
 #include "Game.h"
 #include "Player.h"
+#include "ShotStore.h"
+#include "LayoutStore.h"
+#include "Tournament.h"
+#include "Dashboard.h"
+#include "Coordinator.h"
+#include "Lockstep.h"
+#include "ResultsFile.h"
+#include "Tuner.h"
+#include "EndgameTable.h"
+#include "AllocationCounter.h"
+#include "Analysis.h"
+#include "Sweep.h"
+#include "Differential.h"
+#include "Corpus.h"
+#include "Board.h"
+#include "LayoutCounter.h"
+#include "PlayerState.h"
+#include "Timing.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 
 using namespace std;
 
@@ -14,10 +41,869 @@ bool addStandardShips(Game& g)
 		g.addShip(2, 'P', "patrol boat");
 }
 
-int main()
+// Opens the ShotStore and LayoutStore in the files named by --shot-store
+// and --layout-store options, so that the games record opponents' shots and
+// layouts there and adaptive players learn from them; batch runs use no
+// store unless given one.  False if one can't be opened.
+bool openStores(const string& shotStore, const string& layoutStore)
+{
+	if (!shotStore.empty() && !ShotStore::instance().open(shotStore))
+	{
+		cout << "Could not open " << shotStore << " as a shot store." << endl;
+		return false;
+	}
+	if (!layoutStore.empty() && !LayoutStore::instance().open(layoutStore))
+	{
+		cout << "Could not open " << layoutStore << " as a layout store." << endl;
+		return false;
+	}
+	return true;
+}
+
+// Battleship match <type1> <type2> [games] [--threads n] [--seed n]
+//                  [--move-ms n] [--game-ms n] [--shot-store file] [--layout-store file]
+int runMatch(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		cout << "usage: " << argv[0] << " match <type1> <type2> [games] [--threads n] [--seed n]"
+			<< " [--move-ms n] [--game-ms n] [--watch] [--dashboard file] [--processes n] [--salvo]"
+			<< " [--checkpoint file] [--checkpoint-sec n] [--resume] [--lockstep] [--results file]"
+			<< " [--transcript file] [--transcript-drop] [--shot-store file] [--layout-store file]" << endl;
+		return 1;
+	}
+	TournamentConfig config;
+	config.type[0] = config.name[0] = argv[2];
+	config.type[1] = config.name[1] = argv[3];
+	config.nGames = 100;
+	int nProcesses = 0;  //0 plays every game in this process
+	bool lockstep = false;
+	string shotStore;
+	string layoutStore;
+	for (int i = 4; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			config.nThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			config.seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--move-ms") == 0 && i + 1 < argc)
+			config.msPerMove = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--game-ms") == 0 && i + 1 < argc)
+			config.msPerGame = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc)
+			nProcesses = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--dashboard") == 0 && i + 1 < argc)
+			config.dashboard = argv[++i];
+		else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+			config.checkpoint = argv[++i];
+		else if (strcmp(argv[i], "--checkpoint-sec") == 0 && i + 1 < argc)
+			config.checkpointSeconds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--salvo") == 0)
+			config.salvo = true;
+		else if (strcmp(argv[i], "--resume") == 0)
+			config.resume = true;
+		else if (strcmp(argv[i], "--watch") == 0)
+			config.watch = true;
+		else if (strcmp(argv[i], "--results") == 0 && i + 1 < argc)
+			config.results = argv[++i];
+		else if (strcmp(argv[i], "--lockstep") == 0)
+			lockstep = true;
+		else if (strcmp(argv[i], "--transcript") == 0 && i + 1 < argc)
+			config.transcript = argv[++i];
+		else if (strcmp(argv[i], "--transcript-drop") == 0)
+			config.dropTranscript = true;
+		else if (strcmp(argv[i], "--shot-store") == 0 && i + 1 < argc)
+			shotStore = argv[++i];
+		else if (strcmp(argv[i], "--layout-store") == 0 && i + 1 < argc)
+			layoutStore = argv[++i];
+		else if (argv[i][0] != '-')
+			config.nGames = atoi(argv[i]);
+		else
+		{
+			cout << "Unknown option " << argv[i] << endl;
+			return 1;
+		}
+	}
+
+	if (config.resume && config.checkpoint.empty())
+		config.checkpoint = "match.checkpoint";
+	if (nProcesses > 0 && !config.checkpoint.empty())
+	{
+		cout << "Checkpoints are only kept for matches played in one process." << endl;
+		return 1;
+	}
+	if (nProcesses > 0 && (config.watch || !config.dashboard.empty()))
+	{
+		cout << "Games played in worker processes can't be watched or shown on a dashboard." << endl;
+		return 1;
+	}
+	if (nProcesses > 0 && !config.results.empty())
+	{
+		cout << "Results files are only written for matches played in one process." << endl;
+		return 1;
+	}
+	if ((nProcesses > 0 || lockstep) && !config.transcript.empty())
+	{
+		cout << "Transcripts are only written for matches played in one process without --lockstep." << endl;
+		return 1;
+	}
+	if (lockstep && (!LockstepEngine::supports(config) || nProcesses > 0 || config.watch ||
+		!config.dashboard.empty() || !config.checkpoint.empty()))
+	{
+		cout << "--lockstep plays only awful, random and parity players, one shot a turn with no time limits,"
+			<< " in this process and without watching, dashboards or checkpoints." << endl;
+		return 1;
+	}
+	if (!openStores(shotStore, layoutStore))
+		return 1;
+	TournamentResult result;
+	if (lockstep)
+	{
+		LockstepEngine engine(config);
+		result = engine.run();
+	}
+	else if (nProcesses > 0)
+	{
+		Coordinator coordinator(config, nProcesses, argv[0]);
+		result = coordinator.run();
+		if (coordinator.restarts() > 0)
+			cout << coordinator.restarts() << " worker processes had to be restarted." << endl;
+	}
+	else
+	{
+		Tournament t(config);
+		result = t.run();
+	}
+	cout << config.type[0] << " won " << result.wins[0] << ", " << config.type[1] << " won "
+		<< result.wins[1] << " out of " << result.games << " games";
+	if (result.noResult > 0)
+		cout << " (" << result.noResult << " not played)";
+	cout << " in " << formatSeconds(result.seconds) << " ("
+		<< (result.seconds > 0 ? result.games / result.seconds : 0) << " games/sec)." << endl;
+	for (int i = 0; i < 2 && !lockstep; i++) //the lockstep engine doesn't time moves
+	{
+		cout << config.type[i] << " move latency: " << result.moveLatency[i].summary();
+		if (result.lateMoves[i] > 0 || result.timeouts[i] > 0)
+			cout << "  late moves " << result.lateMoves[i] << "  games lost on time " << result.timeouts[i];
+		cout << endl;
+	}
+	if (TranspositionTable::sharedInUse()) //only players in this process use it, so not with --processes
+		cout << "transposition table: " << TranspositionTable::shared().stats().summary() << endl;
+	cout << result.stats.report(config.name, config.rules);
+	return 0;
+}
+
+int runViewer(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cout << "usage: " << argv[0] << " view <dashboard file> [refresh ms]" << endl;
+		return 1;
+	}
+	int refreshMs = (argc > 3 ? atoi(argv[3]) : 500);
+	if (!viewDashboard(argv[2], refreshMs > 0 ? refreshMs : 500, cout))
+	{
+		cout << "No tournament dashboard in " << argv[2] << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Battleship csv <results file> <csv file>
+// converts a results file written by match --results
+int runCsvExport(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		cout << "usage: " << argv[0] << " csv <results file> <csv file>" << endl;
+		return 1;
+	}
+	ofstream out(argv[3]);
+	if (!out)
+	{
+		cout << "Could not create " << argv[3] << endl;
+		return 1;
+	}
+	if (!exportResultsCsv(argv[2], out))
+	{
+		cout << argv[2] << " is not a complete results file." << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Battleship tune [--opponent type] [--candidates n] [--games n] [--max-games n]
+//                 [--seed n] [--threads n] [--shot-store file] [--layout-store file]
+// races GoodParams candidates against an opponent and reports the best
+int runTune(int argc, char* argv[])
+{
+	TuningConfig config;
+	string shotStore;
+	string layoutStore;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--opponent") == 0 && i + 1 < argc)
+			config.opponent = argv[++i];
+		else if (strcmp(argv[i], "--candidates") == 0 && i + 1 < argc)
+			config.nCandidates = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+			config.firstRoundGames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--max-games") == 0 && i + 1 < argc)
+			config.maxGames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			config.seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			config.nThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--shot-store") == 0 && i + 1 < argc)
+			shotStore = argv[++i];
+		else if (strcmp(argv[i], "--layout-store") == 0 && i + 1 < argc)
+			layoutStore = argv[++i];
+		else
+		{
+			cout << "usage: " << argv[0] << " tune [--opponent type] [--candidates n] [--games n]"
+				<< " [--max-games n] [--seed n] [--threads n] [--shot-store file] [--layout-store file]" << endl;
+			return 1;
+		}
+	}
+	Game g(config.rules.rows, config.rules.cols);
+	config.rules.addShipsTo(g);
+	Player* opponent = createPlayer(config.opponent, config.opponent, g);
+	delete opponent;
+	if (opponent == nullptr || config.opponent == "human" || config.firstRoundGames <= 0)
+	{
+		cout << "The opponent must be a computer player, and the first round must have games." << endl;
+		return 1;
+	}
+	if (!openStores(shotStore, layoutStore))
+		return 1;
+
+	Tuner tuner(config);
+	vector<TuningCandidate> best = tuner.run(cout);
+	cout << "Best parameter sets against " << config.opponent << ":" << endl;
+	for (int i = 0; i < best.size() && i < 5; i++)
+	{
+		double lo;
+		double hi;
+		best[i].interval(lo, hi);
+		cout << "  " << fixed << setprecision(1) << 100 * best[i].winRate() << "% (95% CI " << 100 * lo << "-"
+			<< 100 * hi << "%) in " << best[i].result.games << " games: " << best[i].params.str()
+			<< (best[i].params.str() == GoodParams().str() ? " (defaults)" : "") << endl;
+	}
+	return 0;
+}
+
+// Battleship sweep <config file> [--threads n] [--shot-store file] [--layout-store file]
+// plays every pair of players under every ruleset in the file (see
+// SweepConfig) and shows each pairing's win rate and cost per ruleset
+int runSweep(int argc, char* argv[])
+{
+	SweepConfig config;
+	string shotStore;
+	string layoutStore;
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			config.nThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--shot-store") == 0 && i + 1 < argc)
+			shotStore = argv[++i];
+		else if (strcmp(argv[i], "--layout-store") == 0 && i + 1 < argc)
+			layoutStore = argv[++i];
+		else
+			argc = 0;
+	}
+	if (argc < 3)
+	{
+		cout << "usage: " << argv[0] << " sweep <config file> [--threads n] [--shot-store file]"
+			<< " [--layout-store file]" << endl;
+		return 1;
+	}
+	string error;
+	if (!config.read(argv[2], error))
+	{
+		cout << error << endl;
+		return 1;
+	}
+	if (!openStores(shotStore, layoutStore))
+		return 1;
+
+	Sweep sweep(config);
+	vector<SweepEntry> entries = sweep.run();
+	for (int i = 0; i < config.rulesets.size(); i++)
+		cout << "R" << i + 1 << ": " << config.rulesets[i].str() << endl;
+	int nPairs = entries.size() / config.rulesets.size();
+	size_t width = 0;
+	for (int j = 0; j < nPairs; j++)
+		width = max(width, config.types[entries[j].type[0]].size() + config.types[entries[j].type[1]].size() + 4);
+	for (int table = 0; table < 2; table++)
+	{
+		cout << endl << (table == 0 ? "Games won by the first player (%), " : "Milliseconds per game on one thread, ")
+			<< config.nGames << " games per pairing:" << endl;
+		cout << setw(width) << "";
+		for (int i = 0; i < config.rulesets.size(); i++)
+			cout << setw(9) << "R" + to_string(i + 1);
+		cout << endl;
+		for (int j = 0; j < nPairs; j++)
+		{
+			cout << left << setw(width) << config.types[entries[j].type[0]] + " vs " + config.types[entries[j].type[1]] << right;
+			for (int i = 0; i < config.rulesets.size(); i++)
+			{
+				const SweepEntry& e = entries[i * nPairs + j];
+				int played = e.result.games - e.result.noResult;
+				double value = (table == 0 ? (played == 0 ? 0 : 100.0 * e.result.wins[0] / played) :
+					1000 * e.seconds / max(1, e.result.games));
+				ostringstream cell;
+				cell << fixed << setprecision(table == 0 ? 1 : 3) << value;
+				cout << setw(9) << cell.str();
+			}
+			cout << endl;
+		}
+	}
+	return 0;
+}
+
+// Battleship diff [cases] [--seed n] [--min-length n]
+// checks addShip, Board and GoodPlayer against the reference implementations;
+// GoodPlayer's games use ships of at least min-length (default 1) cells, and
+// its endgame lookups if endgame.dat has been built
+int runDifferential(int argc, char* argv[])
+{
+	int nCases = 1000;
+	unsigned int seed = 1;
+	int minLength = 1;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--min-length") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 1)
+			minLength = atoi(argv[++i]);
+		else if (isdigit(argv[i][0]))
+			nCases = atoi(argv[i]);
+		else
+		{
+			cout << "usage: " << argv[0] << " diff [cases] [--seed n] [--min-length n]" << endl;
+			return 1;
+		}
+	}
+	DifferentialTester tester(seed);
+	int failed[3];
+	failed[0] = tester.checkAddShip(nCases, cout);
+	failed[1] = tester.checkBoards(nCases, cout);
+	failed[2] = tester.checkGoodPlayer(max(1, nCases / 10), minLength, cout);
+	const char* what[3] = { "addShip sequences", "Board operation sequences",
+		EndgameTable::instance().isOpen() ? "GoodPlayer games, with the endgame tables" :
+		"GoodPlayer games, without endgame tables" };
+	int nFailed = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		cout << (i == 2 ? max(1, nCases / 10) : nCases) << " " << what[i] << ": " << failed[i] << " mismatched" << endl;
+		nFailed += failed[i];
+	}
+	return nFailed == 0 ? 0 : 1;
+}
+
+// Battleship layouts [--threads n] [--score games] [--from shots] [--seed n]
+// counts every layout of the standard fleet, or with --score compares
+// GoodPlayer's shots with exact counts in games against random layouts
+int runLayouts(int argc, char* argv[])
+{
+	int nThreads = 0;
+	int nGames = 0;
+	int from = 40;  //earlier positions have too many layouts to count quickly
+	unsigned int seed = 1;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			nThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--score") == 0 && i + 1 < argc)
+			nGames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+			from = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else
+		{
+			cout << "usage: " << argv[0] << " layouts [--threads n] [--score games] [--from shots] [--seed n]" << endl;
+			return 1;
+		}
+	}
+	Game g(10, 10);
+	addStandardShips(g);
+	LayoutCounter counter(g, nThreads);
+	if (nGames <= 0)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		unsigned long long n = counter.count(FleetObservations(g.nShips()));
+		cout << n << " layouts of the standard fleet, counted in " << formatSeconds(secondsSince(start)) << "." << endl;
+		return 0;
+	}
+
+	int positions = 0;
+	int bestShots = 0;        //positions where GoodPlayer fired at a most likely cell
+	double chance = 0;        //sums over positions of the chance that the shot hits
+	double bestChance = 0;
+	double seconds = 0;
+	for (int k = 0; k < nGames; k++)
+	{
+		seedRandom(seed + k);
+		Board b(g);
+		Player* placer = createPlayer("mediocre", "placer", g);
+		bool placed = placer->placeShips(b);
+		delete placer;
+		if (!placed)
+			continue;
+		GoodParams params;
+		GoodState good;
+		good.start(g);
+		FleetObservations seen(g.nShips());
+		for (int shots = 0; !b.allShipsDestroyed(); shots++)
+		{
+			LayoutCount exact;
+			if (shots >= from)
+			{
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				counter.count(seen, exact);
+				seconds += secondsSince(start);
+			}
+			Point p = good.recommendAttack(g, params);
+			if (shots >= from && exact.layouts > 0)
+			{
+				double most = 0;
+				for (int r = 0; r < g.rows(); r++)
+					for (int c = 0; c < g.cols(); c++)
+						if (!seen.hit.test(Point(r, c)))
+							most = max(most, exact.probability(Point(r, c)));
+				positions++;
+				chance += exact.probability(p);
+				bestChance += most;
+				if (exact.probability(p) == most)
+					bestShots++;
+			}
+			bool shotHit = false;
+			bool shipDestroyed = false;
+			int shipId = -1;
+			bool validShot = b.attack(p, shotHit, shipDestroyed, shipId);
+			good.recordAttackResult(g, p, validShot, shotHit, shipDestroyed, shipId);
+			if (validShot)
+				seen.record(p, shotHit, shipDestroyed, shipId);
+		}
+	}
+	if (positions == 0)
+	{
+		cout << "No positions were scored." << endl;
+		return 0;
+	}
+	cout << positions << " positions from shot " << from << " on, counted in "
+		<< formatSeconds(seconds / positions) << " each on average." << endl;
+	cout << "GoodPlayer fired at a most likely cell " << 100.0 * bestShots / positions << "% of the time." << endl;
+	cout << "Its shots hit " << 100 * chance / positions << "% of the time; the best shots would hit "
+		<< 100 * bestChance / positions << "%." << endl;
+	return 0;
+}
+
+// Battleship analyze [type] [--threads n] [--seed n] [--binary] [--batch n]
+// reads positions from stdin and writes, for each, where a player of the
+// type would fire and GoodPlayer's heatmap
+int runAnalyze(int argc, char* argv[])
+{
+	string type = "good";
+	int nThreads = 0;
+	unsigned int seed = 1;
+	bool binary = false;
+	int batchSize = 1024;  //positions read before they are shared out among the threads
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			nThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+			batchSize = max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--binary") == 0)
+			binary = true;
+		else if (argv[i][0] != '-')
+			type = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " analyze [type] [--threads n] [--seed n] [--binary] [--batch n]" << endl;
+			return 1;
+		}
+	}
+	PositionAnalyzer analyzer(type, nThreads, seed);
+	if (!analyzer.canAnalyze())
+	{
+		cout << "Positions can't be analyzed with a " << type << " player." << endl;
+		return 1;
+	}
+
+	vector<Position> positions;
+	vector<Analysis> results;
+	string error;
+	int n = 0;
+	for (bool more = true; more; )
+	{
+		positions.resize(batchSize);
+		int k;
+		for (k = 0; k < batchSize; k++)
+		{
+			bool read = (binary ? readBinaryPosition(cin, positions[k], error) : readPosition(cin, positions[k], error));
+			if (!read)
+				break;
+		}
+		more = (k == batchSize);
+		positions.resize(k);
+		analyzer.analyze(positions, results);
+		for (int i = 0; i < k; i++, n++)
+		{
+			const Ruleset& rules = positions[i].rules;
+			if (!results[i].valid)
+			{
+				cout << "position " << n << ": the ships don't fit the board" << endl;
+				continue;
+			}
+			cout << "position " << n << ": " << type << " fires at " << results[i].shot.r << " " << results[i].shot.c << endl;
+			for (int r = 0; r < rules.rows; r++)
+			{
+				for (int c = 0; c < rules.cols; c++)
+					cout << (c > 0 ? " " : "") << results[i].density[r][c];
+				cout << endl;
+			}
+		}
+	}
+	if (!error.empty())
+	{
+		cout << "position " << n << ": " << error << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Battleship corpus <file> [type ...] [--games n] [--per-game n] [--seed n] [--rules spec]
+// plays games between the players, each against the next in turn, and
+// writes the positions sampled from them to file for bench
+int runCorpus(int argc, char* argv[])
+{
+	string path;
+	vector<string> types;
+	int nGames = 100;
+	int perGame = 10;
+	unsigned int seed = 1;
+	Ruleset rules = Ruleset::standard();
+	string error;
+	bool usage = false;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+			nGames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--per-game") == 0 && i + 1 < argc)
+			perGame = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc)
+		{
+			if (!rules.parse(argv[++i], error))
+			{
+				cout << error << endl;
+				return 1;
+			}
+		}
+		else if (argv[i][0] != '-' && path.empty())
+			path = argv[i];
+		else if (argv[i][0] != '-')
+			types.push_back(argv[i]);
+		else
+			usage = true;
+	}
+	if (usage || path.empty())
+	{
+		cout << "usage: " << argv[0] << " corpus <file> [type ...] [--games n] [--per-game n] [--seed n] [--rules spec]" << endl;
+		return 1;
+	}
+	if (types.empty())
+	{
+		types.push_back("mediocre");
+		types.push_back("good");
+		types.push_back("parity");
+	}
+
+	vector<RecordedGame> corpus;
+	if (!recordCorpus(types, rules, nGames, perGame, seed, corpus, error))
+	{
+		cout << error << endl;
+		return 1;
+	}
+	ofstream out(path);
+	int nPositions = 0;
+	for (int i = 0; i < corpus.size(); i++)
+	{
+		writeRecordedGame(out, corpus[i]);
+		nPositions += corpus[i].samples.size();
+	}
+	if (!out)
+	{
+		cout << "Could not write " << path << endl;
+		return 1;
+	}
+	cout << "Wrote " << nPositions << " positions, from both sides of " << nGames << " games, to " << path << "." << endl;
+	return 0;
+}
+
+// p50, p99 and max, with the baseline's p99 after it if there is one
+string latencyColumns(const LatencyHistogram& h, const LatencyHistogram* baseline)
+{
+	string s = "p50 " + formatSeconds(h.percentile(50)) + "  p99 " + formatSeconds(h.percentile(99));
+	if (baseline != nullptr && baseline->count() > 0)
+		s += " (was " + formatSeconds(baseline->percentile(99)) + ")";
+	return s + "  max " + formatSeconds(h.max());
+}
+
+// Battleship bench <corpus file> [type ...] [--repeat n] [--seed n] [--save file] [--baseline file]
+// times each strategy's recommendAttack and recordAttackResult on every
+// position of a corpus written by corpus, for each phase of the game
+int runBench(int argc, char* argv[])
+{
+	string path;
+	vector<string> types;
+	int repeat = 1;
+	unsigned int seed = 1;
+	string savePath;
+	string baselinePath;
+	bool usage = false;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+			savePath = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			baselinePath = argv[++i];
+		else if (argv[i][0] != '-' && path.empty())
+			path = argv[i];
+		else if (argv[i][0] != '-')
+			types.push_back(argv[i]);
+		else
+			usage = true;
+	}
+	if (usage || path.empty())
+	{
+		cout << "usage: " << argv[0] << " bench <corpus file> [type ...] [--repeat n] [--seed n]"
+			<< " [--save file] [--baseline file]" << endl;
+		return 1;
+	}
+	if (types.empty())
+	{
+		const char* defaults[] = { "awful", "mediocre", "good", "adaptive", "random", "parity" };
+		types.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+	}
+
+	ifstream in(path);
+	if (!in)
+	{
+		cout << "Could not open " << path << endl;
+		return 1;
+	}
+	vector<RecordedGame> corpus;
+	RecordedGame game;
+	string error;
+	while (readRecordedGame(in, game, error))
+		corpus.push_back(game);
+	if (!error.empty())
+	{
+		cout << path << ", game " << corpus.size() << ": " << error << endl;
+		return 1;
+	}
+	vector<StrategyLatency> baseline;
+	if (!baselinePath.empty())
+	{
+		ifstream baselineIn(baselinePath);
+		if (!baselineIn || !loadLatencies(baselineIn, baseline))
+		{
+			cout << "Could not read the latencies in " << baselinePath << endl;
+			return 1;
+		}
+	}
+
+	CorpusBenchmark bench(corpus, seed);
+	cout << bench.nPositions() << " positions from " << corpus.size() << " recorded games:";
+	for (int ph = 0; ph < NPHASES; ph++)
+		cout << (ph > 0 ? "," : "") << " " << phaseName(ph) << " " << bench.nPositions(ph);
+	cout << endl;
+	vector<StrategyLatency> latencies(types.size());
+	for (int i = 0; i < types.size(); i++)
+	{
+		if (!bench.canBenchmark(types[i]))
+		{
+			cout << types[i] << " can't be benchmarked on positions." << endl;
+			return 1;
+		}
+		bench.run(types[i], repeat, latencies[i]);
+		const StrategyLatency* before = nullptr;
+		for (int j = 0; j < baseline.size(); j++)
+			if (baseline[j].type == types[i])
+				before = &baseline[j];
+		cout << types[i] << endl;
+		for (int ph = 0; ph < NPHASES; ph++)
+		{
+			if (latencies[i].recommend[ph].count() == 0)
+				continue;
+			cout << "  " << left << setw(8) << phaseName(ph) << right
+				<< " recommendAttack " << latencyColumns(latencies[i].recommend[ph], before ? &before->recommend[ph] : nullptr)
+				<< "   recordAttackResult " << latencyColumns(latencies[i].record[ph], before ? &before->record[ph] : nullptr)
+				<< endl;
+		}
+	}
+	if (!savePath.empty())
+	{
+		ofstream out(savePath);
+		saveLatencies(out, latencies);
+		if (!out)
+		{
+			cout << "Could not write " << savePath << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Counts the allocations made during each turn but a game's first
+class AllocationWatcher : public GameObserver
+{
+public:
+	AllocationWatcher() : turns(0), allocatingTurns(0), allocations(0), m_last(0) {}
+	virtual void turnPlayed(const Player& /* p1 */, const Board& /* b1 */, const Player& /* p2 */,
+		const Board& /* b2 */, int turn, bool /* gameOver */)
+	{
+		unsigned long long now = allocationCount();
+		if (turn > 1)
+		{
+			turns++;
+			if (now != m_last)
+				allocatingTurns++;
+			allocations += now - m_last;
+		}
+		m_last = now;
+	}
+	long long turns;
+	long long allocatingTurns;
+	unsigned long long allocations;
+private:
+	unsigned long long m_last;
+};
+
+// Battleship allocs [games]
+// plays the built-in players against themselves, with and without a text
+// transcript and in the salvo variant, and fails if any turn but a game's
+// first allocates.  Needs a build with COUNT_ALLOCATIONS defined.
+int runAllocationCheck(int argc, char* argv[])
+{
+	if (!countingAllocations())
+	{
+		cout << "This build doesn't count allocations; build it with COUNT_ALLOCATIONS defined." << endl;
+		return 1;
+	}
+	int nGames = (argc > 2 ? atoi(argv[2]) : 20);
+	const char* types[] = { "awful", "mediocre", "good", "random", "parity" };
+	ostream nowhere(nullptr); //a transcript that is formatted but never written
+	bool failed = false;
+	for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+	{
+		for (int mode = 0; mode < 3; mode++)
+		{
+			//mode 0 has no transcript, 1 a text transcript, 2 salvos
+			Game g(10, 10);
+			addStandardShips(g);
+			g.setTranscript(mode == 1 ? &nowhere : nullptr);
+			g.setSalvo(mode == 2);
+			AllocationWatcher watcher;
+			g.setObserver(&watcher);
+			for (int k = 0; k < nGames; k++)
+			{
+				seedRandom(k + 1);
+				Player* p1 = createPlayer(types[t], "First", g);
+				Player* p2 = createPlayer(types[t], "Second", g);
+				g.play(p1, p2, false);
+				delete p1;
+				delete p2;
+			}
+			const char* modes[] = { "", " with a transcript", " in salvos" };
+			cout << types[t] << modes[mode] << ": " << watcher.allocatingTurns << " of " << watcher.turns
+				<< " turns allocated (" << watcher.allocations << " allocations)" << endl;
+			if (watcher.allocatingTurns > 0)
+				failed = true;
+		}
+	}
+	return failed ? 1 : 0;
+}
+
+// Battleship endgame [--threads n] [file]
+// builds the endgame tables GoodPlayer looks up, by default in endgame.dat
+int runEndgameBuild(int argc, char* argv[])
+{
+	int nThreads = 0;
+	string path = "endgame.dat";
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			nThreads = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			path = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " endgame [--threads n] [file]" << endl;
+			return 1;
+		}
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	if (!EndgameTable::generate(path, nThreads))
+	{
+		cout << "Could not write " << path << endl;
+		return 1;
+	}
+	cout << "Wrote the endgame tables to " << path << " in " << formatSeconds(secondsSince(start)) << "." << endl;
+	return 0;
+}
+
+int main(int argc, char* argv[])
 {
 	const int NTRIALS = 10;
 
+	if (argc > 1 && strcmp(argv[1], "sweep") == 0)
+		return runSweep(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "analyze") == 0)
+		return runAnalyze(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "allocs") == 0)
+		return runAllocationCheck(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "endgame") == 0)
+		return runEndgameBuild(argc, argv);
+	// Built by "endgame"; without it GoodPlayer counts its endgames every move
+	EndgameTable::instance().open("endgame.dat");
+
+	if (argc > 1 && strcmp(argv[1], "diff") == 0)
+		return runDifferential(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "match") == 0)
+		return runMatch(argc, argv);
+	if (argc > 2 && strcmp(argv[1], "worker") == 0)
+		return runShardWorker(argv[2], cin, cout);
+	if (argc > 1 && strcmp(argv[1], "view") == 0)
+		return runViewer(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "layouts") == 0)
+		return runLayouts(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "tune") == 0)
+		return runTune(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "csv") == 0)
+		return runCsvExport(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "corpus") == 0)
+		return runCorpus(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		return runBench(argc, argv);
+
+	// Opponent shot statistics carry over between runs in this file
+	if (!ShotStore::instance().open("shotstore.dat"))
+		cout << "Could not open shotstore.dat; opponent shots will not be saved." << endl;
+	if (!LayoutStore::instance().open("layouts.dat"))
+		cout << "Could not open layouts.dat; opponent layouts will not be saved." << endl;
+
 	cout << "Select one of these choices for an example of the game:" << endl;
 	cout << "  1.  A mini-game between two mediocre players" << endl;
 	cout << "  2.  A good player against a human player" << endl;
@@ -25,6 +911,7 @@ int main()
 		<< "-game match between a mediocre and an awful player, with no pauses"
 		<< endl;
 	cout << "  4. A " << NTRIALS << "-game match between a good player and a mediocre player, with no pauses" << endl;
+	cout << "  5. A " << NTRIALS << "-game match between an adaptive player and a good player, with no pauses" << endl;
 	cout << "Enter your choice: ";
 	string line;
 	getline(cin, line);
@@ -94,6 +981,26 @@ int main()
 		cout << "The good player won " << nGoodWins << " out of "
 			<< NTRIALS << " games." << endl;
 	}
+	else if (line[0] == '5')
+	{
+		int nAdaptiveWins = 0;
+		for (int k = 1; k <= NTRIALS; k++)
+		{
+			cout << "============================= Game " << k
+				<< " =============================" << endl;
+			Game g(10, 10);
+			addStandardShips(g);
+			Player* p1 = createPlayer("adaptive", "Adaptive Ada", g);
+			Player* p2 = createPlayer("good", "Good Gary", g);
+			Player* winner = (k % 2 == 1 ? g.play(p1, p2, false) : g.play(p2, p1, false));
+			if (winner == p1)
+				nAdaptiveWins++;
+			delete p1;
+			delete p2;
+		}
+		cout << "The adaptive player won " << nAdaptiveWins << " out of "
+			<< NTRIALS << " games." << endl;
+	}
 	else
 	{
 		cout << "That's not one of the choices." << endl;